@@ -0,0 +1,207 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "benchconnection.h"
+#include "loadgenerator.h"
+
+#include <QTimer>
+
+static const int reconnectDelayMs = 100;
+
+BenchConnection::BenchConnection(const BenchOptions &opts, BenchStats *st, LoadGenerator *gen)
+    : QObject(gen),
+      options(opts),
+      stats(st),
+      generator(gen),
+      closedLoop(opts.rate <= 0)
+{
+    socket = new QTcpSocket(this);
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(socket, &QTcpSocket::connected, this, &BenchConnection::connected);
+    connect(socket, &QTcpSocket::readyRead, this, &BenchConnection::readResponses);
+    connect(socket, &QTcpSocket::disconnected, this, &BenchConnection::disconnected);
+    connect(socket, &QTcpSocket::errorOccurred, this, &BenchConnection::socketError);
+
+    QString path = opts.url.path(QUrl::FullyEncoded);
+    if (path.isEmpty()) {
+        path = "/";
+    }
+    if (opts.url.hasQuery()) {
+        path += '?' + opts.url.query(QUrl::FullyEncoded);
+    }
+    request = "GET " + path.toLatin1() + " HTTP/1.1\r\n"
+              "Host: " + opts.url.authority().toLatin1() + "\r\n" +
+              (opts.keepAlive ? QByteArray() : QByteArray("Connection: close\r\n")) +
+              "\r\n";
+}
+
+void BenchConnection::start()
+{
+    running = true;
+    connectToServer();
+}
+
+void BenchConnection::stop()
+{
+    running = false;
+    backlog.clear();
+    inFlight.clear();
+    socket->abort();
+}
+
+void BenchConnection::enqueue(qint64 dueNs)
+{
+    backlog.push_back(dueNs);
+    sendPending();
+}
+
+void BenchConnection::connected()
+{
+    if (closedLoop && backlog.empty()) {
+        for (int i = 0; i < options.pipeline; ++i) {
+            backlog.push_back(generator->now());
+        }
+    }
+    sendPending();
+}
+
+void BenchConnection::readResponses()
+{
+    buffer.append(socket->readAll());
+
+    qsizetype pos = 0;
+    while (running && socket->state() == QAbstractSocket::ConnectedState) {
+        if (bodyRemaining < 0) {
+            qsizetype end = buffer.indexOf("\r\n\r\n", pos);
+            if (end < 0) {
+                break;
+            }
+
+            QByteArray head = buffer.mid(pos, end - pos);
+            if (!head.startsWith("HTTP/1.")) {
+                ++stats->errors;
+                socket->abort();
+                buffer.clear();
+                return;
+            }
+            status = head.mid(9, 3).toInt();
+            bodyRemaining = 0;
+            const QList<QByteArray> lines = head.split('\n');
+            for (const QByteArray& line : lines) {
+                if (line.toLower().startsWith("content-length:")) {
+                    bodyRemaining = line.mid(15).trimmed().toLongLong();
+                }
+            }
+            stats->bytes += static_cast<quint64>(end + 4 - pos);
+            pos = end + 4;
+        }
+
+        qsizetype available = buffer.size() - pos;
+        if (available < bodyRemaining) {
+            bodyRemaining -= available;
+            stats->bytes += static_cast<quint64>(available);
+            pos = buffer.size();
+            break;
+        }
+        pos += bodyRemaining;
+        stats->bytes += static_cast<quint64>(bodyRemaining);
+        bodyRemaining = -1;
+        completeResponse();
+    }
+    buffer.remove(0, pos);
+}
+
+void BenchConnection::disconnected()
+{
+    // Requests without a response count as errors
+    stats->errors += inFlight.size();
+    inFlight.clear();
+    buffer.clear();
+    bodyRemaining = -1;
+
+    if (running) {
+        connectToServer();
+    }
+}
+
+void BenchConnection::socketError(QAbstractSocket::SocketError error)
+{
+    if (error == QAbstractSocket::RemoteHostClosedError || !running) {
+        return;
+    }
+    ++stats->errors;
+    stats->errors += inFlight.size();
+    inFlight.clear();
+    socket->abort();
+    QTimer::singleShot(reconnectDelayMs, this, [this]() {
+        if (running && socket->state() == QAbstractSocket::UnconnectedState) {
+            connectToServer();
+        }
+    });
+}
+
+void BenchConnection::connectToServer()
+{
+    socket->connectToHost(options.url.host(), static_cast<quint16>(options.url.port(80)));
+}
+
+void BenchConnection::sendPending()
+{
+    if (socket->state() != QAbstractSocket::ConnectedState) {
+        return;
+    }
+
+    int depth = options.keepAlive ? options.pipeline : 1;
+    qint64 nowNs = generator->now();
+    while (!backlog.empty() && static_cast<int>(inFlight.size()) < depth) {
+        inFlight.push_back({backlog.front(), nowNs});
+        backlog.pop_front();
+        socket->write(request);
+    }
+}
+
+void BenchConnection::completeResponse()
+{
+    if (inFlight.empty()) {
+        ++stats->errors;
+        return;
+    }
+
+    qint64 nowNs = generator->now();
+    InFlight done = inFlight.front();
+    inFlight.pop_front();
+
+    ++stats->responses;
+    ++stats->statusCodes[status];
+    stats->corrected.record(static_cast<quint64>(nowNs - done.dueNs) / 1000);
+    stats->uncorrected.record(static_cast<quint64>(nowNs - done.sentNs) / 1000);
+
+    if (closedLoop) {
+        backlog.push_back(nowNs);
+    }
+
+    if (!options.keepAlive) {
+        // The next request goes over a new connection
+        socket->disconnectFromHost();
+        return;
+    }
+    sendPending();
+}
@@ -0,0 +1,77 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BENCHCONNECTION_H
+#define BENCHCONNECTION_H
+
+#include <QObject>
+#include <QTcpSocket>
+
+#include <deque>
+
+struct BenchOptions;
+struct BenchStats;
+class LoadGenerator;
+
+// One client connection. Requests wait in a backlog until the connection is
+// up and has fewer than the pipeline depth in flight.
+class BenchConnection : public QObject
+{
+    Q_OBJECT
+
+public:
+    BenchConnection(const BenchOptions& opts, BenchStats* stats, LoadGenerator* gen);
+
+    void start();
+    void stop();
+    void enqueue(qint64 dueNs);
+
+private slots:
+    void connected();
+    void readResponses();
+    void disconnected();
+    void socketError(QAbstractSocket::SocketError error);
+
+private:
+    struct InFlight {
+        qint64 dueNs;
+        qint64 sentNs;
+    };
+
+    void connectToServer();
+    void sendPending();
+    void completeResponse();
+
+    const BenchOptions& options;
+    BenchStats* stats;
+    LoadGenerator* generator;
+    QTcpSocket* socket;
+    QByteArray request;
+    QByteArray buffer;
+    std::deque<qint64> backlog;
+    std::deque<InFlight> inFlight;
+    qint64 bodyRemaining = -1;
+    int status = 0;
+    bool closedLoop;
+    bool running = false;
+};
+
+#endif // BENCHCONNECTION_H
@@ -0,0 +1,94 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "loadgenerator.h"
+#include "benchconnection.h"
+
+#include <cmath>
+
+LoadGenerator::LoadGenerator(const BenchOptions &opts, QObject *parent)
+    : QObject(parent),
+      options(opts)
+{
+    rateTimer.setTimerType(Qt::PreciseTimer);
+    rateTimer.setInterval(1);
+    connect(&rateTimer, &QTimer::timeout, this, &LoadGenerator::scheduleDue);
+
+    for (int i = 0; i < options.connections; ++i) {
+        connections.append(new BenchConnection(options, &benchStats, this));
+    }
+}
+
+void LoadGenerator::start()
+{
+    clock.start();
+    startNs = now();
+    running = true;
+
+    for (BenchConnection* connection : std::as_const(connections)) {
+        connection->start();
+    }
+    if (options.rate > 0) {
+        rateTimer.start();
+    }
+    QTimer::singleShot(options.durationSec * 1000, Qt::PreciseTimer, this, &LoadGenerator::stop);
+}
+
+const BenchStats &LoadGenerator::stats() const
+{
+    return benchStats;
+}
+
+double LoadGenerator::elapsedSec() const
+{
+    return static_cast<double>((running ? now() : stopNs) - startNs) / 1e9;
+}
+
+qint64 LoadGenerator::now() const
+{
+    return clock.nsecsElapsed();
+}
+
+void LoadGenerator::scheduleDue()
+{
+    // Request k is due at start + k / rate, whether or not the previous
+    // ones have been answered
+    double intervalNs = 1e9 / options.rate;
+    quint64 due = static_cast<quint64>(std::floor(static_cast<double>(now() - startNs) / intervalNs)) + 1;
+    while (benchStats.scheduled < due) {
+        qint64 dueNs = startNs + static_cast<qint64>(static_cast<double>(benchStats.scheduled) * intervalNs);
+        BenchConnection* connection = connections.at(static_cast<int>(benchStats.scheduled %
+                                                                       static_cast<quint64>(connections.size())));
+        connection->enqueue(dueNs);
+        ++benchStats.scheduled;
+    }
+}
+
+void LoadGenerator::stop()
+{
+    stopNs = now();
+    running = false;
+    rateTimer.stop();
+    for (BenchConnection* connection : std::as_const(connections)) {
+        connection->stop();
+    }
+    emit finished();
+}
@@ -0,0 +1,89 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QTimer>
+#include <QUrl>
+
+#include "../core/web/latencyhistogram.h"
+
+class BenchConnection;
+
+struct BenchOptions
+{
+    QUrl url;
+    int connections = 10;
+    int pipeline = 1;
+    int durationSec = 10;
+    double rate = 0; // requests per second over all connections, 0 is closed loop
+    bool keepAlive = true;
+};
+
+struct BenchStats
+{
+    // Open loop: measured from the moment the request was due, so that a
+    // stalled server is charged for the requests it delayed (coordinated
+    // omission). Closed loop: same as uncorrected.
+    LatencyHistogram corrected;
+    LatencyHistogram uncorrected;
+    QMap<int, quint64> statusCodes;
+    quint64 responses = 0;
+    quint64 errors = 0;
+    quint64 bytes = 0;
+    quint64 scheduled = 0;
+};
+
+class LoadGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    LoadGenerator(const BenchOptions& opts, QObject* parent = nullptr);
+
+    void start();
+    const BenchStats& stats() const;
+    double elapsedSec() const;
+    qint64 now() const; // ns
+
+signals:
+    void finished();
+
+private slots:
+    void scheduleDue();
+    void stop();
+
+private:
+    BenchOptions options;
+    BenchStats benchStats;
+    QElapsedTimer clock;
+    QTimer rateTimer;
+    QList<BenchConnection*> connections;
+    qint64 startNs = 0;
+    qint64 stopNs = 0;
+    bool running = false;
+};
+
+#endif // LOADGENERATOR_H
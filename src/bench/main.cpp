@@ -0,0 +1,171 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+#include <iostream>
+#include <iomanip>
+
+#include "loadgenerator.h"
+#include "../core/web/webserverdiag.h"
+
+static void printLatency(const char* title, const LatencyHistogram& histogram)
+{
+    std::cout << title << "\n";
+    for (double p : {50.0, 90.0, 99.0, 99.9, 100.0}) {
+        std::cout << "  p" << std::left << std::setw(6) << p << std::right << std::setw(12)
+                  << std::fixed << std::setprecision(3)
+                  << static_cast<double>(histogram.percentile(p)) / 1000.0 << " ms\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Web Monitoring Diagnistics load generator");
+    parser.addHelpOption();
+    parser.addPositionalArgument("url", "Target, e.g. http://127.0.0.1:8080/ (default with --in-process)");
+    QCommandLineOption connectionsOption({"c", "connections"}, "Number of connections", "count", "10");
+    parser.addOption(connectionsOption);
+    QCommandLineOption durationOption({"d", "duration"}, "Test duration in seconds", "sec", "10");
+    parser.addOption(durationOption);
+    QCommandLineOption rateOption({"r", "rate"},
+        "Open loop: fixed total request rate per second. 0 sends the next request "
+        "as soon as a response arrives", "rps", "0");
+    parser.addOption(rateOption);
+    QCommandLineOption pipelineOption("pipeline", "Requests in flight per connection", "depth", "1");
+    parser.addOption(pipelineOption);
+    QCommandLineOption noKeepAliveOption("no-keep-alive", "New connection for every request");
+    parser.addOption(noKeepAliveOption);
+    QCommandLineOption inProcessOption("in-process", "Start a server in this process and test it");
+    parser.addOption(inProcessOption);
+    QCommandLineOption portOption("p", "Port of the in-process server", "port", "18080");
+    parser.addOption(portOption);
+    QCommandLineOption workersOption({"w", "workers"}, "Worker threads of the in-process server", "count", "1");
+    parser.addOption(workersOption);
+    QCommandLineOption bodySizeOption("body-size", "Response body of the in-process server", "bytes", "1024");
+    parser.addOption(bodySizeOption);
+    QCommandLineOption delayOption("delay", "Response delay distribution of the in-process server", "spec");
+    parser.addOption(delayOption);
+    parser.process(a);
+
+    BenchOptions options;
+    bool connectionsChk = false;
+    bool durationChk = false;
+    bool rateChk = false;
+    bool pipelineChk = false;
+    options.connections = parser.value(connectionsOption).toInt(&connectionsChk);
+    options.durationSec = parser.value(durationOption).toInt(&durationChk);
+    options.rate = parser.value(rateOption).toDouble(&rateChk);
+    options.pipeline = parser.value(pipelineOption).toInt(&pipelineChk);
+    options.keepAlive = !parser.isSet(noKeepAliveOption);
+    if (!connectionsChk || options.connections < 1 || !durationChk || options.durationSec < 1 ||
+        !rateChk || options.rate < 0 || !pipelineChk || options.pipeline < 1) {
+        std::cout << "Invalid connections, duration, rate or pipeline value\n";
+        return 1;
+    }
+
+    WebServerDiag server;
+    if (parser.isSet(inProcessOption)) {
+        bool portChk = false;
+        bool workersChk = false;
+        bool bodySizeChk = false;
+        ushort port = parser.value(portOption).toUShort(&portChk);
+        int workers = parser.value(workersOption).toInt(&workersChk);
+        int bodySize = parser.value(bodySizeOption).toInt(&bodySizeChk);
+        if (!portChk || !workersChk || workers < 1 || !bodySizeChk || bodySize < 0) {
+            std::cout << "Invalid port, workers or body size value\n";
+            return 1;
+        }
+
+        server.setHostname("127.0.0.1");
+        server.setListenPortNumber(port);
+        server.setWorkerCount(workers);
+        server.setRespPage(PageData::fromBytes(QByteArray(bodySize, 'x')));
+        if (parser.isSet(delayOption)) {
+            LatencyDistribution delay;
+            QString error;
+            if (!LatencyDistribution::parse(parser.value(delayOption), &delay, &error)) {
+                std::cout << "Invalid delay distribution: " << error.toStdString() << "\n";
+                return 1;
+            }
+            server.setDelayDistribution(delay);
+            server.enableResponseDelay(true);
+        }
+        server.startServer(true);
+        if (server.getWebServerData().errorHasOccurred()) {
+            std::cout << "Failed to start the in-process server\n";
+            return 1;
+        }
+        options.url = QUrl(QString("http://127.0.0.1:%1/").arg(port));
+    }
+
+    if (!parser.positionalArguments().isEmpty()) {
+        options.url = QUrl(parser.positionalArguments().constFirst());
+    }
+    if (!options.url.isValid() || options.url.scheme() != "http" || options.url.host().isEmpty()) {
+        std::cout << "Target URL is missing or not http://\n\n";
+        parser.showHelp(1);
+    }
+
+    std::cout << "Running " << options.durationSec << "s test @ " << options.url.toString().toStdString()
+              << "\n  " << options.connections << " connections, pipeline " << options.pipeline
+              << (options.keepAlive ? ", keep-alive" : ", no keep-alive");
+    if (options.rate > 0) {
+        std::cout << ", open loop at " << options.rate << " req/s";
+    } else {
+        std::cout << ", closed loop";
+    }
+    std::cout << "\n" << std::flush;
+
+    LoadGenerator generator(options);
+    QObject::connect(&generator, &LoadGenerator::finished, &a, [&]() {
+        const BenchStats& stats = generator.stats();
+        double seconds = generator.elapsedSec();
+
+        std::cout << "\n" << stats.responses << " responses in " << std::fixed << std::setprecision(2)
+                  << seconds << "s, " << stats.errors << " errors\n";
+        std::cout << "Throughput: " << static_cast<double>(stats.responses) / seconds << " req/s, "
+                  << static_cast<double>(stats.bytes) / seconds / 1048576.0 << " MiB/s\n";
+        if (options.rate > 0 && stats.scheduled > stats.responses + stats.errors) {
+            std::cout << "Unanswered at the end: " << stats.scheduled - stats.responses - stats.errors << "\n";
+        }
+        std::cout << "Status codes:";
+        for (auto it = stats.statusCodes.cbegin(); it != stats.statusCodes.cend(); ++it) {
+            std::cout << " " << it.key() << "=" << it.value();
+        }
+        std::cout << "\n";
+
+        if (options.rate > 0) {
+            printLatency("Latency, corrected for coordinated omission:", stats.corrected);
+            printLatency("Latency, service time only:", stats.uncorrected);
+        } else {
+            printLatency("Latency:", stats.uncorrected);
+        }
+        QCoreApplication::exit(stats.responses > 0 ? 0 : 1);
+    });
+    generator.start();
+
+    return a.exec();
+}
@@ -32,9 +32,12 @@
 
 #include <iostream>
 
-CommandLineView::CommandLineView(QObject *parent)
+CommandLineView::CommandLineView(bool interactive, QObject *parent)
     : QObject{parent}
 {
+    if (!interactive) {
+        return;
+    }
     commandReader = new CommandReader(this);
     connect(commandReader, &CommandReader::newToggleCommandReady,
             this, &CommandLineView::readToggleCommand);
@@ -44,6 +47,9 @@ CommandLineView::CommandLineView(QObject *parent)
 
 CommandLineView::~CommandLineView()
 {
+    if (!commandReader) {
+        return;
+    }
     commandReader->quit();
     commandReader->wait(1000);
     if (commandReader->isRunning()) {
@@ -84,6 +90,16 @@ void CommandLineView::setResponseTime(int val)
     respTime = val;
 }
 
+void CommandLineView::setDelayDistribution(const QString &spec)
+{
+    delayDistribution = spec;
+}
+
+void CommandLineView::showLatency(const LatencySummary &summary)
+{
+    latency = summary;
+}
+
 void CommandLineView::setHostname(const QString &val)
 {
     hostname = val;
@@ -102,6 +118,10 @@ void CommandLineView::setPort(ushort val)
 void CommandLineView::showView()
 {
     showState();
+    if (!commandReader) {
+        std::cout.flush();
+        return;
+    }
 
     std::cout << "\n === Web Monitoring Diagnistics ===\n";
     std::cout << "\t 1 - On/Off port listening\n";
@@ -113,6 +133,8 @@ void CommandLineView::showView()
     std::cout << "\t 7 - Set custom web page\n";
     std::cout << "\t 8 - Set endpoint path\n";
     std::cout << "\t 9 - Show state\n";
+    std::cout << "\t d - Set response delay distribution\n";
+    std::cout << "\t c - Set cache validation\n";
     std::cout << "\t q - Quit\n";
     commandReader->start();
 }
@@ -132,9 +154,16 @@ void CommandLineView::setReturnEmptyPage(bool val)
     emptyPage = val;
 }
 
-void CommandLineView::appendLog(const QString &str)
+void CommandLineView::setCacheValidation(const QString &mode)
+{
+    cacheValidation = mode;
+}
+
+void CommandLineView::appendLog(const QList<LogLine> &lines)
 {
-    std::cout << " " + str.toStdString() + "\n";
+    for (const LogLine& line : lines) {
+        std::cout << " " + line.text.toStdString() + "\n";
+    }
     std::cout.flush();
 }
 
@@ -196,8 +225,13 @@ void CommandLineView::showState()
     str.append(QString(" Response delay: ") + QVariant(respDelay).toString() + '\n');
     str.append(QString(" Return empty page: " + QVariant(emptyPage).toString()) + '\n');
     str.append(QString(" Response time: " + QString::number(respTime)) + "(ms)\n");
+    str.append(QString(" Delay distribution: " + delayDistribution + '\n'));
+    str.append(QString(" Latency (ms): p50 %1, p95 %2, p99 %3, max %4, %5 requests\n")
+                   .arg(latency.p50Us / 1000.0).arg(latency.p95Us / 1000.0)
+                   .arg(latency.p99Us / 1000.0).arg(latency.maxUs / 1000.0).arg(latency.count));
     str.append(QString(" Response code: " + QString::number(respCode)) + '\n');
     str.append(QString(" Web page: ") + (webPageStr.isEmpty() ? "none" : webPageStr) + '\n');
+    str.append(QString(" Cache validation: " + cacheValidation + '\n'));
 
     std::cout << str.toStdString();
 }
@@ -34,7 +34,9 @@ class CommandLineView : public QObject, public IView
     Q_OBJECT
 
 public:
-    CommandLineView(QObject *parent = nullptr);
+    // Without interaction nothing is read from stdin and no menu is shown,
+    // the view only prints the state and the log
+    explicit CommandLineView(bool interactive = true, QObject *parent = nullptr);
     ~CommandLineView();
 
     void setPresenter(IPresenter* p) override;
@@ -43,6 +45,8 @@ public:
     void enableResponding(bool val) override;
     void setResponseCode(int val) override;
     void setResponseTime(int val) override;
+    void setDelayDistribution(const QString& spec) override;
+    void showLatency(const LatencySummary& summary) override;
     void setHostname(const QString &val) override;
     void setEndpointPath(const QString& val) override;
     void setPort(ushort val) override;
@@ -50,7 +54,8 @@ public:
     void enableResponseDelay(bool val) override;
     void setWebPageName(const QString &name) override;
     void setReturnEmptyPage(bool val) override;
-    void appendLog(const QString &str) override;
+    void setCacheValidation(const QString& mode) override;
+    void appendLog(const QList<LogLine>& lines) override;
 
 signals:
     void quitApp();
@@ -64,7 +69,7 @@ private:
     void showState();
 
     IPresenter* presenter;
-    CommandReader* commandReader;
+    CommandReader* commandReader = nullptr;
 
     bool listenPort = false;
     bool httpResp = false;
@@ -76,6 +81,9 @@ private:
     QString hostname;
     QString endpointPath;
     QString webPageStr;
+    QString delayDistribution;
+    QString cacheValidation;
+    LatencySummary latency;
 };
 
 #endif // COMMANDLINEVIEW_H
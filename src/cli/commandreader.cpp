@@ -24,6 +24,8 @@
 #include "commands/changeresptime.h"
 #include "commands/changehttpcode.h"
 #include "commands/changewebpage.h"
+#include "commands/changedelaydistribution.h"
+#include "commands/changecachevalidation.h"
 
 #include <iostream>
 
@@ -101,6 +103,22 @@ void CommandReader::run()
         chgPath->setEndpointPath(res);
         cmd = chgPath;
     }
+    case 'd':
+    case 'D': {
+        QString res = readLine("Enter delay distribution (e.g. lognormal:mu=4,sigma=0.5): ");
+        ChangeDelayDistribution* chgDist = new ChangeDelayDistribution;
+        chgDist->setSpec(res);
+        cmd = chgDist;
+        break;
+    }
+    case 'c':
+    case 'C': {
+        QString res = readLine("Enter cache validation (normal, changed or unchanged): ");
+        ChangeCacheValidation* chgCache = new ChangeCacheValidation;
+        chgCache->setMode(res);
+        cmd = chgCache;
+        break;
+    }
     default:
         break;
     }
@@ -115,7 +133,12 @@ void CommandReader::run()
 
 QString CommandReader::readPath() const
 {
-    std::cout << "Enter path: ";
+    return readLine("Enter path: ");
+}
+
+QString CommandReader::readLine(const char *prompt) const
+{
+    std::cout << prompt;
     std::cout.flush();
     std::string path;
     std::cin.ignore();
@@ -44,6 +44,7 @@ protected:
 
 private:
     QString readPath() const;
+    QString readLine(const char* prompt) const;
     QMutex mutex;
 };
 
@@ -25,13 +25,19 @@
 #include <iostream>
 
 #include "../core/serverpresenter.h"
+#include "../core/scenarioengine.h"
 #include "../core/web/webserverdiag.h"
+#include "../core/web/adminserver.h"
+#include "../core/web/accesslog.h"
+#include "../core/web/sizeutils.h"
+#include "../core/web/socketutils.h"
 #include "commands/icommand.h"
 #include "commandlineview.h"
 
 int main(int argc, char *argv[])
 {
     QCoreApplication a(argc, argv);
+    SocketUtils::ignoreSigPipe();
 
     qRegisterMetaType<QSharedPointer<ICommand>>("QSharedPointer<ICommand>");
 
@@ -42,10 +48,59 @@ int main(int argc, char *argv[])
     parser.addOption(hostnameOption);
     QCommandLineOption portOption("p", "Port", "Key for port");
     parser.addOption(portOption);
+    QCommandLineOption workersOption({"w", "workers"}, "Number of worker threads serving requests", "count", "1");
+    parser.addOption(workersOption);
+    QCommandLineOption parkCapacityOption("park-capacity",
+        "Maximum number of requests held per worker while HTTP response is disabled", "count", "10000");
+    parser.addOption(parkCapacityOption);
+    QCommandLineOption parkOverflowOption("park-overflow",
+        "What to do with requests beyond the capacity: reset, 503 or drop-oldest", "policy", "503");
+    parser.addOption(parkOverflowOption);
+    QCommandLineOption delayOption("delay",
+        "Response delay distribution, e.g. 50, uniform:min=10,max=200, normal:mean=100,stddev=20, "
+        "lognormal:mu=4,sigma=0.5, pareto:scale=20,shape=1.5 or empirical:file=latencies.txt", "spec");
+    parser.addOption(delayOption);
+    QCommandLineOption bandwidthOption("bandwidth",
+        "Bytes per second of every connection to the endpoint, k/M/G suffixes allowed", "rate");
+    parser.addOption(bandwidthOption);
+    QCommandLineOption faultsOption("faults",
+        "Percent of requests failing on purpose, e.g. 500=2,hang=1,reset=0.5,truncate=0.5", "plan");
+    parser.addOption(faultsOption);
+    QCommandLineOption tcpFaultOption("tcp-fault",
+        "Failure below HTTP: reset, no-read, pause-accept, close-after-headers or bounce", "mode", "none");
+    parser.addOption(tcpFaultOption);
+    QCommandLineOption scenarioOption("scenario", "Timeline of state changes replayed after the start", "file");
+    parser.addOption(scenarioOption);
+    QCommandLineOption seedOption("seed", "Seed for the response delay generators", "number");
+    parser.addOption(seedOption);
+    QCommandLineOption adminOption("admin", "Address of the admin server with /metrics and /control", "host:port");
+    parser.addOption(adminOption);
+    QCommandLineOption daemonOption("daemon", "Run without a terminal, controlled through /control of --admin");
+    parser.addOption(daemonOption);
+    QCommandLineOption remoteControlOption("remote-control",
+        "Serve /control on an admin address other hosts reach, without authentication");
+    parser.addOption(remoteControlOption);
+    QCommandLineOption pageControlOption("page-control", "Allow /control to serve any readable file as the page");
+    parser.addOption(pageControlOption);
+    QCommandLineOption accessLogOption("access-log", "File the served requests are appended to", "file");
+    parser.addOption(accessLogOption);
+    QCommandLineOption accessLogFormatOption("access-log-format",
+        "Access log format: clf, jsonl or binary", "format", "clf");
+    parser.addOption(accessLogFormatOption);
+    QCommandLineOption siteOption("site", "Serve every file of the directory under its relative path", "dir");
+    parser.addOption(siteOption);
+    QCommandLineOption cacheValidationOption("cache-validation",
+        "Answer to conditional requests: normal, changed (never 304) or unchanged (always 304)", "mode", "normal");
+    parser.addOption(cacheValidationOption);
+    Logger::addOptions(parser);
+    QCommandLineOption routesOption({"r", "routes"},
+        "JSON file with additional endpoints and their behavior", "file");
+    parser.addOption(routesOption);
     parser.process(a);
 
     QString hostname = parser.value(hostnameOption);
     QString port = parser.value(portOption);
+    QString workers = parser.value(workersOption);
 
     if (hostname.isEmpty()) {
         hostname = "127.0.0.1";
@@ -68,20 +123,169 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    CommandLineView view;
+    bool workersChk = false;
+    int workerCount = workers.toInt(&workersChk);
+    if (!workersChk || workerCount < 1) {
+        std::cout << "Invalid number of workers: " << workers.toStdString() << "\n";
+        return 1;
+    }
+
+    bool parkCapacityChk = false;
+    int parkCapacity = parser.value(parkCapacityOption).toInt(&parkCapacityChk);
+    if (!parkCapacityChk || parkCapacity < 0) {
+        std::cout << "Invalid park capacity: " << parser.value(parkCapacityOption).toStdString() << "\n";
+        return 1;
+    }
+
+    ParkOverflowPolicy parkPolicy;
+    if (!WebServerData::parseParkOverflowPolicy(parser.value(parkOverflowOption), &parkPolicy)) {
+        std::cout << "Invalid park overflow policy: " << parser.value(parkOverflowOption).toStdString() << "\n";
+        return 1;
+    }
+
+    CacheValidation cacheValidation;
+    if (!WebServerData::parseCacheValidation(parser.value(cacheValidationOption), &cacheValidation)) {
+        std::cout << "Invalid cache validation: " << parser.value(cacheValidationOption).toStdString() << "\n";
+        return 1;
+    }
+
+    LatencyDistribution delay;
+    if (parser.isSet(delayOption)) {
+        QString error;
+        if (!LatencyDistribution::parse(parser.value(delayOption), &delay, &error)) {
+            std::cout << "Invalid delay distribution: " << error.toStdString() << "\n";
+            return 1;
+        }
+    }
+
+    qint64 bandwidth = 0;
+    if (parser.isSet(bandwidthOption) && !SizeUtils::parseSize(parser.value(bandwidthOption), &bandwidth)) {
+        std::cout << "Invalid bandwidth: " << parser.value(bandwidthOption).toStdString() << "\n";
+        return 1;
+    }
+
+    FaultPlan faults;
+    if (parser.isSet(faultsOption)) {
+        QString error;
+        if (!FaultPlan::parse(parser.value(faultsOption), &faults, &error)) {
+            std::cout << "Invalid fault plan: " << error.toStdString() << "\n";
+            return 1;
+        }
+    }
+
+    TcpFault tcpFault;
+    if (!WebServerData::parseTcpFault(parser.value(tcpFaultOption), &tcpFault)) {
+        std::cout << "Invalid TCP fault: " << parser.value(tcpFaultOption).toStdString() << "\n";
+        return 1;
+    }
+
+    bool seedChk = false;
+    quint64 seed = parser.value(seedOption).toULongLong(&seedChk);
+    if (parser.isSet(seedOption) && !seedChk) {
+        std::cout << "Invalid seed: " << parser.value(seedOption).toStdString() << "\n";
+        return 1;
+    }
+
+    QHostAddress adminAddress;
+    quint16 adminPort = 0;
+    if (parser.isSet(adminOption) &&
+        !AdminServer::parseAddress(parser.value(adminOption), &adminAddress, &adminPort)) {
+        std::cout << "Invalid admin address: " << parser.value(adminOption).toStdString() << "\n";
+        return 1;
+    }
+    if (parser.isSet(daemonOption) && !parser.isSet(adminOption)) {
+        std::cout << "Daemon mode needs the admin server, set --admin\n";
+        return 1;
+    }
+    if (parser.isSet(daemonOption) && !adminAddress.isLoopback() && !parser.isSet(remoteControlOption)) {
+        std::cout << "Daemon mode on a non-loopback admin address needs --remote-control\n";
+        return 1;
+    }
+
+    AccessLog::Format accessLogFormat = AccessLog::Format::Clf;
+    if (!AccessLog::parseFormat(parser.value(accessLogFormatOption), &accessLogFormat)) {
+        std::cout << "Invalid access log format: " << parser.value(accessLogFormatOption).toStdString() << "\n";
+        return 1;
+    }
+    AccessLog accessLog;
+    if (parser.isSet(accessLogOption) && !accessLog.open(parser.value(accessLogOption), accessLogFormat)) {
+        std::cout << "Failed to open the access log " << parser.value(accessLogOption).toStdString() << "\n";
+        return 1;
+    }
+
+    CommandLineView view(!parser.isSet(daemonOption));
     WebServerDiag server;
+    if (parser.isSet(accessLogOption)) {
+        server.setAccessLog(&accessLog);
+    }
+    server.setWorkerCount(workerCount);
+    server.setParkLimit(parkCapacity, parkPolicy);
+    server.setBandwidthLimit(bandwidth);
+    server.setFaultPlan(faults);
+    server.setTcpFault(tcpFault);
+    if (seedChk) {
+        server.setSeed(seed);
+    }
+    if (parser.isSet(routesOption)) {
+        QString error;
+        if (!server.loadEndpoints(parser.value(routesOption), &error)) {
+            std::cout << error.toStdString() << "\n";
+            return 1;
+        }
+    }
+    AdminServer admin(&server);
+    if (parser.isSet(adminOption) && !admin.listen(adminAddress, adminPort)) {
+        std::cout << "Failed to start the admin server on " << parser.value(adminOption).toStdString() << "\n";
+        return 1;
+    }
     Logger logger(&view);
-    logger.setTextAsHtml(false);
+    QString logError;
+    if (!logger.applyOptions(parser, &logError)) {
+        std::cout << logError.toStdString() << "\n";
+        return 1;
+    }
     ServerPresenter presenter(&view, &server, &logger);
     presenter.hostnameChanged(hostname);
     presenter.listenPortChanged(port.toUShort());
+    if (parser.isSet(siteOption)) {
+        presenter.newSiteDirectorySelected(parser.value(siteOption));
+    }
+    if (parser.isSet(delayOption)) {
+        presenter.delayDistributionChanged(delay.toString());
+        presenter.enableResponseDelay(true);
+    }
+    presenter.cacheValidationChanged(WebServerData::cacheValidationName(cacheValidation));
+    admin.setPresenter(&presenter);
+    admin.setRemoteControl(parser.isSet(remoteControlOption));
+    admin.setPageControl(parser.isSet(pageControlOption));
+
+    ScenarioEngine scenario(&presenter);
+    if (parser.isSet(scenarioOption)) {
+        QString error;
+        if (!scenario.load(parser.value(scenarioOption), &error)) {
+            std::cout << error.toStdString() << "\n";
+            return 1;
+        }
+        QObject::connect(&scenario, &ScenarioEngine::stepExecuted, &logger,
+                         [&logger](const QString& description, double lateMs) {
+            logger.addHighlightedMessage(QString("Scenario: %1 (%2 ms late)").arg(description).arg(lateMs, 0, 'f', 3));
+        });
+        QObject::connect(&scenario, &ScenarioEngine::finished, &logger, [&logger]() {
+            logger.addHighlightedMessage("Scenario finished");
+        });
+    }
     presenter.startServer();
 
     QObject::connect(&view, &CommandLineView::quitApp, &a, &QCoreApplication::quit);
+    // Queued so that the answer to the request leaves first
+    QObject::connect(&admin, &AdminServer::quitRequested, &a, &QCoreApplication::quit, Qt::QueuedConnection);
 
     if (server.getWebServerData().errorHasOccurred()) {
         return 1;
     }
+    if (parser.isSet(scenarioOption)) {
+        scenario.start();
+    }
 
     return a.exec();
 }
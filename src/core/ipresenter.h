@@ -44,8 +44,11 @@ public slots:
     virtual void enableResponseDelay(bool val) = 0;
     virtual void setReturnEmptyPage(bool val) = 0;
     virtual void httpResponseTimeChanged(int val) = 0;
+    virtual void delayDistributionChanged(const QString& spec) = 0;
     virtual void returnCodeChanged(int val) = 0;
+    virtual void cacheValidationChanged(const QString& mode) = 0;
     virtual void newWebPageSelected(const QString& path) = 0;
+    virtual void newSiteDirectorySelected(const QString& path) = 0;
     virtual void serverErrorHasOccurred(const QString& str) = 0;
 
     virtual void reset() = 0;
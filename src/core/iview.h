@@ -23,6 +23,10 @@
 #define IVIEW_H
 
 #include <QString>
+#include <QList>
+
+#include "web/latencyhistogram.h"
+#include "logline.h"
 
 class IPresenter;
 
@@ -36,6 +40,8 @@ public:
     virtual void enableResponding(bool val) = 0;
     virtual void setResponseCode(int val) = 0;
     virtual void setResponseTime(int val) = 0;
+    virtual void setDelayDistribution(const QString& spec) = 0;
+    virtual void showLatency(const LatencySummary& summary) = 0;
     virtual void setHostname(const QString& val) = 0;
     virtual void setEndpointPath(const QString& val) = 0;
     virtual void setPort(ushort val) = 0;
@@ -43,7 +49,8 @@ public:
     virtual void enableResponseDelay(bool val) = 0;
     virtual void setWebPageName(const QString& name) = 0;
     virtual void setReturnEmptyPage(bool val) = 0;
-    virtual void appendLog(const QString& str) = 0;
+    virtual void setCacheValidation(const QString& mode) = 0;
+    virtual void appendLog(const QList<LogLine>& lines) = 0;
 };
 
 #endif // IVIEW_H
@@ -23,6 +23,8 @@
 #define IWEBSERVERDIAG_H
 
 #include "web/webserverdata.h"
+#include "web/latencyhistogram.h"
+#include "web/staticsiteindex.h"
 
 class IPresenter;
 
@@ -31,7 +33,7 @@ class IWebServerDiag
 public:
     virtual ~IWebServerDiag() = default;
 
-    virtual WebServerData getWebServerData() const = 0;
+    virtual const WebServerData& getWebServerData() const = 0;
 
     virtual void startServer(bool val) = 0;
     virtual void setPresenter(IPresenter* p) = 0;
@@ -39,14 +41,19 @@ public:
     virtual void enableHttpResponse(bool val) = 0;
     virtual void enableResponseDelay(bool val) = 0;
     virtual void httpResponseTimeChanged(int val) = 0;
+    virtual void setDelayDistribution(const LatencyDistribution& dist) = 0;
+    virtual LatencySummary getLatencySummary() const = 0;
 
     virtual void setServerData(const WebServerData& data) = 0;
     virtual void setListenPortNumber(ushort port) = 0;
     virtual void setHostname(const QString& hostname) = 0;
     virtual void setEndpointPath(const QString& path) = 0;
     virtual void setResponseCode(int val) = 0;
-    virtual void setRespPage(const QString &newRespPage) = 0;
+    virtual void setRespPage(const std::shared_ptr<const PageData>& newRespPage) = 0;
     virtual void setReturnEmptyPage(bool emptyPage) = 0;
+    virtual void setCacheValidation(CacheValidation mode) = 0;
+    // nullptr goes back to serving the page
+    virtual void setStaticSite(const std::shared_ptr<const StaticSiteIndex>& site) = 0;
 };
 
 #endif // IWEBSERVERDIAG_H
@@ -22,55 +22,224 @@
 #include "logger.h"
 #include "iview.h"
 
+#include <QThread>
 #include <QDateTime>
+#include <QCommandLineParser>
 
-Logger::Logger(IView *v) : view(v)
+#include <iterator>
+
+static const char* const levelNames[] = {"debug", "info", "notice", "warning", "error"};
+
+static const char* levelName(LogLevel level)
 {
+    return levelNames[static_cast<int>(level)];
+}
+
+Logger::Logger(IView *v, QObject *parent)
+    : QObject(parent),
+      view(v)
+{
+    deliveryTimer.setInterval(deliveryIntervalMs);
+    connect(&deliveryTimer, &QTimer::timeout, this, &Logger::deliver);
+
+    formatter.reset(QThread::create([this]() {
+        formatLoop();
+    }));
+    formatter->setObjectName("wmd-log");
+    formatter->start(QThread::LowPriority);
+}
 
+Logger::~Logger()
+{
+    flush();
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+    }
+    wakeup.wakeAll();
+    formatter->wait();
 }
 
 void Logger::addMessage(const QString &str)
 {
-    addText(str);
+    add(LogLevel::Info, str);
 }
 
 void Logger::addHighlightedMessage(const QString &str)
 {
-    addText(str, "0000FF");
+    add(LogLevel::Notice, str);
 }
 
 void Logger::addError(const QString &str)
 {
-    addText(str, "FF0000");
+    add(LogLevel::Error, str);
 }
 
-void Logger::setTextAsHtml(bool val)
+void Logger::add(LogLevel level, const QString &str)
 {
-    textAsHtml = val;
+    if (level < minLevel) {
+        return;
+    }
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    {
+        QMutexLocker locker(&mutex);
+        pending.append({now, level, str});
+    }
+    wakeup.wakeOne();
+
+    if (viewEnabled && !deliveryTimer.isActive()) {
+        deliveryTimer.start();
+    }
 }
 
-void Logger::addText(const QString &str, const QString &color)
+void Logger::setLevel(LogLevel val)
 {
-    QString res;
-    res.append(QDateTime::currentDateTime().toString() + ": ");
+    minLevel = val;
+}
 
-    if (!textAsHtml) {
-        res.append(str);
-        view->appendLog(res);
-        return;
+void Logger::setViewEnabled(bool val)
+{
+    QMutexLocker locker(&mutex);
+    viewEnabled = val;
+}
+
+bool Logger::setFile(const QString &fileName)
+{
+    QMutexLocker locker(&fileMutex);
+    file.close();
+    if (fileName.isEmpty()) {
+        return true;
+    }
+    file.setFileName(fileName);
+    return file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+}
+
+void Logger::flush()
+{
+    {
+        QMutexLocker locker(&mutex);
+        while (!pending.isEmpty() || formatting) {
+            idle.wait(&mutex);
+        }
+    }
+    deliver();
+}
+
+void Logger::addOptions(QCommandLineParser &parser)
+{
+    parser.addOption(QCommandLineOption("log-level",
+        "Lowest level logged: debug, info, notice, warning or error", "level", "info"));
+    parser.addOption(QCommandLineOption("log-file", "File the log is appended to", "file"));
+    parser.addOption(QCommandLineOption("no-view-log", "Do not show the log in the application"));
+}
+
+bool Logger::applyOptions(const QCommandLineParser &parser, QString *error)
+{
+    LogLevel level;
+    if (!parseLevel(parser.value("log-level"), &level)) {
+        *error = "Invalid log level: " + parser.value("log-level");
+        return false;
     }
+    setLevel(level);
 
-    QString htmlStr;
-    if (!color.isEmpty()) {
-        htmlStr = "<font color=\"#" + color + "\">";
+    if (parser.isSet("log-file") && !setFile(parser.value("log-file"))) {
+        *error = "Cannot open the log file " + parser.value("log-file");
+        return false;
     }
+    setViewEnabled(!parser.isSet("no-view-log"));
+    return true;
+}
 
-    htmlStr.append("<b>").append(res).append("</b> ");
-    htmlStr.append(str).append("<br/>");
-    if (!color.isEmpty()) {
-        htmlStr.append("</font>");
+bool Logger::parseLevel(const QString &str, LogLevel *level)
+{
+    for (int i = 0; i < static_cast<int>(std::size(levelNames)); ++i) {
+        if (str == QLatin1String(levelNames[i])) {
+            *level = static_cast<LogLevel>(i);
+            return true;
+        }
     }
+    return false;
+}
+
+void Logger::formatLoop()
+{
+    QMutexLocker locker(&mutex);
+    while (true) {
+        while (pending.isEmpty() && !stopping) {
+            wakeup.wait(&mutex);
+        }
+        if (pending.isEmpty()) {
+            break;
+        }
+
+        QList<Entry> entries;
+        entries.swap(pending);
+        formatting = true;
+        bool toView = viewEnabled;
+        locker.unlock();
 
-    view->appendLog(htmlStr);
+        QList<LogLine> lines;
+        QByteArray fileData;
+        {
+            QMutexLocker fileLocker(&fileMutex);
+            bool toFile = file.isOpen();
+            for (const Entry& entry : std::as_const(entries)) {
+                const QString& time = timestamp(entry.timeMs);
+                if (toView) {
+                    lines.append({format(entry, time), entry.level});
+                }
+                if (toFile) {
+                    fileData += (time + " [" + levelName(entry.level) + "] " + entry.text + '\n').toUtf8();
+                }
+            }
+            if (toFile) {
+                file.write(fileData);
+                file.flush();
+            }
+        }
+
+        locker.relock();
+        formatted.append(lines);
+        formatting = false;
+        idle.wakeAll();
+    }
 }
 
+void Logger::deliver()
+{
+    QList<LogLine> lines;
+    bool idleNow;
+    {
+        QMutexLocker locker(&mutex);
+        lines.swap(formatted);
+        idleNow = pending.isEmpty() && !formatting;
+    }
+
+    if (!lines.isEmpty()) {
+        view->appendLog(lines);
+    } else if (idleNow) {
+        deliveryTimer.stop();
+    }
+}
+
+const QString &Logger::timestamp(qint64 timeMs)
+{
+    if (timeMs == cachedMs) {
+        return cachedTime;
+    }
+
+    // Within the same second only the milliseconds change
+    if (cachedMs >= 0 && timeMs / 1000 == cachedMs / 1000) {
+        cachedTime.replace(cachedTime.size() - 3, 3, QString::number(timeMs % 1000).rightJustified(3, '0'));
+    } else {
+        cachedTime = QDateTime::fromMSecsSinceEpoch(timeMs).toString("yyyy-MM-dd hh:mm:ss.zzz");
+    }
+    cachedMs = timeMs;
+    return cachedTime;
+}
+
+QString Logger::format(const Entry &entry, const QString &time)
+{
+    return time + ": " + entry.text;
+}
@@ -22,24 +22,85 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <QObject>
 #include <QString>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QTimer>
+#include <QFile>
+
+#include <memory>
+
+#include "logline.h"
 
 class IView;
+class QThread;
+class QCommandLineParser;
 
-class Logger
+// Messages are queued by the caller, formatted on a background thread and
+// handed to the view in batches at most every deliveryIntervalMs.
+// The add* methods must be called from the thread the logger lives in.
+class Logger : public QObject
 {
+    Q_OBJECT
+
 public:
-    Logger(IView* v);
+    static const int deliveryIntervalMs = 50;
+
+    Logger(IView* v, QObject* parent = nullptr);
+    ~Logger();
 
     void addMessage(const QString& str);
     void addHighlightedMessage(const QString& str);
     void addError(const QString& str);
-    void setTextAsHtml(bool val);
+    void add(LogLevel level, const QString& str);
+
+    // Messages below the level are dropped before they are queued
+    void setLevel(LogLevel val);
+    void setViewEnabled(bool val);
+    bool setFile(const QString& fileName);
+
+    // Delivers everything queued so far to the view
+    void flush();
+
+    // The same logging options for every front end
+    static void addOptions(QCommandLineParser& parser);
+    bool applyOptions(const QCommandLineParser& parser, QString* error);
+    static bool parseLevel(const QString& str, LogLevel* level);
 
 private:
-    void addText(const QString& str, const QString& color = "");
+    struct Entry {
+        qint64 timeMs;
+        LogLevel level;
+        QString text;
+    };
+
+    void formatLoop();
+    void deliver();
+    const QString& timestamp(qint64 timeMs);
+    static QString format(const Entry& entry, const QString& time);
+
     IView* view;
-    bool textAsHtml = false;
+    LogLevel minLevel = LogLevel::Info;
+    bool viewEnabled = true;
+    QTimer deliveryTimer;
+
+    // Shared with the formatter thread
+    QMutex mutex;
+    QWaitCondition wakeup;
+    QWaitCondition idle;
+    QList<Entry> pending;
+    QList<LogLine> formatted;
+    bool formatting = false;
+    bool stopping = false;
+    QMutex fileMutex;
+    QFile file;
+
+    // Formatter thread only
+    qint64 cachedMs = -1;
+    QString cachedTime;
+    std::unique_ptr<QThread> formatter;
 };
 
 #endif // LOGGER_H
@@ -0,0 +1,310 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scenarioengine.h"
+#include "ipresenter.h"
+#include "web/latencydistribution.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+
+#include <algorithm>
+#include <limits>
+
+ScenarioEngine::ScenarioEngine(IPresenter *p, QObject *parent)
+    : QObject(parent),
+      presenter(p)
+{
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    connect(&timer, &QTimer::timeout, this, &ScenarioEngine::fire);
+}
+
+bool ScenarioEngine::load(const QString &fileName, QString *error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = "Cannot open scenario " + fileName;
+        return false;
+    }
+    return parse(QString::fromUtf8(file.readAll()), error);
+}
+
+bool ScenarioEngine::parse(const QString &text, QString *error)
+{
+    QList<Step> steps;
+    qint64 previousMs = 0;
+    const QStringList lines = text.split('\n');
+    for (int i = 0; i < lines.size(); ++i) {
+        QString line = lines.at(i).section('#', 0, 0).simplified();
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        Step step;
+        step.line = i + 1;
+        QString time = line.section(' ', 0, 0, QString::SectionSkipEmpty);
+        step.action = line.section(' ', 1, 1, QString::SectionSkipEmpty).toLower();
+        step.argument = line.section(' ', 2, -1, QString::SectionSkipEmpty);
+
+        bool relative = time.startsWith('+');
+        qint64 ms = 0;
+        if (!parseTime(relative ? time.mid(1) : time, &ms)) {
+            *error = QString("Line %1: invalid time \"%2\"").arg(step.line).arg(time);
+            return false;
+        }
+        step.atMs = relative ? previousMs + ms : ms;
+        previousMs = step.atMs;
+
+        QString actionError;
+        if (!apply(step, nullptr, &actionError)) {
+            *error = QString("Line %1: %2").arg(step.line).arg(actionError);
+            return false;
+        }
+        steps.append(step);
+    }
+
+    // Steps at the same time keep the order of the file
+    std::stable_sort(steps.begin(), steps.end(), [](const Step& a, const Step& b) {
+        return a.atMs < b.atMs;
+    });
+    stop();
+    timeline = steps;
+    return true;
+}
+
+const QList<ScenarioEngine::Step> &ScenarioEngine::steps() const
+{
+    return timeline;
+}
+
+bool ScenarioEngine::execute(const QString &command, IPresenter *target, QString *error)
+{
+    QString line = command.simplified();
+    Step step;
+    step.action = line.section(' ', 0, 0).toLower();
+    step.argument = line.section(' ', 1, -1);
+    if (step.action.isEmpty()) {
+        *error = "missing action";
+        return false;
+    }
+    return apply(step, target, error);
+}
+
+void ScenarioEngine::start()
+{
+    stop();
+    running = true;
+    nextStep = 0;
+    clock.start();
+    scheduleNext();
+}
+
+void ScenarioEngine::stop()
+{
+    timer.stop();
+    running = false;
+}
+
+bool ScenarioEngine::isRunning() const
+{
+    return running;
+}
+
+void ScenarioEngine::fire()
+{
+    while (running && nextStep < timeline.size()) {
+        const Step& step = timeline.at(nextStep);
+        qint64 dueNs = step.atMs * 1000000;
+        qint64 nowNs = clock.nsecsElapsed();
+        if (dueNs - nowNs > spinMs * 1000000LL) {
+            break;
+        }
+        // Timers may be late under load but never much early, the last
+        // stretch is waited for here
+        while (nowNs < dueNs) {
+            nowNs = clock.nsecsElapsed();
+        }
+
+        ++nextStep;
+        QString error;
+        apply(step, presenter, &error);
+        emit stepExecuted(step.action + (step.argument.isEmpty() ? QString() : " " + step.argument),
+                          static_cast<double>(nowNs - dueNs) / 1e6);
+    }
+    scheduleNext();
+}
+
+bool ScenarioEngine::parseTime(const QString &str, qint64 *ms)
+{
+    static const QRegularExpression timeRe("^(\\d+(?:\\.\\d+)?)(ms|s|m|h)?$");
+    QRegularExpressionMatch match = timeRe.match(str.toLower());
+    if (!match.hasMatch()) {
+        return false;
+    }
+    double value = match.captured(1).toDouble();
+    QString unit = match.captured(2);
+    double scale = unit == "ms" ? 1 : unit == "m" ? 60000 : unit == "h" ? 3600000 : 1000;
+    *ms = static_cast<qint64>(value * scale + 0.5);
+    return true;
+}
+
+bool ScenarioEngine::apply(const Step &step, IPresenter *target, QString *error)
+{
+    const QString& arg = step.argument;
+    auto onOff = [&](bool* val) {
+        if (arg != "on" && arg != "off") {
+            *error = "\"" + step.action + "\" expects on or off";
+            return false;
+        }
+        *val = arg == "on";
+        return true;
+    };
+    auto number = [&](int min, int max, int* val) {
+        bool ok = false;
+        *val = arg.toInt(&ok);
+        if (!ok || *val < min || *val > max) {
+            *error = QString("\"%1\" expects a number from %2 to %3").arg(step.action).arg(min).arg(max);
+            return false;
+        }
+        return true;
+    };
+    auto noArgument = [&]() {
+        if (!arg.isEmpty()) {
+            *error = "\"" + step.action + "\" takes no argument";
+            return false;
+        }
+        return true;
+    };
+
+    bool flag = false;
+    int val = 0;
+    if (step.action == "start" || step.action == "stop" || step.action == "reset") {
+        if (!noArgument()) {
+            return false;
+        }
+        if (target && step.action == "start") {
+            target->startServer();
+        } else if (target && step.action == "stop") {
+            target->stopServer();
+        } else if (target) {
+            target->reset();
+        }
+    } else if (step.action == "listen") {
+        if (!onOff(&flag)) {
+            return false;
+        }
+        if (target) {
+            target->enableListenPort(flag);
+        }
+    } else if (step.action == "respond") {
+        if (!onOff(&flag)) {
+            return false;
+        }
+        if (target) {
+            target->enableHttpResponse(flag);
+        }
+    } else if (step.action == "empty") {
+        if (!onOff(&flag)) {
+            return false;
+        }
+        if (target) {
+            target->setReturnEmptyPage(flag);
+        }
+    } else if (step.action == "delay") {
+        if (arg.isEmpty()) {
+            *error = "\"delay\" expects off or a distribution";
+            return false;
+        }
+        // Checked up front, a broken spec would only be logged when the step fires
+        LatencyDistribution distribution;
+        if (!target && arg != "off" && !LatencyDistribution::parse(arg, &distribution, error)) {
+            return false;
+        }
+        if (target && arg == "off") {
+            target->enableResponseDelay(false);
+        } else if (target) {
+            target->delayDistributionChanged(arg);
+            target->enableResponseDelay(true);
+        }
+    } else if (step.action == "code") {
+        if (!number(100, 599, &val)) {
+            return false;
+        }
+        if (target) {
+            target->returnCodeChanged(val);
+        }
+    } else if (step.action == "port") {
+        if (!number(1, 65535, &val)) {
+            return false;
+        }
+        if (target) {
+            target->listenPortChanged(static_cast<ushort>(val));
+        }
+    } else if (step.action == "endpoint") {
+        if (!arg.startsWith('/')) {
+            *error = "\"endpoint\" expects a path";
+            return false;
+        }
+        if (target) {
+            target->endpointPathChanged(arg);
+        }
+    } else if (step.action == "cache") {
+        if (arg != "normal" && arg != "changed" && arg != "unchanged") {
+            *error = "\"cache\" expects normal, changed or unchanged";
+            return false;
+        }
+        if (target) {
+            target->cacheValidationChanged(arg);
+        }
+    } else if (step.action == "page") {
+        if (arg.isEmpty()) {
+            *error = "\"page\" expects a file";
+            return false;
+        }
+        if (!target && !QFileInfo(arg).isFile()) {
+            *error = "\"page\" file not found: " + arg;
+            return false;
+        }
+        if (target) {
+            target->newWebPageSelected(arg);
+        }
+    } else {
+        *error = "unknown action \"" + step.action + "\"";
+        return false;
+    }
+    return true;
+}
+
+void ScenarioEngine::scheduleNext()
+{
+    if (!running) {
+        return;
+    }
+    if (nextStep >= timeline.size()) {
+        running = false;
+        emit finished();
+        return;
+    }
+    qint64 waitMs = timeline.at(nextStep).atMs - clock.elapsed() - spinMs;
+    timer.start(static_cast<int>(qBound<qint64>(0, waitMs, std::numeric_limits<int>::max())));
+}
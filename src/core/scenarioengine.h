@@ -0,0 +1,100 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCENARIOENGINE_H
+#define SCENARIOENGINE_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+
+class IPresenter;
+
+// Replays a timeline of presenter actions, e.g. a repeatable incident:
+//
+//   30s   respond off
+//   +45s  code 503
+//   +2m   code 200
+//   +0    respond on
+//
+// A time is counted from the start of the scenario, or from the step before
+// when it begins with '+'. Units are ms, s, m and h, a bare number is
+// seconds. Actions: start, stop, reset, listen on|off, respond on|off,
+// empty on|off, delay off|<distribution spec>, code <n>, port <n>,
+// endpoint <path>, cache normal|changed|unchanged, page <file>.
+//
+// A step fires on time, a new page is served once it has been copied on the
+// loader's pool, an empirical delay once its file has been read.
+class ScenarioEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    // The timer wakes up this early, the rest is spun off so that steps
+    // fire within a millisecond of their time
+    static const int spinMs = 2;
+
+    struct Step {
+        qint64 atMs = 0;
+        QString action;
+        QString argument;
+        int line = 0;
+    };
+
+    explicit ScenarioEngine(IPresenter* p, QObject* parent = nullptr);
+
+    bool load(const QString& fileName, QString* error);
+    bool parse(const QString& text, QString* error);
+    const QList<Step>& steps() const;
+
+    // One "action argument" line without a time, applied at once. Also the
+    // vocabulary of the admin server's /control
+    static bool execute(const QString& command, IPresenter* target, QString* error);
+
+    void start();
+    void stop();
+    bool isRunning() const;
+
+signals:
+    // lateMs is how much after its time the step ran
+    void stepExecuted(const QString& description, double lateMs);
+    void finished();
+
+private slots:
+    void fire();
+
+private:
+    static bool parseTime(const QString& str, qint64* ms);
+    // Checks the step without a target, applies it with one
+    static bool apply(const Step& step, IPresenter* target, QString* error);
+    void scheduleNext();
+
+    IPresenter* presenter;
+    QList<Step> timeline;
+    int nextStep = 0;
+    QTimer timer;
+    QElapsedTimer clock;
+    bool running = false;
+};
+
+#endif // SCENARIOENGINE_H
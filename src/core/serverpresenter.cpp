@@ -27,6 +27,7 @@
 
 #include <QVariant>
 #include <QRegularExpression>
+#include <QElapsedTimer>
 
 ServerPresenter::ServerPresenter(IView *v, IWebServerDiag *s, Logger *log, QObject *parent)
     : IPresenter(parent),
@@ -39,6 +40,21 @@ ServerPresenter::ServerPresenter(IView *v, IWebServerDiag *s, Logger *log, QObje
 
     setWebPageByPath("");
     resetToDefault();
+
+    connect(&latencyTimer, &QTimer::timeout, this, &ServerPresenter::updateLatency);
+    latencyTimer.start(1000);
+
+    connect(&webPageLoader, &WebPageLoader::pageLoaded, this, &ServerPresenter::webPageLoaded);
+    connect(&webPageLoader, &WebPageLoader::pageReloaded, this, &ServerPresenter::webPageReloaded);
+    connect(&webPageLoader, &WebPageLoader::loadFailed, this, [this](const QString& error) {
+        logger->addError(error);
+    });
+    sitePool.setMaxThreadCount(1);
+}
+
+ServerPresenter::~ServerPresenter()
+{
+    sitePool.waitForDone();
 }
 
 void ServerPresenter::showView()
@@ -115,13 +131,6 @@ void ServerPresenter::endpointPathChanged(const QString &str)
     server->setEndpointPath(pathRes);
     view->setEndpointPath(pathRes);
 
-    bool needRestart = server->getWebServerData().isStarted();
-
-    if (needRestart) {
-        server->startServer(false);
-        server->startServer(true);
-    }
-
     logger->addMessage("Endpoint path set to " + pathRes);
 }
 
@@ -132,15 +141,12 @@ void ServerPresenter::listenPortChanged(ushort val)
         return;
     }
 
-    bool needRestart = server->getWebServerData().isStarted();
-
     server->setListenPortNumber(val);
-    view->setPort(val);
-
-    if (needRestart) {
-        server->startServer(false);
-        server->startServer(true);
+    view->setPort(server->getWebServerData().getPort());
+    if (server->getWebServerData().getPort() != val) {
+        return;
     }
+
     QString valStr;
     valStr.setNum(val);
     logger->addMessage("Port set to " + valStr);
@@ -200,17 +206,43 @@ void ServerPresenter::setReturnEmptyPage(bool val)
 
 void ServerPresenter::httpResponseTimeChanged(int val)
 {
-    if (server->getWebServerData().getResponseTime() == val) {
+    // Also switches back from another distribution with the same constant delay
+    if (server->getWebServerData().getDelayDistribution() == LatencyDistribution::constant(val)) {
         view->setResponseTime(val);
         return;
     }
 
     server->httpResponseTimeChanged(val);
     view->setResponseTime(val);
+    view->setDelayDistribution(server->getWebServerData().getDelayDistribution().toString());
 
     logger->addMessage("HTTP response delay time is set to " + QString::number(val) + "ms");
 }
 
+void ServerPresenter::delayDistributionChanged(const QString &spec)
+{
+    const LatencyDistribution& current = server->getWebServerData().getDelayDistribution();
+
+    LatencyDistribution dist;
+    QString error;
+    if (!LatencyDistribution::parse(spec, &dist, &error)) {
+        logger->addError("Invalid delay distribution: " + error);
+        view->setDelayDistribution(current.toString());
+        return;
+    }
+
+    if (current == dist) {
+        view->setDelayDistribution(dist.toString());
+        return;
+    }
+
+    server->setDelayDistribution(dist);
+    view->setDelayDistribution(dist.toString());
+    view->setResponseTime(server->getWebServerData().getResponseTime());
+
+    logger->addMessage("Response delay distribution set to " + dist.toString());
+}
+
 void ServerPresenter::returnCodeChanged(int val)
 {
     if (server->getWebServerData().getReturnCode() == val) {
@@ -224,12 +256,76 @@ void ServerPresenter::returnCodeChanged(int val)
     logger->addMessage("HTTP response code set to " + QString::number(val));
 }
 
+void ServerPresenter::cacheValidationChanged(const QString &mode)
+{
+    CacheValidation current = server->getWebServerData().getCacheValidation();
+
+    CacheValidation next;
+    if (!WebServerData::parseCacheValidation(mode, &next)) {
+        logger->addError("Invalid cache validation mode: " + mode);
+        view->setCacheValidation(WebServerData::cacheValidationName(current));
+        return;
+    }
+
+    if (current == next) {
+        view->setCacheValidation(mode);
+        return;
+    }
+
+    server->setCacheValidation(next);
+    view->setCacheValidation(mode);
+
+    logger->addMessage("Cache validation set to " + mode);
+}
+
 void ServerPresenter::newWebPageSelected(const QString &path)
 {
     setWebPageByPath(path);
     logger->addMessage("Web page set to " + (path.isEmpty() ? "none" : path));
 }
 
+void ServerPresenter::newSiteDirectorySelected(const QString &path)
+{
+    if (path.isEmpty()) {
+        setWebPageByPath("");
+        logger->addMessage("Site directory cleared");
+        return;
+    }
+
+    // What was served so far stays until the index is ready
+    int gen = ++siteGeneration;
+    logger->addMessage("Indexing site directory " + path);
+    sitePool.start([this, gen, path]() {
+        QElapsedTimer timer;
+        timer.start();
+        QString error;
+        std::shared_ptr<const StaticSiteIndex> site = StaticSiteIndex::build(path, &error);
+        qint64 elapsedMs = timer.elapsed();
+        QMetaObject::invokeMethod(this, [this, gen, site, error, elapsedMs]() {
+            siteIndexed(gen, site, error, elapsedMs);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ServerPresenter::siteIndexed(int gen, const std::shared_ptr<const StaticSiteIndex> &site, const QString &error,
+                                  qint64 elapsedMs)
+{
+    // Another page or directory was selected in the meantime
+    if (gen != siteGeneration) {
+        return;
+    }
+    if (!site) {
+        logger->addError(error);
+        return;
+    }
+
+    webPageLoader.load("");
+    server->setStaticSite(site);
+    view->setWebPageName(site->rootDir() + "/");
+    logger->addMessage(QString("Serving %1 files from %2, indexed in %3 ms")
+                       .arg(site->size()).arg(site->rootDir()).arg(elapsedMs));
+}
+
 void ServerPresenter::serverErrorHasOccurred(const QString &str)
 {
     logger->addError("Error has occurred: " +str);
@@ -258,13 +354,43 @@ void ServerPresenter::resetToDefault()
     hostnameChanged(data.getHostname());
     endpointPathChanged(data.getEndpointPath());
     httpResponseTimeChanged(data.getResponseTime());
+    delayDistributionChanged(data.getDelayDistribution().toString());
     enableResponseDelay(data.getEnableResponseDelay());
     setReturnEmptyPage(data.getReturnEmptyPage());
+    cacheValidationChanged(WebServerData::cacheValidationName(data.getCacheValidation()));
+}
+
+void ServerPresenter::updateLatency()
+{
+    if (!server->getWebServerData().isStarted()) {
+        return;
+    }
+    view->showLatency(server->getLatencySummary());
 }
 
 void ServerPresenter::setWebPageByPath(const QString &path)
 {
-    webPageLoader.load(path);
-    server->setRespPage(webPageLoader.getPage());
+    // A file is copied on the loader's pool, the page served so far stays
+    // until the copy is ready
+    ++siteGeneration;
+    std::shared_ptr<const PageData> placeholder = webPageLoader.load(path);
+    server->setStaticSite(nullptr);
+    if (placeholder) {
+        server->setRespPage(placeholder);
+    }
     view->setWebPageName(path);
 }
+
+void ServerPresenter::webPageLoaded(const std::shared_ptr<const PageData> &page)
+{
+    server->setRespPage(page);
+    logger->addMessage("Web page loaded from " + page->fileName() +
+                       " (" + QString::number(page->size()) + " bytes)");
+}
+
+void ServerPresenter::webPageReloaded(const std::shared_ptr<const PageData> &page)
+{
+    server->setRespPage(page);
+    logger->addMessage("Web page reloaded from " + page->fileName() +
+                       " (" + QString::number(page->size()) + " bytes)");
+}
@@ -23,6 +23,8 @@
 #define SERVERPRESENTER_H
 
 #include <QObject>
+#include <QTimer>
+#include <QThreadPool>
 
 #include "ipresenter.h"
 #include "logger.h"
@@ -30,6 +32,7 @@
 
 class IView;
 class IWebServerDiag;
+class StaticSiteIndex;
 
 class ServerPresenter : public IPresenter
 {
@@ -37,6 +40,7 @@ class ServerPresenter : public IPresenter
 
 public:
     ServerPresenter(IView* v, IWebServerDiag* s, Logger* log, QObject *parent = nullptr);
+    ~ServerPresenter();
 
     void showView() override;
     void startServer() override;
@@ -49,8 +53,11 @@ public:
     void enableResponseDelay(bool val) override;
     void setReturnEmptyPage(bool val) override;
     void httpResponseTimeChanged(int val) override;
+    void delayDistributionChanged(const QString& spec) override;
     void returnCodeChanged(int val) override;
+    void cacheValidationChanged(const QString& mode) override;
     void newWebPageSelected(const QString& path) override;
+    void newSiteDirectorySelected(const QString& path) override;
     void serverErrorHasOccurred(const QString& str) override;
 
     void reset() override;
@@ -58,11 +65,22 @@ public:
 private:
     void resetToDefault();
     void setWebPageByPath(const QString& path);
+    void webPageLoaded(const std::shared_ptr<const PageData>& page);
+    void webPageReloaded(const std::shared_ptr<const PageData>& page);
+    void siteIndexed(int gen, const std::shared_ptr<const StaticSiteIndex>& site, const QString& error,
+                     qint64 elapsedMs);
+    void updateLatency();
 
     IView* view;
     IWebServerDiag* server;
     Logger* logger;
     WebPageLoader webPageLoader;
+    // Site directories are indexed here, a large tree does not block the
+    // view or the admin server
+    QThreadPool sitePool;
+    // Only the directory selected last is served
+    int siteGeneration = 0;
+    QTimer latencyTimer;
 };
 
 #endif // SERVERPRESENTER_H
@@ -0,0 +1,317 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "accesslog.h"
+
+#include <QHostAddress>
+#include <QDateTime>
+#include <QLocale>
+#include <QDebug>
+
+#include <cstring>
+
+static const size_t drainBatch = 256;
+static const int flushThreshold = 64 * 1024;
+
+void AccessRecord::setClient(const QHostAddress &address)
+{
+    Q_IPV6ADDR ip6 = address.toIPv6Address();
+    std::memcpy(clientAddress, ip6.c, sizeof(clientAddress));
+}
+
+void AccessRecord::setPath(const QString &str)
+{
+    QByteArray utf8 = str.toUtf8();
+    qsizetype length = qMin<qsizetype>(utf8.size(), maxPathLength);
+    // A long path is cut before a character, not in the middle of one
+    if (length < utf8.size()) {
+        while (length > 0 && (static_cast<uchar>(utf8.at(length)) & 0xc0) == 0x80) {
+            --length;
+        }
+    }
+    pathLength = static_cast<quint16>(length);
+    std::memcpy(path, utf8.constData(), pathLength);
+}
+
+void AccessLogWakeup::notify()
+{
+    // Pairs with the fence in wait(): either the sleeper sees the new
+    // record or the record's producer sees the sleeper
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed) && sleeping.exchange(false)) {
+        semaphore.release();
+    }
+}
+
+void AccessLogWakeup::wait(const std::function<bool()> &hasWork)
+{
+    sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (hasWork() && sleeping.exchange(false)) {
+        return;
+    }
+    // Also taken at once when notify() came in between
+    semaphore.acquire();
+}
+
+AccessLogBuffer::AccessLogBuffer(size_t capacity, const std::shared_ptr<AccessLogWakeup> &wake)
+    : ring(capacity),
+      droppedCount(0),
+      wakeup(wake)
+{
+
+}
+
+void AccessLogBuffer::push(const AccessRecord &record)
+{
+    if (!ring.push(record)) {
+        droppedCount.store(droppedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    if (wakeup) {
+        wakeup->notify();
+    }
+}
+
+size_t AccessLogBuffer::pop(AccessRecord *out, size_t maxCount)
+{
+    return ring.pop(out, maxCount);
+}
+
+bool AccessLogBuffer::isEmpty() const
+{
+    return ring.isEmpty();
+}
+
+quint64 AccessLogBuffer::dropped() const
+{
+    return droppedCount.load(std::memory_order_relaxed);
+}
+
+AccessLog::AccessLog(QObject *parent)
+    : QThread(parent),
+      stopping(false),
+      wakeup(std::make_shared<AccessLogWakeup>())
+{
+
+}
+
+AccessLog::~AccessLog()
+{
+    close();
+}
+
+bool AccessLog::open(const QString &fileName, Format fmt)
+{
+    close();
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Cannot open access log" << fileName << ":" << file.errorString();
+        return false;
+    }
+    format = fmt;
+    if (format == Format::Binary && file.size() == 0) {
+        // Magic and record size, then the records as they are in memory
+        quint32 recordSize = sizeof(AccessRecord);
+        file.write("WMDACC1", 8);
+        file.write(reinterpret_cast<const char*>(&recordSize), sizeof(recordSize));
+    }
+
+    stopping = false;
+    start(QThread::LowPriority);
+    return true;
+}
+
+void AccessLog::close()
+{
+    if (!isRunning()) {
+        return;
+    }
+    stopping = true;
+    wakeup->notify();
+    wait();
+    file.close();
+
+    quint64 count = dropped();
+    if (count > 0) {
+        qWarning() << "Access log dropped" << count << "records";
+    }
+}
+
+std::shared_ptr<AccessLogBuffer> AccessLog::createBuffer()
+{
+    auto buffer = std::make_shared<AccessLogBuffer>(16384, wakeup);
+    QMutexLocker locker(&buffersMutex);
+    buffers.append(buffer);
+    return buffer;
+}
+
+quint64 AccessLog::dropped() const
+{
+    QMutexLocker locker(&buffersMutex);
+    quint64 res = droppedByRemoved;
+    for (const auto& buffer : buffers) {
+        res += buffer->dropped();
+    }
+    return res;
+}
+
+bool AccessLog::parseFormat(const QString &str, Format *fmt)
+{
+    if (str == "clf") {
+        *fmt = Format::Clf;
+    } else if (str == "jsonl") {
+        *fmt = Format::JsonLines;
+    } else if (str == "binary") {
+        *fmt = Format::Binary;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void AccessLog::run()
+{
+    while (!stopping) {
+        if (drain() == 0) {
+            wakeup->wait([this]() {
+                return stopping || hasRecords();
+            });
+        }
+    }
+    drain();
+    file.flush();
+}
+
+bool AccessLog::hasRecords() const
+{
+    QMutexLocker locker(&buffersMutex);
+    for (const auto& buffer : buffers) {
+        if (!buffer->isEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t AccessLog::drain()
+{
+    QList<std::shared_ptr<AccessLogBuffer>> current;
+    {
+        QMutexLocker locker(&buffersMutex);
+        current = buffers;
+    }
+
+    size_t total = 0;
+    AccessRecord batch[drainBatch];
+    for (const auto& buffer : std::as_const(current)) {
+        size_t count;
+        while ((count = buffer->pop(batch, drainBatch)) > 0) {
+            for (size_t i = 0; i < count; ++i) {
+                write(batch[i]);
+            }
+            total += count;
+            if (out.size() >= flushThreshold) {
+                file.write(out);
+                out.clear();
+            }
+        }
+    }
+    if (!out.isEmpty()) {
+        file.write(out);
+        out.clear();
+        file.flush();
+    }
+
+    // Buffers of finished workers are dropped once they are empty
+    current.clear();
+    QMutexLocker locker(&buffersMutex);
+    buffers.removeIf([this](const std::shared_ptr<AccessLogBuffer>& buffer) {
+        if (buffer.use_count() > 1 || !buffer->isEmpty()) {
+            return false;
+        }
+        droppedByRemoved += buffer->dropped();
+        return true;
+    });
+    return total;
+}
+
+void AccessLog::write(const AccessRecord &record)
+{
+    if (format == Format::Binary) {
+        out.append(reinterpret_cast<const char*>(&record), sizeof(record));
+        return;
+    }
+
+    qint64 second = record.timestampUs / 1000000;
+    if (second != cachedSecond) {
+        QDateTime time = QDateTime::fromSecsSinceEpoch(second, Qt::UTC);
+        cachedTime = format == Format::Clf
+                ? QLocale::c().toString(time, "dd/MMM/yyyy:hh:mm:ss +0000").toLatin1()
+                : QLocale::c().toString(time, "yyyy-MM-ddThh:mm:ss").toLatin1();
+        cachedSecond = second;
+    }
+
+    Q_IPV6ADDR ip6;
+    std::memcpy(ip6.c, record.clientAddress, sizeof(ip6.c));
+    QHostAddress client(ip6);
+    bool isIPv4 = false;
+    quint32 ip4 = client.toIPv4Address(&isIPv4);
+    QByteArray clientStr = (isIPv4 ? QHostAddress(ip4) : client).toString().toLatin1();
+    QByteArray path(record.path, record.pathLength);
+
+    if (format == Format::Clf) {
+        // Quotes, spaces and control characters would split the request
+        // field, they are percent-encoded
+        QByteArray encoded;
+        for (char ch : std::as_const(path)) {
+            uchar byte = static_cast<uchar>(ch);
+            if (byte <= 0x20 || byte == 0x7f || ch == '"' || ch == '\\') {
+                encoded += '%' + QByteArray::number(byte, 16).toUpper().rightJustified(2, '0');
+            } else {
+                encoded += ch;
+            }
+        }
+        // Common Log Format with the applied delay in ms appended
+        out += clientStr + " - - [" + cachedTime + "] \"GET " + encoded + " HTTP/1.1\" " +
+               QByteArray::number(record.statusCode) + ' ' + QByteArray::number(record.bytes) + ' ' +
+               QByteArray::number(record.delayMs) + '\n';
+        return;
+    }
+
+    QByteArray escaped;
+    for (char ch : std::as_const(path)) {
+        if (ch == '"' || ch == '\\') {
+            escaped += '\\';
+            escaped += ch;
+        } else if (static_cast<unsigned char>(ch) < 0x20) {
+            escaped += "\\u00" + QByteArray::number(static_cast<unsigned char>(ch), 16).rightJustified(2, '0');
+        } else {
+            escaped += ch;
+        }
+    }
+    out += "{\"ts\":\"" + cachedTime + '.' +
+           QByteArray::number(record.timestampUs / 1000 % 1000).rightJustified(3, '0') +
+           "Z\",\"client\":\"" + clientStr + "\",\"path\":\"" + escaped +
+           "\",\"code\":" + QByteArray::number(record.statusCode) +
+           ",\"delay_ms\":" + QByteArray::number(record.delayMs) +
+           ",\"bytes\":" + QByteArray::number(record.bytes) + "}\n";
+}
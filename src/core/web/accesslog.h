@@ -0,0 +1,131 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACCESSLOG_H
+#define ACCESSLOG_H
+
+#include <QThread>
+#include <QMutex>
+#include <QSemaphore>
+#include <QFile>
+#include <QList>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "spscring.h"
+
+class QHostAddress;
+
+struct AccessRecord
+{
+    static const int maxPathLength = 94;
+
+    qint64 timestampUs = 0; // since epoch
+    quint64 bytes = 0;
+    quint32 delayMs = 0;
+    quint16 statusCode = 0;
+    quint16 pathLength = 0;
+    quint8 clientAddress[16] = {}; // IPv6, IPv4 mapped
+    char path[maxPathLength] = {};
+    quint16 reserved = 0;
+
+    void setClient(const QHostAddress& address);
+    void setPath(const QString& str);
+};
+
+// Lets the log thread sleep until a worker has pushed a record
+class AccessLogWakeup
+{
+public:
+    // Cheap while the log thread is awake
+    void notify();
+    // Sleeps until notify() unless hasWork() holds once the sleep is announced
+    void wait(const std::function<bool()>& hasWork);
+
+private:
+    std::atomic<bool> sleeping{false};
+    QSemaphore semaphore;
+};
+
+// Records of one worker. Filled by the worker, drained by the log thread.
+class AccessLogBuffer
+{
+public:
+    explicit AccessLogBuffer(size_t capacity, const std::shared_ptr<AccessLogWakeup>& wake = nullptr);
+
+    void push(const AccessRecord& record);
+    size_t pop(AccessRecord* out, size_t maxCount);
+    bool isEmpty() const;
+    quint64 dropped() const;
+
+private:
+    SpscRing<AccessRecord> ring;
+    std::atomic<quint64> droppedCount;
+    std::shared_ptr<AccessLogWakeup> wakeup;
+};
+
+// Writes the records of all workers to a file from its own thread
+class AccessLog : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum class Format {
+        Clf,
+        JsonLines,
+        Binary
+    };
+
+    AccessLog(QObject* parent = nullptr);
+    ~AccessLog();
+
+    bool open(const QString& fileName, Format fmt);
+    void close();
+
+    // One buffer per worker thread
+    std::shared_ptr<AccessLogBuffer> createBuffer();
+    quint64 dropped() const;
+
+    static bool parseFormat(const QString& str, Format* fmt);
+
+protected:
+    void run() override;
+
+private:
+    size_t drain();
+    bool hasRecords() const;
+    void write(const AccessRecord& record);
+
+    QFile file;
+    Format format = Format::Clf;
+    QByteArray out;
+    qint64 cachedSecond = -1;
+    QByteArray cachedTime;
+    mutable QMutex buffersMutex;
+    QList<std::shared_ptr<AccessLogBuffer>> buffers;
+    quint64 droppedByRemoved = 0;
+    std::atomic<bool> stopping;
+    std::shared_ptr<AccessLogWakeup> wakeup;
+};
+
+#endif // ACCESSLOG_H
@@ -0,0 +1,192 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "adminserver.h"
+#include "webserverdiag.h"
+#include "../ipresenter.h"
+#include "../scenarioengine.h"
+
+#include <QtHttpServer/QHttpServer>
+#include <QTcpServer>
+#include <QDebug>
+
+const char AdminServer::controlHeader[] = "X-WMD-Control";
+
+AdminServer::AdminServer(WebServerDiag *srv, QObject *parent)
+    : QObject(parent),
+      server(srv)
+{
+    httpServer = new QHttpServer(this);
+    httpServer->route("/metrics", QHttpServerRequest::Method::Get, [this]() {
+        return QHttpServerResponse("text/plain; version=0.0.4; charset=utf-8", server->metricsText());
+    });
+    httpServer->route("/control", QHttpServerRequest::Method::Post, [this](const QHttpServerRequest& request) {
+        return control(request);
+    });
+    httpServer->route("/control", QHttpServerRequest::Method::Get, [this]() {
+        if (!controlEnabled()) {
+            return QHttpServerResponse(QHttpServerResponder::StatusCode::NotFound);
+        }
+        return QHttpServerResponse("text/plain; charset=utf-8", controlState());
+    });
+    httpServer->route("/control/quit", QHttpServerRequest::Method::Post, [this](const QHttpServerRequest& request) {
+        if (!controlEnabled()) {
+            return QHttpServerResponse(QHttpServerResponder::StatusCode::NotFound);
+        }
+        if (!hasControlHeader(request)) {
+            return missingControlHeader();
+        }
+        emit quitRequested();
+        return QHttpServerResponse("text/plain; charset=utf-8", "OK\n");
+    });
+}
+
+bool AdminServer::listen(const QHostAddress &address, quint16 port)
+{
+    QTcpServer* tcpServer = new QTcpServer(this);
+    if (!tcpServer->listen(address, port)) {
+        qWarning() << "Error binding admin server to address and port:" << tcpServer->errorString();
+        delete tcpServer;
+        return false;
+    }
+    httpServer->bind(tcpServer);
+    exposed = exposed || !address.isLoopback();
+    return true;
+}
+
+void AdminServer::setPresenter(IPresenter *p)
+{
+    presenter = p;
+}
+
+void AdminServer::setRemoteControl(bool allow)
+{
+    remoteControl = allow;
+}
+
+void AdminServer::setPageControl(bool allow)
+{
+    pageControl = allow;
+}
+
+bool AdminServer::controlEnabled() const
+{
+    return presenter && (!exposed || remoteControl);
+}
+
+bool AdminServer::hasControlHeader(const QHttpServerRequest &request)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+    return !request.headers().value(controlHeader).isEmpty();
+#else
+    return !request.value(controlHeader).isEmpty();
+#endif
+}
+
+QHttpServerResponse AdminServer::missingControlHeader()
+{
+    return QHttpServerResponse("text/plain; charset=utf-8",
+                               QByteArray("Missing ") + controlHeader + " header\n",
+                               QHttpServerResponder::StatusCode::Forbidden);
+}
+
+QHttpServerResponse AdminServer::control(const QHttpServerRequest &request)
+{
+    if (!controlEnabled()) {
+        return QHttpServerResponse(QHttpServerResponder::StatusCode::NotFound);
+    }
+    if (!hasControlHeader(request)) {
+        return missingControlHeader();
+    }
+
+    // A batch is checked as a whole before any of it is applied
+    QStringList commands;
+    const QStringList lines = QString::fromUtf8(request.body()).split('\n');
+    for (int i = 0; i < lines.size(); ++i) {
+        QString line = lines.at(i).section('#', 0, 0).simplified();
+        if (line.isEmpty()) {
+            continue;
+        }
+        if (!pageControl && line.section(' ', 0, 0).toLower() == "page") {
+            return QHttpServerResponse("text/plain; charset=utf-8",
+                                       QString("Line %1: \"page\" is not allowed\n").arg(i + 1).toUtf8(),
+                                       QHttpServerResponder::StatusCode::Forbidden);
+        }
+        QString error;
+        if (!ScenarioEngine::execute(line, nullptr, &error)) {
+            return QHttpServerResponse("text/plain; charset=utf-8",
+                                       QString("Line %1: %2\n").arg(i + 1).arg(error).toUtf8(),
+                                       QHttpServerResponder::StatusCode::BadRequest);
+        }
+        commands.append(line);
+    }
+    if (commands.isEmpty()) {
+        return QHttpServerResponse("text/plain; charset=utf-8", "No command\n",
+                                   QHttpServerResponder::StatusCode::BadRequest);
+    }
+
+    for (const QString& command : std::as_const(commands)) {
+        QString error;
+        ScenarioEngine::execute(command, presenter, &error);
+    }
+    return QHttpServerResponse("text/plain; charset=utf-8", "OK\n");
+}
+
+QByteArray AdminServer::controlState() const
+{
+    const WebServerData& data = server->getWebServerData();
+    auto onOff = [](bool val) {
+        return QString(val ? "on" : "off");
+    };
+
+    QString str;
+    str.append(QString("listen %1\n").arg(onOff(data.isListen())));
+    str.append(QString("respond %1\n").arg(onOff(data.isResponding())));
+    str.append(QString("empty %1\n").arg(onOff(data.getReturnEmptyPage())));
+    str.append("delay " + (data.getEnableResponseDelay() ? data.getDelayDistribution().toString() : "off") + '\n');
+    str.append(QString("code %1\n").arg(data.getReturnCode()));
+    str.append(QString("port %1\n").arg(data.getPort()));
+    str.append("endpoint " + data.getEndpointPath() + '\n');
+    str.append("cache " + WebServerData::cacheValidationName(data.getCacheValidation()) + '\n');
+    // Only set from the command line, so a comment when posted back
+    str.append("# tcp-fault " + WebServerData::tcpFaultName(data.getTcpFault()) + '\n');
+    return str.toUtf8();
+}
+
+bool AdminServer::parseAddress(const QString &str, QHostAddress *address, quint16 *port)
+{
+    int sep = str.lastIndexOf(':');
+    if (sep <= 0) {
+        return false;
+    }
+
+    QString host = str.left(sep);
+    if (host.startsWith('[') && host.endsWith(']')) {
+        host = host.mid(1, host.size() - 2);
+    }
+    if (host == "localhost") {
+        host = "127.0.0.1";
+    }
+
+    bool portChk = false;
+    *port = str.mid(sep + 1).toUShort(&portChk);
+    return portChk && address->setAddress(host);
+}
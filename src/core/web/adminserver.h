@@ -0,0 +1,83 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADMINSERVER_H
+#define ADMINSERVER_H
+
+#include <QObject>
+#include <QHostAddress>
+
+class QHttpServer;
+class QHttpServerRequest;
+class QHttpServerResponse;
+class WebServerDiag;
+class IPresenter;
+
+// HTTP server for operating the tool itself, on its own address and port.
+// Its listener is independent of the workers, so nothing simulated on the
+// diagnostic endpoint affects it.
+//
+// With a presenter it is also a control API speaking the scenario
+// vocabulary: POST /control applies one command per line of the body,
+// GET /control lists the current state as commands, which posted back
+// restore it, and POST /control/quit ends the application. There is no
+// authentication, so control is only served on loopback addresses unless
+// remote control is allowed, and "page" (any readable file) only when
+// page control is allowed. POSTs must carry controlHeader: a web page in a
+// local browser cannot send it without a CORS preflight, which is never
+// granted, so it cannot drive the API.
+class AdminServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const char controlHeader[];
+
+    AdminServer(WebServerDiag* srv, QObject* parent = nullptr);
+
+    bool listen(const QHostAddress& address, quint16 port);
+    void setPresenter(IPresenter* p);
+    void setRemoteControl(bool allow);
+    void setPageControl(bool allow);
+
+    // host:port, IPv6 hosts in brackets
+    static bool parseAddress(const QString& str, QHostAddress* address, quint16* port);
+
+signals:
+    void quitRequested();
+
+private:
+    bool controlEnabled() const;
+    static bool hasControlHeader(const QHttpServerRequest& request);
+    static QHttpServerResponse missingControlHeader();
+    QHttpServerResponse control(const QHttpServerRequest& request);
+    QByteArray controlState() const;
+
+    QHttpServer* httpServer;
+    WebServerDiag* server;
+    IPresenter* presenter = nullptr;
+    // Listening on an address other hosts reach
+    bool exposed = false;
+    bool remoteControl = false;
+    bool pageControl = false;
+};
+
+#endif // ADMINSERVER_H
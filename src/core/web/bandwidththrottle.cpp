@@ -0,0 +1,170 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bandwidththrottle.h"
+#include "connectionqueue.h"
+
+#include <QTcpSocket>
+
+BandwidthThrottle::BandwidthThrottle(QObject *parent)
+    : QObject(parent)
+{
+    timer.setTimerType(Qt::PreciseTimer);
+    timer.setInterval(tickMs);
+    connect(&timer, &QTimer::timeout, this, &BandwidthThrottle::advance);
+    clock.start();
+}
+
+void BandwidthThrottle::send(QTcpSocket *socket, qint64 bytesPerSecond, const QByteArray &head,
+                             const std::shared_ptr<const PageData> &body, qint64 start, qint64 length)
+{
+    Transfer transfer;
+    transfer.socket = socket;
+    transfer.rate = bytesPerSecond;
+    transfer.head = head;
+    transfer.page = body;
+    transfer.offset = start;
+    transfer.end = length < 0 ? body->size() : start + length;
+    add(std::move(transfer));
+}
+
+void BandwidthThrottle::send(QTcpSocket *socket, qint64 bytesPerSecond, const QByteArray &head,
+                             const std::shared_ptr<const SyntheticPayload> &body, qint64 length)
+{
+    Transfer transfer;
+    transfer.socket = socket;
+    transfer.rate = bytesPerSecond;
+    transfer.head = head;
+    transfer.payload = body;
+    transfer.end = length;
+    add(std::move(transfer));
+}
+
+void BandwidthThrottle::clear()
+{
+    timer.stop();
+    for (const Transfer& transfer : transfers) {
+        if (transfer.socket) {
+            ConnectionQueue::release(transfer.socket);
+        }
+    }
+    transfers.clear();
+}
+
+int BandwidthThrottle::activeCount() const
+{
+    return static_cast<int>(transfers.size());
+}
+
+void BandwidthThrottle::add(Transfer &&transfer)
+{
+    // The first tick's share goes out right away, the client sees the
+    // response start without waiting for the timer
+    transfer.rate = qMax<qint64>(transfer.rate, 1);
+    transfer.credit = static_cast<double>(transfer.rate) * tickMs / 1000.0;
+    if (writeSome(transfer)) {
+        return;
+    }
+    ConnectionQueue::acquire(transfer.socket);
+    if (transfers.empty()) {
+        lastTickNs = clock.nsecsElapsed();
+        timer.start();
+    }
+    transfers.push_back(std::move(transfer));
+}
+
+void BandwidthThrottle::advance()
+{
+    qint64 now = clock.nsecsElapsed();
+    double elapsed = static_cast<double>(now - lastTickNs) / 1e9;
+    lastTickNs = now;
+
+    for (size_t i = 0; i < transfers.size(); ) {
+        Transfer& transfer = transfers[i];
+        // A client that stops reading does not build up a burst: at most the
+        // time since the last tick is credited, one tick even when on time.
+        // Less than a byte always carries over, or low rates would never
+        // send a byte or lose their fractions.
+        double maxCredit = static_cast<double>(transfer.rate) * qMax(elapsed, tickMs / 1000.0) + 1.0;
+        transfer.credit = qMin(transfer.credit + elapsed * static_cast<double>(transfer.rate), maxCredit);
+        if (writeSome(transfer)) {
+            if (transfer.socket) {
+                ConnectionQueue::release(transfer.socket);
+            }
+            // Order does not matter, the last entry takes the free place
+            if (i + 1 < transfers.size()) {
+                transfer = std::move(transfers.back());
+            }
+            transfers.pop_back();
+        } else {
+            ++i;
+        }
+    }
+
+    if (transfers.empty()) {
+        timer.stop();
+    }
+}
+
+bool BandwidthThrottle::writeSome(Transfer &transfer)
+{
+    QTcpSocket* socket = transfer.socket.data();
+    if (!socket || socket->state() != QAbstractSocket::ConnectedState) {
+        return true;
+    }
+    // Bytes still queued in the socket were paid for already, waiting for
+    // them keeps the rate on the wire and not just into the buffer
+    if (socket->bytesToWrite() > 0) {
+        return false;
+    }
+
+    qint64 budget = static_cast<qint64>(transfer.credit);
+    if (budget <= 0) {
+        return false;
+    }
+    transfer.credit -= static_cast<double>(budget);
+
+    if (!transfer.head.isEmpty()) {
+        qint64 len = qMin<qint64>(budget, transfer.head.size());
+        socket->write(transfer.head.constData(), len);
+        transfer.head.remove(0, static_cast<qsizetype>(len));
+        budget -= len;
+    }
+    while (budget > 0 && transfer.offset < transfer.end) {
+        qint64 len = qMin(budget, transfer.end - transfer.offset);
+        if (transfer.payload) {
+            QByteArray data = transfer.payload->slice(transfer.end, transfer.offset, len);
+            socket->write(data);
+            len = data.size();
+        } else {
+            QByteArray data = transfer.page->read(transfer.offset, len);
+            if (data.size() < len) {
+                // A live file was cut short, the response cannot be completed
+                socket->abort();
+                return true;
+            }
+            socket->write(data);
+        }
+        transfer.offset += len;
+        budget -= len;
+    }
+    return transfer.head.isEmpty() && transfer.offset >= transfer.end;
+}
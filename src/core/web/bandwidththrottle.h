@@ -0,0 +1,87 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BANDWIDTHTHROTTLE_H
+#define BANDWIDTHTHROTTLE_H
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include <memory>
+#include <vector>
+
+#include "pagedata.h"
+#include "syntheticpayload.h"
+
+class QTcpSocket;
+
+// Trickles responses out at a fixed rate per connection. All throttled
+// connections of a worker share one timer, on every tick each one gets the
+// bytes it earned since the last tick, so 10k slow connections cost one
+// list entry each instead of a timer each.
+class BandwidthThrottle : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int tickMs = 20;
+
+    explicit BandwidthThrottle(QObject* parent = nullptr);
+
+    // Takes over the whole response: the head, then length bytes of the
+    // body from start (the rest of the body when length is -1). The
+    // connection is held until the response is out.
+    void send(QTcpSocket* socket, qint64 bytesPerSecond, const QByteArray& head,
+              const std::shared_ptr<const PageData>& body, qint64 start = 0, qint64 length = -1);
+    void send(QTcpSocket* socket, qint64 bytesPerSecond, const QByteArray& head,
+              const std::shared_ptr<const SyntheticPayload>& body, qint64 length);
+    void clear();
+    int activeCount() const;
+
+private slots:
+    void advance();
+
+private:
+    struct Transfer {
+        QPointer<QTcpSocket> socket;
+        qint64 rate;
+        // Bytes earned but not written yet, a fraction carries over
+        double credit = 0;
+        QByteArray head;
+        std::shared_ptr<const PageData> page;
+        std::shared_ptr<const SyntheticPayload> payload;
+        qint64 offset = 0;
+        qint64 end = 0;
+    };
+
+    void add(Transfer&& transfer);
+    // True once everything is written or the connection is gone
+    static bool writeSome(Transfer& transfer);
+
+    std::vector<Transfer> transfers;
+    QTimer timer;
+    QElapsedTimer clock;
+    qint64 lastTickNs = 0;
+};
+
+#endif // BANDWIDTHTHROTTLE_H
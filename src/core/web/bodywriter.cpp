@@ -0,0 +1,185 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bodywriter.h"
+#include "socketutils.h"
+#include "connectionqueue.h"
+
+#include <QTcpSocket>
+
+void BodyWriter::write(QTcpSocket *target, const std::shared_ptr<const PageData> &body,
+                       qint64 start, qint64 length)
+{
+    if (length < 0) {
+        length = body->size() - start;
+    }
+    if (length < streamThreshold) {
+        QByteArray data = body->read(start, length);
+        target->write(data);
+        if (data.size() < length) {
+            // A live file was cut short, the promised length cannot be kept
+            target->abort();
+        }
+        return;
+    }
+    BodyWriter* writer = new BodyWriter(target, body, start, start + length);
+    writer->writeMore();
+}
+
+void BodyWriter::write(QTcpSocket *target, const std::shared_ptr<const SyntheticPayload> &body, qint64 length)
+{
+    if (length < streamThreshold) {
+        for (qint64 offset = 0; offset < length; ) {
+            QByteArray data = body->slice(length, offset, length - offset);
+            target->write(data);
+            offset += data.size();
+        }
+        return;
+    }
+    BodyWriter* writer = new BodyWriter(target, body, length, length);
+    writer->writeMore();
+}
+
+void BodyWriter::writeTruncated(QTcpSocket *target, const std::shared_ptr<const PageData> &body,
+                                qint64 start, qint64 length)
+{
+    BodyWriter* writer = new BodyWriter(target, body, start, start + length);
+    writer->closeWhenDone = true;
+    writer->writeMore();
+}
+
+void BodyWriter::writeTruncated(QTcpSocket *target, const std::shared_ptr<const SyntheticPayload> &body,
+                                qint64 size, qint64 length)
+{
+    BodyWriter* writer = new BodyWriter(target, body, size, length);
+    writer->closeWhenDone = true;
+    writer->writeMore();
+}
+
+BodyWriter::BodyWriter(QTcpSocket *target, const std::shared_ptr<const PageData> &body, qint64 start, qint64 stop)
+    : QObject(target),
+      socket(target),
+      page(body),
+      offset(start),
+      end(stop),
+      useSendFile(body->fileHandle() != -1 && SocketUtils::canSendFile())
+{
+    ConnectionQueue::acquire(socket);
+    connect(socket, &QTcpSocket::bytesWritten, this, &BodyWriter::writeMore);
+    connect(socket, &QTcpSocket::disconnected, this, &BodyWriter::finish);
+}
+
+BodyWriter::BodyWriter(QTcpSocket *target, const std::shared_ptr<const SyntheticPayload> &body,
+                       qint64 size, qint64 stop)
+    : QObject(target),
+      socket(target),
+      payload(body),
+      payloadSize(size),
+      offset(0),
+      end(stop),
+      useSendFile(false)
+{
+    ConnectionQueue::acquire(socket);
+    connect(socket, &QTcpSocket::bytesWritten, this, &BodyWriter::writeMore);
+    connect(socket, &QTcpSocket::disconnected, this, &BodyWriter::finish);
+}
+
+void BodyWriter::writeMore()
+{
+    if (finished) {
+        return;
+    }
+    if (!useSendFile) {
+        // Keep no more than one chunk queued in the socket
+        while (offset < end && socket->bytesToWrite() < chunkSize) {
+            if (!writeChunk()) {
+                abortTransfer();
+                return;
+            }
+        }
+        if (offset >= end) {
+            finish();
+        }
+        return;
+    }
+
+    // The head and any chunk queued in the socket go out first
+    if (socket->bytesToWrite() > 0) {
+        return;
+    }
+    while (offset < end) {
+        qint64 sent = SocketUtils::sendFile(socket, page->fileHandle(), offset, end - offset);
+        if (sent > 0) {
+            offset += sent;
+            sentAny = true;
+        } else if (sent == 0) {
+            // The socket is full. A chunk queued in the socket tells us when
+            // it drains, bytesWritten() then resumes sendfile().
+            if (!writeChunk()) {
+                abortTransfer();
+            }
+            return;
+        } else if (sent == -1 && !sentAny) {
+            useSendFile = false;
+            writeMore();
+            return;
+        } else {
+            // Also a file that became shorter than its Content-Length
+            abortTransfer();
+            return;
+        }
+    }
+    finish();
+}
+
+bool BodyWriter::writeChunk()
+{
+    qint64 len = qMin(chunkSize, end - offset);
+    QByteArray data = payload ? payload->slice(payloadSize, offset, len) : page->read(offset, len);
+    if (data.isEmpty()) {
+        return false;
+    }
+    socket->write(data);
+    offset += data.size();
+    sentAny = true;
+    return true;
+}
+
+void BodyWriter::abortTransfer()
+{
+    socket->abort();
+    finish();
+}
+
+void BodyWriter::finish()
+{
+    if (finished) {
+        return;
+    }
+    finished = true;
+    if (closeWhenDone) {
+        // Queued bytes still go out before the connection closes
+        socket->disconnectFromHost();
+    }
+    // The next response on the connection may start
+    ConnectionQueue::release(socket);
+    deleteLater();
+}
@@ -0,0 +1,83 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BODYWRITER_H
+#define BODYWRITER_H
+
+#include <QObject>
+
+#include <memory>
+
+#include "pagedata.h"
+#include "syntheticpayload.h"
+
+class QTcpSocket;
+
+// Writes a response body without queueing it whole in the socket's write
+// buffer. Mapped pages go through sendfile() where available; everything
+// else is queued in chunks as the socket drains. Until the body is out the
+// connection is held, later responses on it wait in its ConnectionQueue.
+class BodyWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Smaller bodies are simply written to the socket
+    static const qint64 streamThreshold = 256 * 1024;
+    static const qint64 chunkSize = 64 * 1024;
+
+    // Writes length bytes from start, the rest of the body when length is -1.
+    // Whatever the body size, at most one chunk waits in the socket.
+    static void write(QTcpSocket* target, const std::shared_ptr<const PageData>& body,
+                      qint64 start = 0, qint64 length = -1);
+    // Writes a generated body of length bytes
+    static void write(QTcpSocket* target, const std::shared_ptr<const SyntheticPayload>& body, qint64 length);
+    // Write the first length bytes of the body and close the connection,
+    // as a server dying halfway through the response would
+    static void writeTruncated(QTcpSocket* target, const std::shared_ptr<const PageData>& body,
+                               qint64 start, qint64 length);
+    static void writeTruncated(QTcpSocket* target, const std::shared_ptr<const SyntheticPayload>& body,
+                               qint64 size, qint64 length);
+
+private:
+    BodyWriter(QTcpSocket* target, const std::shared_ptr<const PageData>& body, qint64 start, qint64 stop);
+    BodyWriter(QTcpSocket* target, const std::shared_ptr<const SyntheticPayload>& body, qint64 size, qint64 stop);
+
+    void writeMore();
+    // False when there is nothing left to read
+    bool writeChunk();
+    void abortTransfer();
+    void finish();
+
+    QTcpSocket* socket;
+    std::shared_ptr<const PageData> page;
+    std::shared_ptr<const SyntheticPayload> payload;
+    qint64 payloadSize = 0;
+    qint64 offset;
+    qint64 end;
+    bool useSendFile;
+    // sendfile() failing before any byte went out falls back to writes
+    bool sentAny = false;
+    bool finished = false;
+    bool closeWhenDone = false;
+};
+
+#endif // BODYWRITER_H
@@ -0,0 +1,181 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cachedresponse.h"
+#include "bodywriter.h"
+#include "httpvalidators.h"
+
+#include <QMimeDatabase>
+#include <QTcpSocket>
+
+CachedResponse::CachedResponse(const QByteArray &body, int statusCode)
+    : CachedResponse(PageData::fromBytes(body), statusCode)
+{
+
+}
+
+CachedResponse::CachedResponse(const std::shared_ptr<const PageData> &body, int statusCode,
+                               const QByteArray &extraHeaders, const QByteArray &type,
+                               const QByteArray &entityTag, const QDateTime &modified)
+    : page(body),
+      bodyBytes(body->bytes()),
+      mimeType(type),
+      tag(entityTag),
+      modifiedTime(modified),
+      code(statusCode)
+{
+    if (mimeType.isEmpty()) {
+        QMimeDatabase mimeDb;
+        mimeType = (page->fileName().isEmpty()
+                    ? mimeDb.mimeTypeForData(bodyBytes)
+                    : mimeDb.mimeTypeForFileNameAndData(page->fileName(), bodyBytes)).name().toLatin1();
+    }
+
+    headBytes.reserve(128 + extraHeaders.size());
+    headBytes.append("HTTP/1.1 ").append(QByteArray::number(code)).append(' ');
+    headBytes.append(reasonPhrase(code)).append("\r\n");
+    headBytes.append("Content-Type: ").append(mimeType).append("\r\n");
+    headBytes.append("Content-Length: ").append(QByteArray::number(bodyBytes.size())).append("\r\n");
+    if (!tag.isEmpty()) {
+        headBytes.append("ETag: ").append(tag).append("\r\n");
+        headBytes.append("Last-Modified: ").append(HttpValidators::formatDate(modifiedTime)).append("\r\n");
+    }
+    headBytes.append(extraHeaders);
+    headBytes.append("\r\n");
+
+    if (!tag.isEmpty()) {
+        // Representation headers such as Content-Encoding are left out of
+        // the 304, Vary is kept
+        QByteArray vary;
+        const QList<QByteArray> lines = extraHeaders.split('\n');
+        for (const QByteArray& line : lines) {
+            if (line.toLower().startsWith("vary:")) {
+                vary.append(line).append('\n');
+            }
+        }
+        notModifiedBytes = HttpValidators::notModifiedHead(tag, modifiedTime, vary);
+    }
+}
+
+const QByteArray &CachedResponse::head() const
+{
+    return headBytes;
+}
+
+const QByteArray &CachedResponse::body() const
+{
+    return bodyBytes;
+}
+
+const std::shared_ptr<const PageData> &CachedResponse::bodyData() const
+{
+    return page;
+}
+
+int CachedResponse::statusCode() const
+{
+    return code;
+}
+
+const QByteArray &CachedResponse::contentType() const
+{
+    return mimeType;
+}
+
+const QByteArray &CachedResponse::etag() const
+{
+    return tag;
+}
+
+const QDateTime &CachedResponse::lastModified() const
+{
+    return modifiedTime;
+}
+
+const QByteArray &CachedResponse::notModifiedHead() const
+{
+    return notModifiedBytes;
+}
+
+void CachedResponse::write(QTcpSocket *socket) const
+{
+    socket->write(headBytes);
+    BodyWriter::write(socket, page);
+}
+
+QByteArray CachedResponse::reasonPhrase(int statusCode)
+{
+    switch (statusCode) {
+    case 100: return "Continue";
+    case 101: return "Switching Protocols";
+    case 102: return "Processing";
+    case 103: return "Early Hints";
+    case 200: return "OK";
+    case 201: return "Created";
+    case 202: return "Accepted";
+    case 203: return "Non-Authoritative Information";
+    case 204: return "No Content";
+    case 205: return "Reset Content";
+    case 206: return "Partial Content";
+    case 207: return "Multi-Status";
+    case 208: return "Already Reported";
+    case 226: return "IM Used";
+    case 300: return "Multiple Choices";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 303: return "See Other";
+    case 304: return "Not Modified";
+    case 305: return "Use Proxy";
+    case 307: return "Temporary Redirect";
+    case 308: return "Permanent Redirect";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 402: return "Payment Required";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 406: return "Not Acceptable";
+    case 407: return "Proxy Authentication Required";
+    case 408: return "Request Timeout";
+    case 409: return "Conflict";
+    case 410: return "Gone";
+    case 411: return "Length Required";
+    case 412: return "Precondition Failed";
+    case 413: return "Payload Too Large";
+    case 414: return "URI Too Long";
+    case 415: return "Unsupported Media Type";
+    case 416: return "Range Not Satisfiable";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    case 504: return "Gateway Timeout";
+    case 505: return "HTTP Version Not Supported";
+    case 506: return "Variant Also Negotiates";
+    case 507: return "Insufficient Storage";
+    case 508: return "Loop Detected";
+    case 510: return "Not Extended";
+    case 511: return "Network Authentication Required";
+    default:
+        return "";
+    }
+}
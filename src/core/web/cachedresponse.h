@@ -0,0 +1,71 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CACHEDRESPONSE_H
+#define CACHEDRESPONSE_H
+
+#include <QByteArray>
+#include <QDateTime>
+
+#include <memory>
+
+#include "pagedata.h"
+
+class QTcpSocket;
+
+// Immutable, fully serialized HTTP response. Built once when the page or the
+// status code changes, then written as is for every request.
+class CachedResponse
+{
+public:
+    CachedResponse(const QByteArray& body, int statusCode);
+    // Extra headers are complete lines, each ending with CRLF. The content
+    // type is detected from the body when empty. A response with an entity
+    // tag also sends ETag and Last-Modified and keeps its 304 head ready.
+    CachedResponse(const std::shared_ptr<const PageData>& body, int statusCode,
+                   const QByteArray& extraHeaders = QByteArray(), const QByteArray& type = QByteArray(),
+                   const QByteArray& entityTag = QByteArray(), const QDateTime& modified = QDateTime());
+
+    const QByteArray& head() const;
+    const QByteArray& body() const;
+    const std::shared_ptr<const PageData>& bodyData() const;
+    int statusCode() const;
+    const QByteArray& contentType() const;
+    const QByteArray& etag() const;
+    const QDateTime& lastModified() const;
+    const QByteArray& notModifiedHead() const;
+
+    void write(QTcpSocket* socket) const;
+
+    static QByteArray reasonPhrase(int statusCode);
+
+private:
+    QByteArray headBytes;
+    std::shared_ptr<const PageData> page;
+    QByteArray bodyBytes;
+    QByteArray mimeType;
+    QByteArray tag;
+    QDateTime modifiedTime;
+    QByteArray notModifiedBytes;
+    int code;
+};
+
+#endif // CACHEDRESPONSE_H
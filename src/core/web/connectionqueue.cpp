@@ -0,0 +1,92 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "connectionqueue.h"
+
+#include <QTcpSocket>
+
+bool ConnectionQueue::isBusy(QTcpSocket *socket)
+{
+    ConnectionQueue* queue = find(socket);
+    return queue && (queue->writers > 0 || (!queue->waiting.empty() && !queue->draining));
+}
+
+void ConnectionQueue::acquire(QTcpSocket *socket)
+{
+    ++get(socket)->writers;
+}
+
+void ConnectionQueue::release(QTcpSocket *socket)
+{
+    ConnectionQueue* queue = find(socket);
+    if (!queue || queue->writers == 0) {
+        return;
+    }
+    --queue->writers;
+    // The next response starts from the event loop, not from inside the
+    // writer that just finished
+    if (queue->writers == 0 && !queue->waiting.empty() && !queue->drainScheduled) {
+        queue->drainScheduled = true;
+        QMetaObject::invokeMethod(queue, &ConnectionQueue::drain, Qt::QueuedConnection);
+    }
+}
+
+void ConnectionQueue::enqueue(QTcpSocket *socket, std::function<void ()> &&response)
+{
+    get(socket)->waiting.push_back(std::move(response));
+}
+
+ConnectionQueue::ConnectionQueue(QTcpSocket *socket)
+    : QObject(socket),
+      connection(socket)
+{
+    // Nobody reads the answers of a closed connection
+    connect(socket, &QTcpSocket::disconnected, this, [this]() {
+        waiting.clear();
+    });
+}
+
+ConnectionQueue *ConnectionQueue::find(QTcpSocket *socket)
+{
+    return socket->findChild<ConnectionQueue*>(QString(), Qt::FindDirectChildrenOnly);
+}
+
+ConnectionQueue *ConnectionQueue::get(QTcpSocket *socket)
+{
+    ConnectionQueue* queue = find(socket);
+    return queue ? queue : new ConnectionQueue(socket);
+}
+
+void ConnectionQueue::drain()
+{
+    drainScheduled = false;
+    draining = true;
+    while (writers == 0 && !waiting.empty()) {
+        if (connection->state() != QAbstractSocket::ConnectedState) {
+            waiting.clear();
+            break;
+        }
+        std::function<void()> response = std::move(waiting.front());
+        waiting.pop_front();
+        response();
+    }
+    draining = false;
+}
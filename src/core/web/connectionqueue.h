@@ -0,0 +1,64 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONNECTIONQUEUE_H
+#define CONNECTIONQUEUE_H
+
+#include <QObject>
+
+#include <deque>
+#include <functional>
+
+class QTcpSocket;
+
+// Keeps the responses of one keep-alive connection in order. A writer that
+// streams a body after the handler returned holds the connection, responses
+// to the requests behind it wait until it lets go. Lives as a child of the
+// socket, so it goes together with the connection.
+class ConnectionQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    // True while a body streams or earlier responses still wait
+    static bool isBusy(QTcpSocket* socket);
+    // Streaming writers hold the connection until release()
+    static void acquire(QTcpSocket* socket);
+    static void release(QTcpSocket* socket);
+    // Runs once the responses before it are written
+    static void enqueue(QTcpSocket* socket, std::function<void()>&& response);
+
+private:
+    explicit ConnectionQueue(QTcpSocket* socket);
+
+    static ConnectionQueue* find(QTcpSocket* socket);
+    static ConnectionQueue* get(QTcpSocket* socket);
+    void drain();
+
+    QTcpSocket* connection;
+    std::deque<std::function<void()>> waiting;
+    int writers = 0;
+    bool drainScheduled = false;
+    // The response running from the queue is not held up by those behind it
+    bool draining = false;
+};
+
+#endif // CONNECTIONQUEUE_H
@@ -0,0 +1,292 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "diagtcpserver.h"
+#include "socketutils.h"
+
+#include <QtEndian>
+#include <QTcpSocket>
+
+#include <iterator>
+
+#ifdef Q_OS_UNIX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+// Longer request heads are not waited for
+static const qint64 maxHeadSize = 64 * 1024;
+
+std::atomic<int> DiagTcpServer::instanceCount{0};
+
+DiagTcpServer::DiagTcpServer(QObject *parent) : QTcpServer(parent)
+{
+    ++instanceCount;
+    bounceTimer.setTimerType(Qt::PreciseTimer);
+    bounceTimer.setInterval(bounceIntervalMs);
+    connect(&bounceTimer, &QTimer::timeout, this, &DiagTcpServer::toggleListening);
+}
+
+DiagTcpServer::~DiagTcpServer()
+{
+    releaseHeld();
+    closeHeadReaders();
+    --instanceCount;
+}
+
+bool DiagTcpServer::listen(const QHostAddress &address, quint16 port, bool reusePort)
+{
+    bool res = reusePort ? listenReusePort(address, port) : QTcpServer::listen(address, port);
+    if (res) {
+        // A reopened listener must come back on the same port
+        listenAddress = address;
+        listenPort = serverPort();
+        listenReuse = reusePort;
+    }
+    return res;
+}
+
+bool DiagTcpServer::listenReusePort(const QHostAddress &address, quint16 port)
+{
+#if defined(Q_OS_UNIX) && defined(SO_REUSEPORT)
+    QHostAddress bindAddress = address.isNull() ? QHostAddress(QHostAddress::Any) : address;
+    bool ipv4 = bindAddress.protocol() == QAbstractSocket::IPv4Protocol;
+
+    int fd = ::socket(ipv4 ? AF_INET : AF_INET6, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+
+    int res;
+    if (ipv4) {
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = qToBigEndian(port);
+        addr.sin_addr.s_addr = qToBigEndian(bindAddress.toIPv4Address());
+        res = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    } else {
+        int zero = 0;
+        ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+        sockaddr_in6 addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin6_family = AF_INET6;
+        addr.sin6_port = qToBigEndian(port);
+        Q_IPV6ADDR ip6 = bindAddress.toIPv6Address();
+        std::memcpy(&addr.sin6_addr, ip6.c, sizeof(ip6.c));
+        res = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    }
+
+    if (res != 0 || ::listen(fd, SOMAXCONN) != 0 || !setSocketDescriptor(fd)) {
+        ::close(fd);
+        return false;
+    }
+    return true;
+#else
+    // listen() of this class hides the one of QTcpServer
+    return QTcpServer::listen(address, port);
+#endif
+}
+
+void DiagTcpServer::setTcpFault(TcpFault newFault)
+{
+    if (newFault == fault) {
+        return;
+    }
+
+    // Undo the old mode first
+    switch (fault) {
+    case TcpFault::NoRead:
+        releaseHeld();
+        break;
+    case TcpFault::CloseAfterHeaders:
+        closeHeadReaders();
+        break;
+    case TcpFault::PauseAccept:
+        resumeAccepting();
+        break;
+    case TcpFault::Bounce:
+        bounceTimer.stop();
+        if (!isListening()) {
+            listen(listenAddress, listenPort, listenReuse);
+        }
+        break;
+    case TcpFault::None:
+    case TcpFault::Reset:
+        break;
+    }
+
+    fault = newFault;
+    switch (fault) {
+    case TcpFault::PauseAccept:
+        pauseAccepting();
+        break;
+    case TcpFault::Bounce:
+        bounceTimer.start();
+        break;
+    case TcpFault::None:
+    case TcpFault::Reset:
+    case TcpFault::NoRead:
+    case TcpFault::CloseAfterHeaders:
+        break;
+    }
+}
+
+TcpFault DiagTcpServer::tcpFault() const
+{
+    return fault;
+}
+
+void DiagTcpServer::shutdown()
+{
+    bounceTimer.stop();
+    releaseHeld();
+    closeHeadReaders();
+    fault = TcpFault::None;
+    close();
+}
+
+int DiagTcpServer::heldConnectionCount() const
+{
+    return static_cast<int>(held.size() + headReaders.size());
+}
+
+int DiagTcpServer::heldConnectionLimit() const
+{
+    if (heldLimit > 0) {
+        return heldLimit;
+    }
+    // Every worker has a listener, they split the share between them
+    return qMax(16, SocketUtils::descriptorLimit() / 2 / qMax(1, instanceCount.load()));
+}
+
+void DiagTcpServer::setHeldConnectionLimit(int limit)
+{
+    heldLimit = limit;
+}
+
+void DiagTcpServer::incomingConnection(qintptr socketDescriptor)
+{
+    switch (fault) {
+    case TcpFault::Reset:
+        SocketUtils::resetDescriptor(socketDescriptor);
+        return;
+    case TcpFault::NoRead:
+        // The kernel buffers the request, nobody ever reads it
+        held.push_back(socketDescriptor);
+        if (held.size() > static_cast<size_t>(heldConnectionLimit())) {
+            SocketUtils::closeDescriptor(held.front());
+            held.pop_front();
+        }
+        return;
+    case TcpFault::CloseAfterHeaders:
+        closeAfterHeaders(socketDescriptor);
+        return;
+    case TcpFault::None:
+    case TcpFault::PauseAccept:
+    case TcpFault::Bounce:
+        break;
+    }
+    QTcpServer::incomingConnection(socketDescriptor);
+}
+
+void DiagTcpServer::toggleListening()
+{
+    // While closed the kernel refuses connections with RST, a port that
+    // cannot be taken back is retried on the next tick
+    if (isListening()) {
+        close();
+    } else {
+        listen(listenAddress, listenPort, listenReuse);
+    }
+}
+
+void DiagTcpServer::closeAfterHeaders(qintptr socketDescriptor)
+{
+    QTcpSocket* socket = new QTcpSocket(this);
+    if (!socket->setSocketDescriptor(socketDescriptor)) {
+        delete socket;
+        SocketUtils::closeDescriptor(socketDescriptor);
+        return;
+    }
+    if (headReaders.size() >= static_cast<size_t>(heldConnectionLimit())) {
+        QTcpSocket* oldest = headReaders.front();
+        headReaders.pop_front();
+        oldest->disconnect(this);
+        oldest->abort();
+        oldest->deleteLater();
+    }
+    headReaders.push_back(socket);
+    auto entry = std::prev(headReaders.end());
+    connect(socket, &QTcpSocket::disconnected, this, [this, socket, entry]() {
+        headReaders.erase(entry);
+        socket->deleteLater();
+    });
+    // A client that never finishes its head does not keep the descriptor
+    QTimer::singleShot(headTimeoutMs, socket, [socket]() {
+        socket->abort();
+    });
+    connect(socket, &QTcpSocket::readyRead, socket, [socket]() {
+        while (socket->canReadLine()) {
+            QByteArray line = socket->readLine();
+            if (line == "\r\n" || line == "\n") {
+                socket->disconnectFromHost();
+                return;
+            }
+        }
+        if (socket->bytesAvailable() > maxHeadSize) {
+            socket->disconnectFromHost();
+        }
+    });
+}
+
+void DiagTcpServer::releaseHeld()
+{
+    for (qintptr descriptor : held) {
+        SocketUtils::closeDescriptor(descriptor);
+    }
+    held.clear();
+}
+
+void DiagTcpServer::closeHeadReaders()
+{
+    for (QTcpSocket* socket : headReaders) {
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+    }
+    headReaders.clear();
+}
+
+bool DiagTcpServer::isReusePortSupported()
+{
+#if defined(Q_OS_UNIX) && defined(SO_REUSEPORT)
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,94 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DIAGTCPSERVER_H
+#define DIAGTCPSERVER_H
+
+#include <QTcpServer>
+#include <QTimer>
+
+#include <atomic>
+#include <deque>
+#include <list>
+
+#include "webserverdata.h"
+
+class QTcpSocket;
+
+// Listener that can fail below HTTP. Connections it fails never reach the
+// QHttpServer, the others are passed on unchanged.
+class DiagTcpServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    static const int bounceIntervalMs = 5;
+    // A client of TcpFault::CloseAfterHeaders that sends no complete head
+    // in this time is closed
+    static const int headTimeoutMs = 10000;
+
+    DiagTcpServer(QObject* parent = nullptr);
+    ~DiagTcpServer();
+
+    bool listen(const QHostAddress& address, quint16 port, bool reusePort);
+    // Several servers may listen on the same address and port, the kernel
+    // balances incoming connections between them (SO_REUSEPORT)
+    bool listenReusePort(const QHostAddress& address, quint16 port);
+
+    void setTcpFault(TcpFault fault);
+    TcpFault tcpFault() const;
+    // Closes the listener and whatever its fault holds. Unlike going back
+    // to TcpFault::None, a bouncing listener is not opened once more.
+    void shutdown();
+
+    // Connections kept open by TcpFault::NoRead and CloseAfterHeaders, the
+    // oldest is closed beyond the limit. By default half of the process's
+    // descriptors, shared by all listeners, so that accept() never runs out.
+    int heldConnectionCount() const;
+    int heldConnectionLimit() const;
+    void setHeldConnectionLimit(int limit);
+
+    static bool isReusePortSupported();
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override;
+
+private slots:
+    void toggleListening();
+
+private:
+    void closeAfterHeaders(qintptr socketDescriptor);
+    void releaseHeld();
+    void closeHeadReaders();
+
+    static std::atomic<int> instanceCount;
+
+    TcpFault fault = TcpFault::None;
+    std::deque<qintptr> held;
+    std::list<QTcpSocket*> headReaders;
+    int heldLimit = 0;
+    QTimer bounceTimer;
+    QHostAddress listenAddress;
+    quint16 listenPort = 0;
+    bool listenReuse = false;
+};
+
+#endif // DIAGTCPSERVER_H
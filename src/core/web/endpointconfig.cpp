@@ -0,0 +1,114 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "endpointconfig.h"
+#include "sizeutils.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+
+QList<EndpointConfig> EndpointConfig::loadList(const QString &fileName, QString *error)
+{
+    QList<EndpointConfig> res;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = "Cannot open " + fileName;
+        return res;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isArray()) {
+        *error = "Invalid endpoint list " + fileName + ": " +
+                 (doc.isArray() ? parseError.errorString() : QString("array expected"));
+        return res;
+    }
+
+    QDir baseDir = QFileInfo(fileName).absoluteDir();
+    const QJsonArray items = doc.array();
+    for (const QJsonValue& item : items) {
+        QJsonObject obj = item.toObject();
+
+        EndpointConfig endpoint;
+        endpoint.path = obj.value("path").toString();
+        if (endpoint.path.isEmpty() || endpoint.path.at(0) != '/') {
+            *error = "Invalid endpoint path: \"" + endpoint.path + "\"";
+            return QList<EndpointConfig>();
+        }
+        endpoint.responseCode = obj.value("code").toInt(200);
+        QJsonValue delay = obj.value("delay");
+        if (delay.isString()) {
+            if (!LatencyDistribution::parse(delay.toString(), &endpoint.delay, error)) {
+                return QList<EndpointConfig>();
+            }
+        } else {
+            endpoint.delay = LatencyDistribution::constant(delay.toInt(0));
+        }
+        endpoint.responding = obj.value("responding").toBool(true);
+        endpoint.listen = obj.value("listen").toBool(true);
+        if (!FaultPlan::parse(obj.value("faults").toString(), &endpoint.faults, error)) {
+            *error += " for " + endpoint.path;
+            return QList<EndpointConfig>();
+        }
+        QJsonValue bandwidth = obj.value("bandwidth");
+        if (bandwidth.isString()) {
+            if (!SizeUtils::parseSize(bandwidth.toString(), &endpoint.bandwidth)) {
+                *error = "Invalid bandwidth of " + endpoint.path + ": " + bandwidth.toString();
+                return QList<EndpointConfig>();
+            }
+        } else {
+            endpoint.bandwidth = qMax<qint64>(bandwidth.toInteger(0), 0);
+        }
+
+        std::shared_ptr<const PageData> body;
+        if (obj.contains("payload")) {
+            endpoint.payload = SyntheticPayload::parse(obj.value("payload").toString(), error);
+            if (!endpoint.payload) {
+                return QList<EndpointConfig>();
+            }
+            body = PageData::fromBytes(QByteArray());
+        } else if (obj.contains("page")) {
+            // Served from a private copy, the file may be rewritten or cut
+            // short while workers send it
+            QString fileName = baseDir.absoluteFilePath(obj.value("page").toString());
+            bool changed = true;
+            for (int attempt = 0; attempt < 3 && !body && changed; ++attempt) {
+                body = PageData::snapshot(fileName, error, &changed);
+            }
+            if (!body) {
+                *error += " for " + endpoint.path;
+                return QList<EndpointConfig>();
+            }
+        } else {
+            body = PageData::fromBytes(obj.value("body").toString().toUtf8());
+        }
+        endpoint.response = std::make_shared<const CachedResponse>(body, endpoint.responseCode);
+
+        res.append(endpoint);
+    }
+
+    return res;
+}
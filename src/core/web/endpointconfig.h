@@ -0,0 +1,59 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENDPOINTCONFIG_H
+#define ENDPOINTCONFIG_H
+
+#include <QString>
+#include <QList>
+
+#include <memory>
+
+#include "cachedresponse.h"
+#include "latencydistribution.h"
+#include "faultplan.h"
+#include "syntheticpayload.h"
+
+// Behavior of a single endpoint. The main endpoint (the one set in the
+// GUI/CLI) takes its settings from WebServerData instead.
+struct EndpointConfig
+{
+    QString path;
+    int responseCode = 200;
+    LatencyDistribution delay;
+    bool responding = true;
+    bool listen = true;
+    bool mainEndpoint = false;
+    std::shared_ptr<const CachedResponse> response;
+    // Generated body, replaces the response body when set
+    std::shared_ptr<const SyntheticPayload> payload;
+    // Bytes per second of every connection, 0 is unlimited
+    qint64 bandwidth = 0;
+    FaultPlan faults;
+
+    // JSON array of objects: path, code, delay (ms or distribution spec),
+    // responding, listen, bandwidth (bytes/s, "64k" style sizes allowed),
+    // faults (FaultPlan spec), and either page (file path, relative to the JSON
+    // file), body or payload (SyntheticPayload spec)
+    static QList<EndpointConfig> loadList(const QString& fileName, QString* error);
+};
+
+#endif // ENDPOINTCONFIG_H
@@ -0,0 +1,79 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FASTRANDOM_H
+#define FASTRANDOM_H
+
+#include <QtGlobal>
+
+// xoshiro256** generator. Not thread safe, every worker owns one.
+class FastRandom
+{
+public:
+    explicit FastRandom(quint64 seed = 0)
+    {
+        // splitmix64 expands the seed to the full state
+        for (quint64& s : state) {
+            seed += 0x9e3779b97f4a7c15ULL;
+            quint64 z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            s = z ^ (z >> 31);
+        }
+    }
+
+    quint64 next()
+    {
+        const quint64 result = rotl(state[1] * 5, 7) * 9;
+        const quint64 t = state[1] << 17;
+
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+
+        return result;
+    }
+
+    // Uniform in (0, 1), never returns 0 so it is safe for log()
+    double nextDouble()
+    {
+        return (static_cast<double>(next() >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+    }
+
+    // Uniform in [0, bound)
+    quint32 nextBounded(quint32 bound)
+    {
+        return static_cast<quint32>(((next() >> 32) * bound) >> 32);
+    }
+
+private:
+    static quint64 rotl(quint64 x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    quint64 state[4];
+};
+
+#endif // FASTRANDOM_H
@@ -0,0 +1,185 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "faultplan.h"
+
+#include <QStringList>
+
+FaultPlan::FaultPlan()
+{
+
+}
+
+bool FaultPlan::parse(const QString &spec, FaultPlan *res, QString *error)
+{
+    QString str = spec.trimmed();
+    QVector<Fault> faults;
+    QVector<double> weights;
+    double total = 0;
+
+    const QStringList items = str.split(',', Qt::SkipEmptyParts);
+    for (const QString& item : items) {
+        QString name = item.section('=', 0, 0).trimmed().toLower();
+        QString share = item.section('=', 1).trimmed();
+        if (share.endsWith('%')) {
+            share.chop(1);
+        }
+        bool ok = false;
+        double percent = share.toDouble(&ok);
+        if (!ok || percent < 0) {
+            *error = "Invalid share of \"" + name + "\" in " + str;
+            return false;
+        }
+
+        Fault fault;
+        int code = name.toInt(&ok);
+        if (ok && code >= 100 && code <= 599) {
+            fault.action = Action::Status;
+            fault.statusCode = code;
+        } else if (name == "hang") {
+            fault.action = Action::Hang;
+        } else if (name == "reset") {
+            fault.action = Action::Reset;
+        } else if (name == "truncate") {
+            fault.action = Action::Truncate;
+        } else {
+            *error = "Unknown fault \"" + name + "\", expected a status code, hang, reset or truncate";
+            return false;
+        }
+        faults.append(fault);
+        weights.append(percent);
+        total += percent;
+    }
+
+    if (total > 100) {
+        *error = "Faults add up to more than 100% in " + str;
+        return false;
+    }
+
+    FaultPlan plan;
+    if (total > 0) {
+        // The rest of the requests is answered normally
+        faults.append(Fault());
+        weights.append(100 - total);
+        plan.table = buildTable(faults, weights);
+        plan.spec = str;
+    }
+    *res = plan;
+    return true;
+}
+
+const char *FaultPlan::actionName(Action action)
+{
+    switch (action) {
+    case Action::Status:
+        return "status";
+    case Action::Hang:
+        return "hang";
+    case Action::Reset:
+        return "reset";
+    case Action::Truncate:
+        return "truncate";
+    case Action::None:
+        break;
+    }
+    return "none";
+}
+
+bool FaultPlan::isEmpty() const
+{
+    return !table;
+}
+
+FaultPlan::Fault FaultPlan::sample(FastRandom &rng) const
+{
+    // No draw at all without faults, the delay sequence of a seed stays the same
+    if (!table) {
+        return Fault();
+    }
+
+    // One draw picks the column with its upper half and tosses the coin
+    // between the column and its alias with the lower half
+    quint64 bits = rng.next();
+    int column = static_cast<int>(((bits >> 32) * static_cast<quint64>(table->outcomes.size())) >> 32);
+    double coin = static_cast<double>(bits & 0xffffffffULL) * (1.0 / 4294967296.0);
+    int index = coin < table->probability.at(column) ? column : table->alias.at(column);
+    return table->outcomes.at(index);
+}
+
+QString FaultPlan::toString() const
+{
+    return spec;
+}
+
+std::shared_ptr<const FaultPlan::Table> FaultPlan::buildTable(const QVector<Fault> &faults,
+                                                               const QVector<double> &weights)
+{
+    // Vose's alias method: every column holds its own outcome with some
+    // probability and the alias outcome otherwise
+    auto res = std::make_shared<Table>();
+    const int count = static_cast<int>(faults.size());
+    double total = 0;
+    for (double weight : weights) {
+        total += weight;
+    }
+
+    res->outcomes = faults;
+    res->probability.resize(count);
+    res->alias.resize(count);
+
+    QVector<double> scaled(count);
+    QVector<int> small;
+    QVector<int> large;
+    for (int i = 0; i < count; ++i) {
+        scaled[i] = weights.at(i) * count / total;
+        if (scaled.at(i) < 1) {
+            small.append(i);
+        } else {
+            large.append(i);
+        }
+    }
+    while (!small.isEmpty() && !large.isEmpty()) {
+        int less = small.takeLast();
+        int more = large.last();
+        res->probability[less] = scaled.at(less);
+        res->alias[less] = more;
+        scaled[more] += scaled.at(less) - 1;
+        if (scaled.at(more) < 1) {
+            large.removeLast();
+            small.append(more);
+        }
+    }
+    // Whatever is left is 1 up to rounding
+    for (int i : std::as_const(large)) {
+        res->probability[i] = 1;
+        res->alias[i] = i;
+    }
+    for (int i : std::as_const(small)) {
+        res->probability[i] = 1;
+        res->alias[i] = i;
+    }
+    return res;
+}
+
+bool operator==(const FaultPlan &a, const FaultPlan &b)
+{
+    return a.toString() == b.toString();
+}
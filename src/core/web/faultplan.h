@@ -0,0 +1,79 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAULTPLAN_H
+#define FAULTPLAN_H
+
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+#include "fastrandom.h"
+
+// Faults injected into a share of the requests, drawn for every request.
+// Built from a spec such as "500=2,hang=1,reset=0.5,truncate=0.5": percent
+// of the requests answered with a status code, left hanging until the
+// client gives up, reset, or cut off halfway through the body. The rest is
+// answered normally. An alias table makes a draw O(1) whatever the number
+// of rules.
+class FaultPlan
+{
+public:
+    enum class Action {
+        None,
+        Status,
+        Hang,
+        Reset,
+        Truncate
+    };
+    static const int actionCount = 5;
+
+    struct Fault {
+        Action action = Action::None;
+        int statusCode = 0; // Action::Status only
+    };
+
+    FaultPlan();
+
+    static bool parse(const QString& spec, FaultPlan* res, QString* error);
+    static const char* actionName(Action action);
+
+    bool isEmpty() const;
+    Fault sample(FastRandom& rng) const;
+    QString toString() const;
+
+private:
+    struct Table {
+        QVector<Fault> outcomes;
+        QVector<double> probability;
+        QVector<int> alias;
+    };
+
+    static std::shared_ptr<const Table> buildTable(const QVector<Fault>& faults, const QVector<double>& weights);
+
+    QString spec;
+    std::shared_ptr<const Table> table;
+};
+
+bool operator==(const FaultPlan& a, const FaultPlan& b);
+
+#endif // FAULTPLAN_H
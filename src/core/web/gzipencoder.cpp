@@ -0,0 +1,125 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gzipencoder.h"
+
+#include <QList>
+
+#include <array>
+
+// qCompress output: 4 bytes of big-endian length, 2 bytes of zlib header,
+// the raw deflate stream and 4 bytes of adler32
+static const qsizetype qCompressPrefix = 4 + 2;
+static const qsizetype qCompressSuffix = 4;
+
+static const char gzipHeader[] = {
+    '\x1f', '\x8b', // magic
+    '\x08',         // deflate
+    '\x00',         // no flags
+    '\x00', '\x00', '\x00', '\x00', // no modification time
+    '\x00',         // no extra flags
+    '\xff'          // unknown OS
+};
+
+static std::array<quint32, 256> makeCrcTable()
+{
+    std::array<quint32, 256> table{};
+    for (quint32 i = 0; i < 256; ++i) {
+        quint32 c = i;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}
+
+static void appendLittleEndian(QByteArray& res, quint32 value)
+{
+    for (int i = 0; i < 4; ++i) {
+        res.append(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+bool GzipEncoder::isCompressible(qint64 size)
+{
+    return size >= minSize && size <= maxSize;
+}
+
+QByteArray GzipEncoder::compress(const QByteArray &data, int level)
+{
+    QByteArray zlib = qCompress(data, level);
+    if (zlib.size() < qCompressPrefix + qCompressSuffix) {
+        return QByteArray();
+    }
+
+    qsizetype deflateSize = zlib.size() - qCompressPrefix - qCompressSuffix;
+    QByteArray res;
+    res.reserve(static_cast<qsizetype>(sizeof(gzipHeader)) + deflateSize + 8);
+    res.append(gzipHeader, static_cast<qsizetype>(sizeof(gzipHeader)));
+    res.append(zlib.constData() + qCompressPrefix, deflateSize);
+    appendLittleEndian(res, crc32(data.constData(), data.size()));
+    // ISIZE is the input size modulo 2^32
+    appendLittleEndian(res, static_cast<quint32>(static_cast<quint64>(data.size()) & 0xffffffffu));
+    return res;
+}
+
+quint32 GzipEncoder::crc32(const char *data, qsizetype size, quint32 crc)
+{
+    static const std::array<quint32, 256> table = makeCrcTable();
+    crc = ~crc;
+    for (qsizetype i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<quint8>(data[i])) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+bool GzipEncoder::acceptsGzip(const QByteArray &acceptEncoding)
+{
+    // Codings are listed as "gzip;q=0.5, br", a quality of 0 means not acceptable
+    bool gzipListed = false;
+    bool gzipAccepted = false;
+    bool anyAccepted = false;
+    const QList<QByteArray> items = acceptEncoding.split(',');
+    for (const QByteArray& item : items) {
+        QList<QByteArray> params = item.split(';');
+        QByteArray coding = params.takeFirst().trimmed().toLower();
+        double quality = 1;
+        for (const QByteArray& param : std::as_const(params)) {
+            QByteArray trimmed = param.trimmed();
+            if (trimmed.startsWith("q=") || trimmed.startsWith("Q=")) {
+                bool ok = false;
+                quality = trimmed.mid(2).toDouble(&ok);
+                if (!ok) {
+                    quality = 0;
+                }
+            }
+        }
+
+        if (coding == "gzip" || coding == "x-gzip") {
+            gzipListed = true;
+            gzipAccepted = gzipAccepted || quality > 0;
+        } else if (coding == "*") {
+            anyAccepted = quality > 0;
+        }
+    }
+    return gzipListed ? gzipAccepted : anyAccepted;
+}
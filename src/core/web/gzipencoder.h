@@ -0,0 +1,45 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GZIPENCODER_H
+#define GZIPENCODER_H
+
+#include <QByteArray>
+
+// Builds gzip bodies for the Content-Encoding: gzip variant of a response.
+// The deflate stream comes from qCompress, only the framing is done here.
+class GzipEncoder
+{
+public:
+    // Bodies outside of these bounds are not worth compressing
+    static const qint64 minSize = 256;
+    static const qint64 maxSize = 64 * 1024 * 1024;
+
+    static bool isCompressible(qint64 size);
+    // Empty on failure
+    static QByteArray compress(const QByteArray& data, int level = 6);
+    static quint32 crc32(const char* data, qsizetype size, quint32 crc = 0);
+
+    // Whether an Accept-Encoding header value allows gzip, q=0 excludes it
+    static bool acceptsGzip(const QByteArray& acceptEncoding);
+};
+
+#endif // GZIPENCODER_H
@@ -0,0 +1,128 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "httprange.h"
+#include "httpvalidators.h"
+
+static bool parsePosition(const QByteArray& str, qint64* value)
+{
+    if (str.isEmpty()) {
+        return false;
+    }
+    for (char c : str) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+    }
+    bool ok = false;
+    *value = str.toLongLong(&ok);
+    return ok;
+}
+
+HttpRange::Result HttpRange::parse(const QByteArray &header, qint64 size, ByteRange *range)
+{
+    QByteArray value = header.trimmed();
+    if (!value.startsWith("bytes=")) {
+        return Result::Ignored;
+    }
+    QByteArray spec = value.mid(6).trimmed();
+    qsizetype dash = spec.indexOf('-');
+    if (spec.contains(',') || dash < 0) {
+        return Result::Ignored;
+    }
+
+    QByteArray firstStr = spec.left(dash).trimmed();
+    QByteArray lastStr = spec.mid(dash + 1).trimmed();
+    qint64 first = 0;
+    qint64 last = 0;
+    if (firstStr.isEmpty()) {
+        // Suffix range, the last N bytes
+        qint64 suffix = 0;
+        if (!parsePosition(lastStr, &suffix)) {
+            return Result::Ignored;
+        }
+        if (suffix == 0 || size == 0) {
+            return Result::Unsatisfiable;
+        }
+        first = qMax(size - suffix, qint64(0));
+        last = size - 1;
+    } else {
+        if (!parsePosition(firstStr, &first)) {
+            return Result::Ignored;
+        }
+        if (lastStr.isEmpty()) {
+            last = size - 1;
+        } else if (!parsePosition(lastStr, &last) || last < first) {
+            return Result::Ignored;
+        }
+        if (first >= size) {
+            return Result::Unsatisfiable;
+        }
+        last = qMin(last, size - 1);
+    }
+
+    range->first = first;
+    range->last = last;
+    return Result::Satisfiable;
+}
+
+bool HttpRange::ifRangeMatches(const QByteArray &ifRange, const QByteArray &etag, const QDateTime &lastModified)
+{
+    QByteArray value = ifRange.trimmed();
+    if (value.isEmpty()) {
+        return true;
+    }
+    // Weak tags never match here
+    if (value.startsWith('"') || value.startsWith("W/")) {
+        return !etag.isEmpty() && value == etag;
+    }
+    QDateTime date = HttpValidators::parseDate(value);
+    return date.isValid() && lastModified.isValid() && date.toSecsSinceEpoch() == lastModified.toSecsSinceEpoch();
+}
+
+QByteArray HttpRange::partialHead(const ByteRange &range, qint64 size, const QByteArray &contentType,
+                                  const QByteArray &etag, const QDateTime &lastModified)
+{
+    QByteArray res;
+    res.reserve(256);
+    res.append("HTTP/1.1 206 Partial Content\r\n");
+    res.append("Content-Type: ").append(contentType).append("\r\n");
+    res.append("Content-Length: ").append(QByteArray::number(range.length())).append("\r\n");
+    res.append("Content-Range: bytes ").append(QByteArray::number(range.first)).append('-')
+       .append(QByteArray::number(range.last)).append('/').append(QByteArray::number(size)).append("\r\n");
+    res.append("Accept-Ranges: bytes\r\n");
+    if (!etag.isEmpty()) {
+        res.append("ETag: ").append(etag).append("\r\n");
+    }
+    if (lastModified.isValid()) {
+        res.append("Last-Modified: ").append(HttpValidators::formatDate(lastModified)).append("\r\n");
+    }
+    res.append("\r\n");
+    return res;
+}
+
+QByteArray HttpRange::unsatisfiableHead(qint64 size)
+{
+    return "HTTP/1.1 416 Range Not Satisfiable\r\n"
+           "Content-Range: bytes */" + QByteArray::number(size) + "\r\n"
+           "Content-Length: 0\r\n"
+           "\r\n";
+}
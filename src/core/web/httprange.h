@@ -0,0 +1,60 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HTTPRANGE_H
+#define HTTPRANGE_H
+
+#include <QByteArray>
+#include <QDateTime>
+
+// Byte range of a Range request, both ends included
+struct ByteRange
+{
+    qint64 first = 0;
+    qint64 last = -1;
+
+    qint64 length() const { return last - first + 1; }
+};
+
+// Single byte ranges of RFC 9110. Requests for several ranges get the whole
+// body, which the RFC allows.
+class HttpRange
+{
+public:
+    enum class Result
+    {
+        Ignored,
+        Satisfiable,
+        Unsatisfiable
+    };
+
+    static Result parse(const QByteArray& header, qint64 size, ByteRange* range);
+
+    // If-Range holds either the strong tag or the exact Last-Modified date
+    // of the current body, otherwise the whole body is sent
+    static bool ifRangeMatches(const QByteArray& ifRange, const QByteArray& etag, const QDateTime& lastModified);
+
+    static QByteArray partialHead(const ByteRange& range, qint64 size, const QByteArray& contentType,
+                                  const QByteArray& etag, const QDateTime& lastModified);
+    static QByteArray unsatisfiableHead(qint64 size);
+};
+
+#endif // HTTPRANGE_H
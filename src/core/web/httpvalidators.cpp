@@ -0,0 +1,105 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "httpvalidators.h"
+
+#include <QLocale>
+#include <QList>
+
+static const QString dateFormat = QStringLiteral("ddd, dd MMM yyyy hh:mm:ss 'GMT'");
+
+static QByteArray opaqueTag(const QByteArray& tag)
+{
+    QByteArray res = tag.trimmed();
+    if (res.startsWith("W/")) {
+        res.remove(0, 2);
+    }
+    return res;
+}
+
+QByteArray HttpValidators::entityTag(const QByteArray &hash, const QByteArray &suffix)
+{
+    QByteArray res = '"' + hash.toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals);
+    if (!suffix.isEmpty()) {
+        res.append('-').append(suffix);
+    }
+    return res.append('"');
+}
+
+QByteArray HttpValidators::formatDate(const QDateTime &time)
+{
+    return QLocale::c().toString(time.toUTC(), dateFormat).toLatin1();
+}
+
+QDateTime HttpValidators::parseDate(const QByteArray &str)
+{
+    QDateTime res = QLocale::c().toDateTime(QString::fromLatin1(str.trimmed()), dateFormat);
+    if (res.isValid()) {
+        res.setTimeSpec(Qt::UTC);
+    }
+    return res;
+}
+
+bool HttpValidators::matchesAny(const QByteArray &ifNoneMatch, const QByteArray &etag)
+{
+    if (etag.isEmpty()) {
+        return false;
+    }
+    QByteArray own = opaqueTag(etag);
+    const QList<QByteArray> tags = ifNoneMatch.split(',');
+    for (const QByteArray& tag : tags) {
+        QByteArray other = opaqueTag(tag);
+        if (other == "*" || other == own) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HttpValidators::isNotModified(const RequestInfo &info, const QByteArray &etag, const QDateTime &lastModified)
+{
+    if (!info.ifNoneMatch.isEmpty()) {
+        return matchesAny(info.ifNoneMatch, etag);
+    }
+    if (info.ifModifiedSince.isEmpty() || !lastModified.isValid()) {
+        return false;
+    }
+    // The header has a resolution of one second
+    QDateTime since = parseDate(info.ifModifiedSince);
+    return since.isValid() && lastModified.toSecsSinceEpoch() <= since.toSecsSinceEpoch();
+}
+
+QByteArray HttpValidators::notModifiedHead(const QByteArray &etag, const QDateTime &lastModified,
+                                           const QByteArray &extraHeaders)
+{
+    QByteArray res;
+    res.reserve(128 + extraHeaders.size());
+    res.append("HTTP/1.1 304 Not Modified\r\n");
+    if (!etag.isEmpty()) {
+        res.append("ETag: ").append(etag).append("\r\n");
+    }
+    if (lastModified.isValid()) {
+        res.append("Last-Modified: ").append(formatDate(lastModified)).append("\r\n");
+    }
+    res.append(extraHeaders);
+    res.append("\r\n");
+    return res;
+}
@@ -0,0 +1,51 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HTTPVALIDATORS_H
+#define HTTPVALIDATORS_H
+
+#include <QByteArray>
+#include <QDateTime>
+
+#include "requestinfo.h"
+
+// ETag and Last-Modified handling of conditional GET requests
+class HttpValidators
+{
+public:
+    // Quoted strong tag from a content hash, the suffix tells variants apart
+    static QByteArray entityTag(const QByteArray& hash, const QByteArray& suffix = QByteArray());
+
+    // IMF-fixdate, e.g. "Sun, 06 Nov 1994 08:49:37 GMT". Invalid when not parsed.
+    static QByteArray formatDate(const QDateTime& time);
+    static QDateTime parseDate(const QByteArray& str);
+
+    // Weak comparison as If-None-Match requires, "*" matches any tag
+    static bool matchesAny(const QByteArray& ifNoneMatch, const QByteArray& etag);
+
+    // If-Modified-Since is only looked at when If-None-Match is absent
+    static bool isNotModified(const RequestInfo& info, const QByteArray& etag, const QDateTime& lastModified);
+
+    static QByteArray notModifiedHead(const QByteArray& etag, const QDateTime& lastModified,
+                                      const QByteArray& extraHeaders = QByteArray());
+};
+
+#endif // HTTPVALIDATORS_H
@@ -0,0 +1,264 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "latencydistribution.h"
+
+#include <QFile>
+#include <QHash>
+#include <QStringList>
+#include <QTextStream>
+#include <QRegularExpression>
+
+#include <algorithm>
+#include <cmath>
+
+static const int maxDelayMs = 3600000;
+static const int empiricalQuantiles = 1024;
+
+LatencyDistribution::LatencyDistribution()
+    : spec("constant:0")
+{
+
+}
+
+LatencyDistribution LatencyDistribution::constant(int ms)
+{
+    LatencyDistribution res;
+    res.p1 = qBound(0, ms, maxDelayMs);
+    res.spec = "constant:" + QString::number(static_cast<int>(res.p1));
+    return res;
+}
+
+bool LatencyDistribution::parse(const QString &spec, LatencyDistribution *res, QString *error)
+{
+    QString str = spec.trimmed();
+
+    bool isNumber = false;
+    int ms = str.toInt(&isNumber);
+    if (isNumber) {
+        if (ms < 0) {
+            *error = "Delay must not be negative";
+            return false;
+        }
+        *res = constant(ms);
+        return true;
+    }
+
+    QString name = str.section(':', 0, 0).trimmed().toLower();
+    QHash<QString, QString> params;
+    const QStringList items = str.section(':', 1).split(',', Qt::SkipEmptyParts);
+    for (const QString& item : items) {
+        if (item.contains('=')) {
+            params.insert(item.section('=', 0, 0).trimmed().toLower(), item.section('=', 1).trimmed());
+        } else {
+            params.insert("", item.trimmed());
+        }
+    }
+
+    auto number = [&](const QString& key, double* val) {
+        bool ok = false;
+        *val = params.value(key).toDouble(&ok);
+        if (!ok) {
+            *error = "Missing or invalid parameter \"" + key + "\" in " + str;
+        }
+        return ok;
+    };
+
+    LatencyDistribution dist;
+    if (name == "constant") {
+        if (params.contains("") && !params.contains("ms")) {
+            params.insert("ms", params.value(""));
+        }
+        if (!number("ms", &dist.p1)) {
+            return false;
+        }
+        if (dist.p1 < 0) {
+            *error = "Constant delay needs ms >= 0";
+            return false;
+        }
+        *res = constant(static_cast<int>(dist.p1));
+        return true;
+    } else if (name == "uniform") {
+        dist.kind = Type::Uniform;
+        if (!number("min", &dist.p1) || !number("max", &dist.p2)) {
+            return false;
+        }
+        if (dist.p1 < 0 || dist.p2 < dist.p1) {
+            *error = "Uniform delay needs 0 <= min <= max";
+            return false;
+        }
+        dist.spec = QString("uniform:min=%1,max=%2").arg(dist.p1).arg(dist.p2);
+    } else if (name == "normal") {
+        dist.kind = Type::Normal;
+        if (!number("mean", &dist.p1) || !number("stddev", &dist.p2)) {
+            return false;
+        }
+        if (dist.p2 < 0) {
+            *error = "Standard deviation must not be negative";
+            return false;
+        }
+        dist.spec = QString("normal:mean=%1,stddev=%2").arg(dist.p1).arg(dist.p2);
+    } else if (name == "lognormal") {
+        dist.kind = Type::LogNormal;
+        if (!number("mu", &dist.p1) || !number("sigma", &dist.p2)) {
+            return false;
+        }
+        if (dist.p2 < 0) {
+            *error = "Sigma must not be negative";
+            return false;
+        }
+        dist.spec = QString("lognormal:mu=%1,sigma=%2").arg(dist.p1).arg(dist.p2);
+    } else if (name == "pareto") {
+        dist.kind = Type::Pareto;
+        if (!number("scale", &dist.p1) || !number("shape", &dist.p2)) {
+            return false;
+        }
+        if (dist.p1 <= 0 || dist.p2 <= 0) {
+            *error = "Pareto scale and shape must be positive";
+            return false;
+        }
+        dist.spec = QString("pareto:scale=%1,shape=%2").arg(dist.p1).arg(dist.p2);
+    } else if (name == "empirical") {
+        dist.kind = Type::Empirical;
+        QString fileName = params.value("file");
+        if (fileName.isEmpty()) {
+            fileName = params.value("");
+        }
+        QVector<int> table;
+        if (!loadEmpirical(fileName, &table, error)) {
+            return false;
+        }
+        dist.quantiles = std::make_shared<const QVector<int>>(std::move(table));
+        dist.spec = "empirical:file=" + fileName;
+    } else {
+        *error = "Unknown delay distribution: " + str;
+        return false;
+    }
+
+    *res = dist;
+    return true;
+}
+
+LatencyDistribution::Type LatencyDistribution::type() const
+{
+    return kind;
+}
+
+int LatencyDistribution::sample(FastRandom &rng) const
+{
+    double ms = 0;
+    switch (kind) {
+    case Type::Constant:
+        return static_cast<int>(p1);
+    case Type::Uniform:
+        ms = p1 + (p2 - p1) * rng.nextDouble();
+        break;
+    case Type::Normal:
+    case Type::LogNormal: {
+        // Box-Muller, one value per call
+        double z = std::sqrt(-2.0 * std::log(rng.nextDouble())) *
+                   std::cos(6.283185307179586 * rng.nextDouble());
+        ms = kind == Type::Normal ? p1 + p2 * z : std::exp(p1 + p2 * z);
+        break;
+    }
+    case Type::Pareto:
+        ms = p1 / std::pow(rng.nextDouble(), 1.0 / p2);
+        break;
+    case Type::Empirical:
+        return quantiles->at(static_cast<int>(rng.nextBounded(static_cast<quint32>(quantiles->size()))));
+    }
+
+    if (!(ms > 0)) {
+        return 0;
+    }
+    return ms >= maxDelayMs ? maxDelayMs : static_cast<int>(ms + 0.5);
+}
+
+int LatencyDistribution::constantDelay() const
+{
+    return kind == Type::Constant ? static_cast<int>(p1) : 0;
+}
+
+QString LatencyDistribution::toString() const
+{
+    return spec;
+}
+
+bool LatencyDistribution::loadEmpirical(const QString &fileName, QVector<int> *table, QString *error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = "Cannot open latency file " + fileName;
+        return false;
+    }
+
+    // One observation per line: "<ms>" or "<ms> <count>", # starts a comment
+    QVector<QPair<int, double>> samples;
+    double total = 0;
+    QTextStream in(&file);
+    int lineNumber = 0;
+    while (!in.atEnd()) {
+        QString line = in.readLine().section('#', 0, 0).trimmed();
+        ++lineNumber;
+        if (line.isEmpty()) {
+            continue;
+        }
+        const QStringList fields = line.split(QRegularExpression("[\\s,;]+"), Qt::SkipEmptyParts);
+        bool valueOk = false;
+        bool weightOk = true;
+        double value = fields.value(0).toDouble(&valueOk);
+        double weight = fields.size() > 1 ? fields.at(1).toDouble(&weightOk) : 1;
+        if (!valueOk || !weightOk || value < 0 || weight < 0) {
+            *error = QString("Invalid latency at %1:%2").arg(fileName).arg(lineNumber);
+            return false;
+        }
+        samples.append({qMin(static_cast<int>(value + 0.5), maxDelayMs), weight});
+        total += weight;
+    }
+
+    if (samples.isEmpty() || total <= 0) {
+        *error = "No latencies in " + fileName;
+        return false;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    table->resize(empiricalQuantiles);
+    double cumulative = 0;
+    int pos = 0;
+    for (int i = 0; i < empiricalQuantiles; ++i) {
+        double target = (i + 0.5) / empiricalQuantiles * total;
+        while (pos < samples.size() - 1 && cumulative + samples.at(pos).second < target) {
+            cumulative += samples.at(pos).second;
+            ++pos;
+        }
+        (*table)[i] = samples.at(pos).first;
+    }
+    return true;
+}
+
+bool operator==(const LatencyDistribution &a, const LatencyDistribution &b)
+{
+    // The same empirical file may have been edited in between
+    if (a.quantiles != b.quantiles && (!a.quantiles || !b.quantiles || *a.quantiles != *b.quantiles)) {
+        return false;
+    }
+    return a.toString() == b.toString();
+}
@@ -0,0 +1,73 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LATENCYDISTRIBUTION_H
+#define LATENCYDISTRIBUTION_H
+
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+#include "fastrandom.h"
+
+// Response delay in ms drawn for every request. Built from a spec such as
+// "constant:50", "uniform:min=10,max=200", "normal:mean=100,stddev=20",
+// "lognormal:mu=4,sigma=0.5", "pareto:scale=20,shape=1.5" or
+// "empirical:file=latencies.txt". A bare number is a constant delay.
+class LatencyDistribution
+{
+public:
+    enum class Type {
+        Constant,
+        Uniform,
+        Normal,
+        LogNormal,
+        Pareto,
+        Empirical
+    };
+
+    LatencyDistribution();
+
+    static LatencyDistribution constant(int ms);
+    static bool parse(const QString& spec, LatencyDistribution* res, QString* error);
+
+    Type type() const;
+    int sample(FastRandom& rng) const; // ms
+    int constantDelay() const; // ms, Type::Constant only
+    QString toString() const;
+
+    friend bool operator==(const LatencyDistribution& a, const LatencyDistribution& b);
+
+private:
+    static bool loadEmpirical(const QString& fileName, QVector<int>* table, QString* error);
+
+    Type kind = Type::Constant;
+    double p1 = 0;
+    double p2 = 0;
+    QString spec;
+    // Quantiles of the empirical distribution, sampled by a random index
+    std::shared_ptr<const QVector<int>> quantiles;
+};
+
+bool operator==(const LatencyDistribution& a, const LatencyDistribution& b);
+
+#endif // LATENCYDISTRIBUTION_H
@@ -0,0 +1,148 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "latencyhistogram.h"
+
+#include <QtAlgorithms>
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::record(quint64 valueUs)
+{
+    // Single writer, relaxed loads and stores are enough
+    std::atomic<quint64>& bucket = buckets[static_cast<size_t>(bucketIndex(valueUs))];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    total.store(total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    totalUs.store(totalUs.load(std::memory_order_relaxed) + valueUs, std::memory_order_relaxed);
+    if (valueUs > maxValue.load(std::memory_order_relaxed)) {
+        maxValue.store(valueUs, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        buckets[i].fetch_add(other.buckets[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    total.fetch_add(other.total.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    totalUs.fetch_add(other.totalUs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    quint64 otherMax = other.maxValue.load(std::memory_order_relaxed);
+    if (otherMax > maxValue.load(std::memory_order_relaxed)) {
+        maxValue.store(otherMax, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    for (std::atomic<quint64>& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    total.store(0, std::memory_order_relaxed);
+    totalUs.store(0, std::memory_order_relaxed);
+    maxValue.store(0, std::memory_order_relaxed);
+}
+
+quint64 LatencyHistogram::count() const
+{
+    return total.load(std::memory_order_relaxed);
+}
+
+quint64 LatencyHistogram::sum() const
+{
+    return totalUs.load(std::memory_order_relaxed);
+}
+
+quint64 LatencyHistogram::countAtOrBelow(quint64 valueUs) const
+{
+    // Buckets that start above the value are left out, so the bucket holding
+    // the value counts completely
+    quint64 res = 0;
+    int last = bucketIndex(valueUs);
+    for (int i = 0; i <= last; ++i) {
+        res += buckets[static_cast<size_t>(i)].load(std::memory_order_relaxed);
+    }
+    return res;
+}
+
+quint64 LatencyHistogram::percentile(double p) const
+{
+    quint64 count = 0;
+    for (const std::atomic<quint64>& bucket : buckets) {
+        count += bucket.load(std::memory_order_relaxed);
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    quint64 rank = static_cast<quint64>(p / 100.0 * static_cast<double>(count) + 0.5);
+    rank = qBound<quint64>(1, rank, count);
+
+    quint64 seen = 0;
+    for (int i = 0; i < bucketCount; ++i) {
+        seen += buckets[static_cast<size_t>(i)].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            // Highest value that falls into the bucket
+            return qMin(bucketLowerBound(i + 1) - 1, maxValue.load(std::memory_order_relaxed));
+        }
+    }
+    return maxValue.load(std::memory_order_relaxed);
+}
+
+LatencySummary LatencyHistogram::summary() const
+{
+    LatencySummary res;
+    res.count = count();
+    res.p50Us = percentile(50);
+    res.p95Us = percentile(95);
+    res.p99Us = percentile(99);
+    res.maxUs = maxValue.load(std::memory_order_relaxed);
+    return res;
+}
+
+int LatencyHistogram::bucketIndex(quint64 valueUs)
+{
+    const quint64 linearLimit = quint64(2) << subBucketBits;
+    if (valueUs < linearLimit) {
+        return static_cast<int>(valueUs);
+    }
+
+    int exponent = 63 - static_cast<int>(qCountLeadingZeroBits(valueUs));
+    if (exponent > maxExponent) {
+        return bucketCount - 1;
+    }
+    int shift = exponent - subBucketBits;
+    return ((shift + 1) << subBucketBits) + static_cast<int>(valueUs >> shift) - (1 << subBucketBits);
+}
+
+quint64 LatencyHistogram::bucketLowerBound(int index)
+{
+    const int linearLimit = 2 << subBucketBits;
+    if (index < linearLimit) {
+        return static_cast<quint64>(index);
+    }
+
+    int shift = (index >> subBucketBits) - 1;
+    quint64 subBucket = static_cast<quint64>(index & ((1 << subBucketBits) - 1)) + (quint64(1) << subBucketBits);
+    return subBucket << shift;
+}
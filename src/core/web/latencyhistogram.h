@@ -0,0 +1,70 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QtGlobal>
+
+#include <array>
+#include <atomic>
+
+struct LatencySummary
+{
+    quint64 count = 0;
+    quint64 p50Us = 0;
+    quint64 p95Us = 0;
+    quint64 p99Us = 0;
+    quint64 maxUs = 0;
+};
+
+// Log-linear histogram of latencies in microseconds, 64 buckets per power of
+// two (under 1.6% error). Written by one thread, may be read by any thread.
+class LatencyHistogram
+{
+public:
+    static const int subBucketBits = 6;
+    static const int maxExponent = 36;
+    static const int bucketCount = (maxExponent - subBucketBits + 2) << subBucketBits;
+
+    LatencyHistogram();
+
+    void record(quint64 valueUs);
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    quint64 count() const;
+    quint64 sum() const; // us
+    quint64 countAtOrBelow(quint64 valueUs) const;
+    quint64 percentile(double p) const;
+    LatencySummary summary() const;
+
+    static int bucketIndex(quint64 valueUs);
+    static quint64 bucketLowerBound(int index);
+
+private:
+    std::array<std::atomic<quint64>, bucketCount> buckets;
+    std::atomic<quint64> total;
+    std::atomic<quint64> totalUs;
+    std::atomic<quint64> maxValue;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,229 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pagedata.h"
+
+#include <QTemporaryFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QCryptographicHash>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+static const qint64 copyChunkSize = 1024 * 1024;
+
+PageData::~PageData()
+{
+    if (mapped) {
+        file->unmap(mapped);
+    }
+}
+
+std::shared_ptr<const PageData> PageData::fromBytes(const QByteArray &bytes)
+{
+    std::shared_ptr<PageData> page(new PageData);
+    page->owned = bytes;
+    page->modifiedTime = QDateTime::currentDateTimeUtc();
+    return page;
+}
+
+std::shared_ptr<const PageData> PageData::map(const QString &fileName, QString *error)
+{
+    std::shared_ptr<PageData> page(new PageData);
+    page->name = fileName;
+    page->file = std::make_unique<QFile>(fileName);
+    page->modifiedTime = QFileInfo(fileName).lastModified().toUTC();
+    if (!page->file->open(QIODevice::ReadOnly)) {
+        *error = "Cannot open page " + fileName + ": " + page->file->errorString();
+        return nullptr;
+    }
+    if (!page->mapFile(error)) {
+        return nullptr;
+    }
+    return page;
+}
+
+std::shared_ptr<const PageData> PageData::snapshot(const QString &fileName, QString *error, bool *changed)
+{
+    *changed = false;
+    QFile source(fileName);
+    if (!source.open(QIODevice::ReadOnly)) {
+        *error = "Cannot open page " + fileName + ": " + source.errorString();
+        return nullptr;
+    }
+    // QFileInfo reads the file's metadata lazily, so it is taken now,
+    // before any byte is copied
+    QFileInfo before(fileName);
+    const qint64 sizeBefore = before.size();
+    const QDateTime modifiedBefore = before.lastModified();
+
+    auto copy = std::make_unique<QTemporaryFile>();
+    if (!copy->open()) {
+        *error = "Cannot create a copy of page " + fileName + ": " + copy->errorString();
+        return nullptr;
+    }
+    while (!source.atEnd()) {
+        QByteArray chunk = source.read(copyChunkSize);
+        if (chunk.isEmpty() || copy->write(chunk) != chunk.size()) {
+            *error = "Cannot copy page " + fileName;
+            return nullptr;
+        }
+    }
+    copy->flush();
+
+    QFileInfo after(fileName);
+    if (after.size() != sizeBefore || after.lastModified() != modifiedBefore || copy->size() != sizeBefore) {
+        *error = "Page " + fileName + " changed while it was read";
+        *changed = true;
+        return nullptr;
+    }
+
+    std::shared_ptr<PageData> page(new PageData);
+    page->name = fileName;
+    page->file = std::move(copy);
+    page->modifiedTime = modifiedBefore.toUTC();
+    if (!page->mapFile(error)) {
+        return nullptr;
+    }
+    return page;
+}
+
+std::shared_ptr<const PageData> PageData::openLive(const QString &fileName, qint64 size, QString *error)
+{
+    std::shared_ptr<PageData> page(new PageData);
+    page->name = fileName;
+    page->file = std::make_unique<QFile>(fileName);
+    if (!page->file->open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        *error = "Cannot open page " + fileName + ": " + page->file->errorString();
+        return nullptr;
+    }
+    page->modifiedTime = page->file->fileTime(QFileDevice::FileModificationTime).toUTC();
+    page->liveSize = size;
+    return page;
+}
+
+bool PageData::mapFile(QString *error)
+{
+    qint64 size = file->size();
+    if (size == 0) {
+        file.reset();
+        return true;
+    }
+
+    mapped = file->map(0, size);
+    if (!mapped) {
+        // Not mappable (e.g. a pipe), keep a copy instead
+        if (!file->seek(0)) {
+            *error = "Cannot read page " + name + ": " + file->errorString();
+            return false;
+        }
+        owned = file->readAll();
+        file.reset();
+        return true;
+    }
+    mappedSize = size;
+    return true;
+}
+
+QByteArray PageData::bytes() const
+{
+    if (mapped) {
+        return QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), static_cast<qsizetype>(mappedSize));
+    }
+    return owned;
+}
+
+qint64 PageData::size() const
+{
+    if (liveSize >= 0) {
+        return liveSize;
+    }
+    return mapped ? mappedSize : owned.size();
+}
+
+bool PageData::isLive() const
+{
+    return liveSize >= 0;
+}
+
+QByteArray PageData::read(qint64 offset, qint64 length) const
+{
+    length = qBound<qint64>(0, length, size() - offset);
+    if (!isLive()) {
+        return QByteArray::fromRawData(bytes().constData() + offset, static_cast<qsizetype>(length));
+    }
+
+    QByteArray data(static_cast<qsizetype>(length), Qt::Uninitialized);
+    qint64 done = 0;
+#ifdef Q_OS_UNIX
+    // Workers read the same file at once, pread() needs no shared position
+    while (done < length) {
+        ssize_t got = ::pread(file->handle(), data.data() + done, static_cast<size_t>(length - done),
+                              static_cast<off_t>(offset + done));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            break;
+        }
+        done += got;
+    }
+#else
+    std::lock_guard<std::mutex> lock(readMutex);
+    if (file->seek(offset)) {
+        done = qMax<qint64>(0, file->read(data.data(), length));
+    }
+#endif
+    data.resize(static_cast<qsizetype>(done));
+    return data;
+}
+
+int PageData::fileHandle() const
+{
+    return mapped || isLive() ? file->handle() : -1;
+}
+
+QString PageData::fileName() const
+{
+    return name;
+}
+
+QDateTime PageData::modified() const
+{
+    return modifiedTime;
+}
+
+QByteArray PageData::contentHash() const
+{
+    std::call_once(hashOnce, [this]() {
+        hash = QCryptographicHash::hash(bytes(), QCryptographicHash::Sha1);
+        hashed = true;
+    });
+    return hash;
+}
+
+bool PageData::hasContentHash() const
+{
+    return hashed;
+}
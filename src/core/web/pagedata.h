@@ -0,0 +1,95 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PAGEDATA_H
+#define PAGEDATA_H
+
+#include <QByteArray>
+#include <QString>
+#include <QFile>
+#include <QDateTime>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+// Raw bytes of a response body. Pages loaded from files are memory mapped,
+// so the same pages are shared by all responses without being copied.
+class PageData
+{
+public:
+    ~PageData();
+
+    static std::shared_ptr<const PageData> fromBytes(const QByteArray& bytes);
+    static std::shared_ptr<const PageData> map(const QString& fileName, QString* error);
+
+    // Maps a private copy of the file, so later writes to the file never
+    // show through. Fails with changed set if the file changed while copying.
+    static std::shared_ptr<const PageData> snapshot(const QString& fileName, QString* error, bool* changed);
+
+    // Keeps the file open without mapping it, for files that may change
+    // while they are served: a mapping of a file truncated meanwhile faults
+    // on access. The size is the one the headers promise. Such a page has
+    // no bytes(), it is read with read() or sent with sendfile().
+    static std::shared_ptr<const PageData> openLive(const QString& fileName, qint64 size, QString* error);
+
+    // Valid as long as the page is alive
+    QByteArray bytes() const;
+    qint64 size() const;
+    bool isLive() const;
+    // Up to length bytes from offset. Fewer bytes mean that a live file
+    // was cut short. Slices of pages in memory are valid as long as the
+    // page is alive.
+    QByteArray read(qint64 offset, qint64 length) const;
+
+    // Descriptor of the mapped or live file, -1 for pages held in memory
+    int fileHandle() const;
+    QString fileName() const;
+    // Modification time of the file, the creation time for pages held in memory
+    QDateTime modified() const;
+
+    // SHA-1 of the bytes, computed by the first caller and kept for the
+    // life of the page
+    QByteArray contentHash() const;
+    // Whether contentHash() returns without reading the page
+    bool hasContentHash() const;
+
+private:
+    PageData() = default;
+    Q_DISABLE_COPY(PageData)
+
+    bool mapFile(QString* error);
+
+    QByteArray owned;
+    QString name;
+    QDateTime modifiedTime;
+    mutable std::once_flag hashOnce;
+    mutable QByteArray hash;
+    mutable std::atomic<bool> hashed{false};
+    std::unique_ptr<QFile> file;
+    uchar* mapped = nullptr;
+    qint64 mappedSize = 0;
+    qint64 liveSize = -1;
+    // Reads of a live file without pread() go through the shared QFile
+    mutable std::mutex readMutex;
+};
+
+#endif // PAGEDATA_H
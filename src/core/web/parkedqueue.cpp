@@ -0,0 +1,95 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "parkedqueue.h"
+#include "cachedresponse.h"
+#include "socketutils.h"
+
+#include <algorithm>
+
+void ParkedQueue::park(RequestInfo &&info, QHttpServerResponder &&responder, int capacity, ParkOverflowPolicy policy)
+{
+    QPointer<QTcpSocket> socket = responder.socket();
+
+    if (static_cast<int>(entries.size()) >= capacity) {
+        removeClosed();
+    }
+
+    if (static_cast<int>(entries.size()) >= capacity) {
+        switch (policy) {
+        case ParkOverflowPolicy::Reset:
+            SocketUtils::resetConnection(socket);
+            return;
+        case ParkOverflowPolicy::ServiceUnavailable: {
+            static const CachedResponse unavailable("Service Unavailable", 503);
+            unavailable.write(socket);
+            return;
+        }
+        case ParkOverflowPolicy::DropOldest:
+            while (!entries.empty() && static_cast<int>(entries.size()) >= capacity) {
+                Entry& oldest = entries.front();
+                if (!oldest.socket.isNull()) {
+                    SocketUtils::resetConnection(oldest.socket);
+                }
+                entries.pop_front();
+            }
+            if (capacity <= 0) {
+                SocketUtils::resetConnection(socket);
+                return;
+            }
+            break;
+        }
+    }
+
+    entries.push_back({socket, std::move(info), std::make_unique<QHttpServerResponder>(std::move(responder))});
+}
+
+std::deque<ParkedQueue::Entry> ParkedQueue::take(int count)
+{
+    std::deque<Entry> batch;
+    while (!entries.empty() && static_cast<int>(batch.size()) < count) {
+        batch.push_back(std::move(entries.front()));
+        entries.pop_front();
+    }
+    return batch;
+}
+
+void ParkedQueue::requeue(Entry &&entry)
+{
+    entries.push_back(std::move(entry));
+}
+
+void ParkedQueue::clear()
+{
+    entries.clear();
+}
+
+int ParkedQueue::size() const
+{
+    return static_cast<int>(entries.size());
+}
+
+void ParkedQueue::removeClosed()
+{
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [](const Entry& entry) {
+        return entry.socket.isNull() || entry.socket->state() != QAbstractSocket::ConnectedState;
+    }), entries.end());
+}
@@ -0,0 +1,58 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PARKEDQUEUE_H
+#define PARKEDQUEUE_H
+
+#include <QtHttpServer/QHttpServerResponder>
+#include <QPointer>
+#include <QTcpSocket>
+
+#include <deque>
+#include <memory>
+
+#include "webserverdata.h"
+#include "requestinfo.h"
+
+// Requests held while HTTP response is disabled. Each entry is only the
+// responder and a guard for its socket, nothing waits on the stack.
+class ParkedQueue
+{
+public:
+    struct Entry {
+        QPointer<QTcpSocket> socket;
+        RequestInfo info;
+        std::unique_ptr<QHttpServerResponder> responder;
+    };
+
+    void park(RequestInfo&& info, QHttpServerResponder&& responder, int capacity, ParkOverflowPolicy policy);
+    std::deque<Entry> take(int count);
+    void requeue(Entry&& entry);
+    void clear();
+    int size() const;
+
+private:
+    void removeClosed();
+
+    std::deque<Entry> entries;
+};
+
+#endif // PARKEDQUEUE_H
@@ -0,0 +1,50 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REQUESTINFO_H
+#define REQUESTINFO_H
+
+#include <QString>
+#include <QByteArray>
+
+#include "faultplan.h"
+
+// What the response depends on, taken from the request when it arrives.
+// Kept while the request is delayed or parked, the responder alone does
+// not give access to the request any more.
+struct RequestInfo
+{
+    QString path;
+    QString query;
+    qint64 startNs = 0;
+    int delayMs = 0;
+    FaultPlan::Fault fault;
+    bool acceptsGzip = false;
+    // Raw values of the conditional headers, parsed only when needed
+    QByteArray ifNoneMatch;
+    QByteArray ifModifiedSince;
+    QByteArray range;
+    QByteArray ifRange;
+
+    bool isConditional() const { return !ifNoneMatch.isEmpty() || !ifModifiedSince.isEmpty(); }
+};
+
+#endif // REQUESTINFO_H
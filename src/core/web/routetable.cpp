@@ -0,0 +1,111 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "routetable.h"
+
+RouteTable::RouteTable()
+{
+    nodes.emplace_back();
+}
+
+void RouteTable::insert(const EndpointConfig &endpoint)
+{
+    QStringView path(endpoint.path);
+    if (path.startsWith('/')) {
+        path = path.mid(1);
+    }
+
+    bool wildcard = path == u"*" || path.endsWith(u"/*");
+    if (wildcard) {
+        path.chop(path.size() == 1 ? 1 : 2);
+    }
+
+    int endpointIndex = static_cast<int>(endpoints.size());
+    endpoints.push_back(endpoint);
+
+    size_t node = 0;
+    qsizetype pos = 0;
+    bool last = wildcard && path.isEmpty();
+    while (!last) {
+        qsizetype next = path.indexOf('/', pos);
+        last = next < 0;
+        QStringView segment = path.mid(pos, last ? -1 : next - pos);
+        pos = next + 1;
+
+        auto it = nodes[node].children.constFind(segment);
+        if (it != nodes[node].children.constEnd()) {
+            node = static_cast<size_t>(it.value());
+            continue;
+        }
+
+        Node child;
+        child.segment = segment.toString();
+        int childIndex = static_cast<int>(nodes.size());
+        nodes.push_back(std::move(child));
+        nodes[node].children.insert(QStringView(nodes.back().segment), childIndex);
+        node = static_cast<size_t>(childIndex);
+    }
+
+    if (wildcard) {
+        nodes[node].wildcardEndpoint = endpointIndex;
+    } else {
+        nodes[node].endpoint = endpointIndex;
+    }
+}
+
+const EndpointConfig *RouteTable::find(QStringView path) const
+{
+    if (path.startsWith('/')) {
+        path = path.mid(1);
+    }
+
+    const Node* node = &nodes.front();
+    int wildcard = node->wildcardEndpoint;
+    qsizetype pos = 0;
+    for (;;) {
+        qsizetype next = path.indexOf('/', pos);
+        QStringView segment = path.mid(pos, next < 0 ? -1 : next - pos);
+
+        auto it = node->children.constFind(segment);
+        if (it == node->children.constEnd()) {
+            break;
+        }
+        node = &nodes[static_cast<size_t>(it.value())];
+
+        if (next < 0) {
+            if (node->endpoint >= 0) {
+                return &endpoints[static_cast<size_t>(node->endpoint)];
+            }
+            break;
+        }
+        if (node->wildcardEndpoint >= 0) {
+            wildcard = node->wildcardEndpoint;
+        }
+        pos = next + 1;
+    }
+
+    return wildcard >= 0 ? &endpoints[static_cast<size_t>(wildcard)] : nullptr;
+}
+
+int RouteTable::size() const
+{
+    return static_cast<int>(endpoints.size());
+}
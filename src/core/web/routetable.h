@@ -0,0 +1,57 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ROUTETABLE_H
+#define ROUTETABLE_H
+
+#include <QHash>
+#include <QString>
+#include <QStringView>
+
+#include <vector>
+
+#include "endpointconfig.h"
+
+// Prefix trie over path segments. Lookup costs one hash probe per segment,
+// so it depends on the path length and not on the number of routes.
+// A trailing "*" segment matches any remainder of the path.
+class RouteTable
+{
+public:
+    RouteTable();
+
+    void insert(const EndpointConfig& endpoint);
+    const EndpointConfig* find(QStringView path) const;
+    int size() const;
+
+private:
+    struct Node {
+        QString segment;
+        QHash<QStringView, int> children;
+        int endpoint = -1;
+        int wildcardEndpoint = -1;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<EndpointConfig> endpoints;
+};
+
+#endif // ROUTETABLE_H
@@ -0,0 +1,65 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "serverconfig.h"
+
+ServerConfig::ServerConfig()
+    : current(std::make_shared<const ServerSnapshot>()),
+      currentVersion(0)
+{
+
+}
+
+std::shared_ptr<const ServerSnapshot> ServerConfig::snapshot() const
+{
+    return std::atomic_load_explicit(&current, std::memory_order_acquire);
+}
+
+quint64 ServerConfig::version() const
+{
+    return currentVersion.load(std::memory_order_acquire);
+}
+
+void ServerConfig::publish(ServerSnapshot next)
+{
+    QMutexLocker locker(&writeMutex);
+
+    next.version = currentVersion.load(std::memory_order_relaxed) + 1;
+
+    std::atomic_store_explicit(&current, std::make_shared<const ServerSnapshot>(std::move(next)),
+                               std::memory_order_release);
+    currentVersion.fetch_add(1, std::memory_order_release);
+}
+
+ServerConfigReader::ServerConfigReader(const ServerConfig *cfg)
+    : config(cfg),
+      local(cfg->snapshot())
+{
+
+}
+
+const std::shared_ptr<const ServerSnapshot> &ServerConfigReader::current()
+{
+    if (config->version() != local->version) {
+        local = config->snapshot();
+    }
+    return local;
+}
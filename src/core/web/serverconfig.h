@@ -0,0 +1,81 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVERCONFIG_H
+#define SERVERCONFIG_H
+
+#include <QMutex>
+
+#include <atomic>
+#include <memory>
+
+#include "webserverdata.h"
+#include "cachedresponse.h"
+#include "routetable.h"
+#include "staticsiteindex.h"
+
+// Immutable view of the server settings. A new snapshot is built for every
+// change and never modified after it has been published.
+struct ServerSnapshot
+{
+    quint64 version = 0;
+    WebServerData data;
+    std::shared_ptr<const CachedResponse> response;
+    // Same response with a gzip body, null until it is built or when the
+    // page is not worth compressing
+    std::shared_ptr<const CachedResponse> gzipResponse;
+    std::shared_ptr<const RouteTable> routes;
+    // Served at the main endpoint instead of the page when set
+    std::shared_ptr<const StaticSiteIndex> site;
+};
+
+// Publishes snapshots from the control thread to the worker threads
+class ServerConfig
+{
+public:
+    ServerConfig();
+
+    std::shared_ptr<const ServerSnapshot> snapshot() const;
+    quint64 version() const;
+    // The version of the snapshot is assigned here
+    void publish(ServerSnapshot next);
+
+private:
+    QMutex writeMutex;
+    std::shared_ptr<const ServerSnapshot> current;
+    std::atomic<quint64> currentVersion;
+};
+
+// Per-thread reader. Checking for a newer snapshot is a single atomic load,
+// the shared pointer is only reloaded after a publish.
+class ServerConfigReader
+{
+public:
+    ServerConfigReader(const ServerConfig* cfg);
+
+    const std::shared_ptr<const ServerSnapshot>& current();
+
+private:
+    const ServerConfig* config;
+    std::shared_ptr<const ServerSnapshot> local;
+};
+
+#endif // SERVERCONFIG_H
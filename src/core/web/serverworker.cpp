@@ -0,0 +1,599 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "serverworker.h"
+#include "diagtcpserver.h"
+#include "timerwheel.h"
+#include "cachedresponse.h"
+#include "socketutils.h"
+#include "bodywriter.h"
+#include "connectionqueue.h"
+#include "bandwidththrottle.h"
+#include "gzipencoder.h"
+#include "httpvalidators.h"
+#include "httprange.h"
+#include "sizeutils.h"
+
+#include <QTcpSocket>
+#include <QUrlQuery>
+#include <QPointer>
+#include <QTimer>
+
+#include <chrono>
+
+static const int releaseBatchSize = 256;
+
+// Metrics label of requests that match no endpoint
+static const QString unmatchedEndpoint = QStringLiteral("unmatched");
+
+static QByteArray headerValue(const QHttpServerRequest& request, const char* name)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+    return request.headers().value(name).toByteArray();
+#else
+    return request.value(name);
+#endif
+}
+
+ServerWorker::ServerWorker(const ServerConfig *cfg, quint64 seed, QObject *parent)
+    : QObject(parent),
+      config(cfg),
+      rng(seed)
+{
+    clock.start();
+    httpServer = new QHttpServer(this);
+    delayWheel = new TimerWheel(this);
+    throttle = new BandwidthThrottle(this);
+
+    // All paths go through the route table of the current snapshot
+    httpServer->setMissingHandler([this](const QHttpServerRequest& request,
+                                         QHttpServerResponder&& responder) {
+        handleRequest(request, std::move(responder));
+    });
+}
+
+bool ServerWorker::listen(const QHostAddress &address, quint16 port, bool reusePort)
+{
+    QTcpServer* tcpServer = createListener(address, port, reusePort);
+    if (!tcpServer) {
+        return false;
+    }
+    listeners.append(tcpServer);
+    return true;
+}
+
+void ServerWorker::closeListeners()
+{
+    retire(listeners);
+}
+
+bool ServerWorker::stageListener(const QHostAddress &address, quint16 port, bool reusePort)
+{
+    QTcpServer* tcpServer = createListener(address, port, reusePort);
+    if (!tcpServer) {
+        return false;
+    }
+    stagedListeners.append(tcpServer);
+    return true;
+}
+
+void ServerWorker::commitStagedListeners()
+{
+    retire(listeners);
+    listeners = stagedListeners;
+    stagedListeners.clear();
+}
+
+void ServerWorker::dropStagedListeners()
+{
+    retire(stagedListeners);
+}
+
+void ServerWorker::stop()
+{
+    parked.clear();
+    delayWheel->clear();
+    throttle->clear();
+    hung.clear();
+    for (QTcpServer* tcpServer : httpServer->servers()) {
+        static_cast<DiagTcpServer*>(tcpServer)->shutdown();
+        tcpServer->deleteLater();
+    }
+    listeners.clear();
+    stagedListeners.clear();
+    retiredListeners.clear();
+}
+
+QTcpServer *ServerWorker::createListener(const QHostAddress &address, quint16 port, bool reusePort)
+{
+    DiagTcpServer* tcpServer = new DiagTcpServer(this);
+    if (!tcpServer->listen(address, port, reusePort)) {
+        qWarning() << "Error binding server to address and port:" << tcpServer->errorString();
+        delete tcpServer;
+        return nullptr;
+    }
+    httpServer->bind(tcpServer);
+    tcpServer->setTcpFault(config.current()->data.getTcpFault());
+    return tcpServer;
+}
+
+void ServerWorker::retire(QList<QTcpServer *> &servers)
+{
+    for (QTcpServer* tcpServer : std::as_const(servers)) {
+        // A bouncing listener would open again
+        static_cast<DiagTcpServer*>(tcpServer)->shutdown();
+        retiredListeners.append(tcpServer);
+        // Accepted sockets are children of the server, so a closed server is
+        // only deleted once its last connection is gone. Queued, a socket
+        // is still a child while it is being destroyed.
+        const QList<QTcpSocket*> sockets = tcpServer->findChildren<QTcpSocket*>(Qt::FindDirectChildrenOnly);
+        for (QTcpSocket* socket : sockets) {
+            connect(socket, &QObject::destroyed, this, &ServerWorker::purgeRetired, Qt::QueuedConnection);
+        }
+    }
+    servers.clear();
+    purgeRetired();
+}
+
+void ServerWorker::purgeRetired()
+{
+    retiredListeners.removeIf([](QTcpServer* tcpServer) {
+        if (!tcpServer->findChildren<QTcpSocket*>(Qt::FindDirectChildrenOnly).isEmpty()) {
+            return false;
+        }
+        tcpServer->deleteLater();
+        return true;
+    });
+}
+
+void ServerWorker::applyTcpFault()
+{
+    TcpFault fault = config.current()->data.getTcpFault();
+    for (QTcpServer* tcpServer : std::as_const(listeners)) {
+        static_cast<DiagTcpServer*>(tcpServer)->setTcpFault(fault);
+    }
+}
+
+void ServerWorker::releaseParked()
+{
+    releaseBatch(parked.size());
+}
+
+void ServerWorker::setAccessLogBuffer(const std::shared_ptr<AccessLogBuffer> &buffer)
+{
+    accessLog = buffer;
+}
+
+const WorkerMetrics &ServerWorker::workerMetrics() const
+{
+    return metrics;
+}
+
+void ServerWorker::resetLatency()
+{
+    metrics.resetLatency();
+}
+
+void ServerWorker::releaseBatch(int remaining)
+{
+    if (!config.current()->data.isResponding()) {
+        return;
+    }
+
+    // Requests to endpoints that still hold go back to the queue, each
+    // entry is looked at once per release
+    std::deque<ParkedQueue::Entry> batch = parked.take(qMin(remaining, releaseBatchSize));
+    remaining -= static_cast<int>(batch.size());
+    for (ParkedQueue::Entry& entry : batch) {
+        if (entry.socket.isNull()) {
+            continue;
+        }
+        const ServerSnapshot& snapshot = *config.current();
+        const EndpointConfig* endpoint = snapshot.routes ? snapshot.routes->find(entry.info.path) : nullptr;
+        if (endpoint && isHeld(snapshot, *endpoint)) {
+            parked.requeue(std::move(entry));
+        } else {
+            dispatch(std::move(entry.info), std::move(*entry.responder));
+        }
+    }
+
+    if (remaining > 0 && parked.size() > 0) {
+        QTimer::singleShot(0, this, [this, remaining]() {
+            releaseBatch(remaining);
+        });
+    }
+}
+
+void ServerWorker::handleRequest(const QHttpServerRequest &request, QHttpServerResponder &&responder)
+{
+    RequestInfo info;
+    info.path = request.url().path();
+    info.query = request.url().query();
+    info.startNs = clock.nsecsElapsed();
+    if (request.method() != QHttpServerRequest::Method::Get) {
+        sendNotFound(responder.socket(), info);
+        return;
+    }
+    info.acceptsGzip = GzipEncoder::acceptsGzip(headerValue(request, "Accept-Encoding"));
+    info.ifNoneMatch = headerValue(request, "If-None-Match");
+    info.ifModifiedSince = headerValue(request, "If-Modified-Since");
+    info.range = headerValue(request, "Range");
+    if (!info.range.isEmpty()) {
+        info.ifRange = headerValue(request, "If-Range");
+    }
+    dispatch(std::move(info), std::move(responder));
+}
+
+void ServerWorker::dispatch(RequestInfo &&info, QHttpServerResponder &&responder)
+{
+    const ServerSnapshot& snapshot = *config.current();
+    if (!snapshot.data.isStarted()) {
+        return;
+    }
+
+    // Parked requests are timed from their release
+    info.startNs = clock.nsecsElapsed();
+    const EndpointConfig* endpoint = snapshot.routes ? snapshot.routes->find(info.path) : nullptr;
+    if (!endpoint) {
+        sendNotFound(responder.socket(), info);
+        return;
+    }
+
+    if (!endpoint->listen) {
+        metrics.recordReset();
+        SocketUtils::resetConnection(responder.socket());
+        return;
+    }
+
+    if (isHeld(snapshot, *endpoint)) {
+        metrics.recordParked();
+        const WebServerData& data = snapshot.data;
+        parked.park(std::move(info), std::move(responder), data.getParkCapacity(), data.getParkOverflowPolicy());
+        return;
+    }
+
+    respond(snapshot, *endpoint, std::move(info), std::move(responder));
+}
+
+void ServerWorker::respond(const ServerSnapshot &snapshot, const EndpointConfig &endpoint,
+                           RequestInfo &&info, QHttpServerResponder &&responder)
+{
+    int delay = 0;
+    if (!endpoint.mainEndpoint) {
+        delay = endpoint.delay.sample(rng);
+    } else if (snapshot.data.getEnableResponseDelay()) {
+        delay = snapshot.data.getDelayDistribution().sample(rng);
+    }
+    info.fault = (endpoint.mainEndpoint ? snapshot.data.getFaultPlan() : endpoint.faults).sample(rng);
+    if (info.fault.action == FaultPlan::Action::Hang) {
+        hang(std::move(responder));
+        return;
+    }
+    if (delay <= 0) {
+        sendResponse(snapshot, endpoint, info, std::move(responder));
+        return;
+    }
+    info.delayMs = delay;
+
+    // The endpoint is looked up again when the delay ends, the response
+    // follows the settings of that moment
+    QPointer<QTcpSocket> socket = responder.socket();
+    auto delayed = std::make_shared<QHttpServerResponder>(std::move(responder));
+    delayWheel->schedule(delay, [this, socket, delayed, info = std::move(info)]() {
+        if (!socket.isNull()) {
+            sendCurrentResponse(info, std::move(*delayed));
+        }
+    });
+}
+
+void ServerWorker::sendCurrentResponse(const RequestInfo &info, QHttpServerResponder &&responder)
+{
+    const ServerSnapshot& current = *config.current();
+    if (!current.data.isStarted()) {
+        return;
+    }
+    const EndpointConfig* endpoint = current.routes ? current.routes->find(info.path) : nullptr;
+    if (!endpoint) {
+        sendNotFound(responder.socket(), info);
+        return;
+    }
+    sendResponse(current, *endpoint, info, std::move(responder));
+}
+
+void ServerWorker::sendResponse(const ServerSnapshot &snapshot, const EndpointConfig &endpoint,
+                                const RequestInfo &info, QHttpServerResponder &&responder)
+{
+    // A pipelined request waits until the body before it is out, its bytes
+    // would land in the middle of that body
+    QTcpSocket* socket = responder.socket();
+    if (ConnectionQueue::isBusy(socket)) {
+        auto waiting = std::make_shared<QHttpServerResponder>(std::move(responder));
+        ConnectionQueue::enqueue(socket, [this, waiting, info]() {
+            sendCurrentResponse(info, std::move(*waiting));
+        });
+        return;
+    }
+
+    switch (info.fault.action) {
+    case FaultPlan::Action::Status:
+        sendFaultStatus(responder.socket(), endpoint, info);
+        return;
+    case FaultPlan::Action::Reset:
+        metrics.recordFault(info.fault.action);
+        metrics.recordReset();
+        SocketUtils::resetConnection(responder.socket());
+        return;
+    case FaultPlan::Action::Hang:
+    case FaultPlan::Action::Truncate:
+    case FaultPlan::Action::None:
+        break;
+    }
+
+    if (endpoint.mainEndpoint && snapshot.site && !snapshot.data.getReturnEmptyPage()) {
+        sendStaticFile(snapshot, endpoint, info, responder.socket());
+        return;
+    }
+    if (!endpoint.mainEndpoint && endpoint.payload) {
+        sendPayload(endpoint, info, responder.socket());
+        return;
+    }
+
+    const CachedResponse* response = endpoint.mainEndpoint ? snapshot.response.get() : endpoint.response.get();
+    const CachedResponse* identity = response;
+    // Ranges are served from the identity body only
+    if (endpoint.mainEndpoint && info.acceptsGzip && info.range.isEmpty() && snapshot.gzipResponse) {
+        response = snapshot.gzipResponse.get();
+    }
+
+    if (isNotModified(snapshot, info, response->statusCode(), response->etag(), response->lastModified())) {
+        sendNotModified(responder.socket(), endpoint, info, response->notModifiedHead());
+        return;
+    }
+
+    if (endpoint.mainEndpoint &&
+        sendRange(snapshot, responder.socket(), endpoint, info, response->statusCode(), response->bodyData(),
+                  response->contentType(), response->etag(), response->lastModified())) {
+        return;
+    }
+
+    if (response != identity) {
+        metrics.recordCompressionSaved(static_cast<quint64>(identity->body().size() - response->body().size()));
+    }
+    writeBody(responder.socket(), info, bandwidthLimit(snapshot, endpoint), response->head(), response->bodyData());
+    metrics.recordResponse(endpoint.path, response->statusCode(),
+                           static_cast<quint64>(clock.nsecsElapsed() - info.startNs) / 1000);
+    logAccess(responder.socket(), info, response->statusCode(), response->head().size() + response->body().size());
+}
+
+void ServerWorker::sendStaticFile(const ServerSnapshot &snapshot, const EndpointConfig &endpoint,
+                                  const RequestInfo &info, QTcpSocket *socket)
+{
+    QString relativePath = info.path.mid(snapshot.data.getEndpointPath().size());
+    if (relativePath.startsWith('/')) {
+        relativePath.remove(0, 1);
+    }
+
+    // The descriptor is kept by the index. A file that gets shorter than
+    // its indexed size ends the transfer early, the connection is aborted.
+    const StaticFile* file = snapshot.site->find(relativePath);
+    QString error;
+    std::shared_ptr<const PageData> body = file ? snapshot.site->open(*file, &error) : nullptr;
+    if (!body) {
+        sendNotFound(socket, info);
+        return;
+    }
+
+    int code = snapshot.data.getReturnCode();
+    if (isNotModified(snapshot, info, code, file->etag, file->modified)) {
+        sendNotModified(socket, endpoint, info, HttpValidators::notModifiedHead(file->etag, file->modified));
+        return;
+    }
+    if (sendRange(snapshot, socket, endpoint, info, code, body, file->contentType, file->etag, file->modified)) {
+        return;
+    }
+
+    QByteArray head;
+    head.reserve(file->headers.size() + 48);
+    head.append("HTTP/1.1 ").append(QByteArray::number(code)).append(' ');
+    head.append(CachedResponse::reasonPhrase(code)).append("\r\n");
+    head.append(file->headers).append("\r\n");
+    writeBody(socket, info, bandwidthLimit(snapshot, endpoint), head, body);
+
+    metrics.recordResponse(endpoint.path, code, static_cast<quint64>(clock.nsecsElapsed() - info.startNs) / 1000);
+    logAccess(socket, info, code, head.size() + body->size());
+}
+
+void ServerWorker::sendPayload(const EndpointConfig &endpoint, const RequestInfo &info, QTcpSocket *socket)
+{
+    // A valid ?size= overrides the configured size for this request
+    qint64 size = endpoint.payload->size();
+    if (!info.query.isEmpty()) {
+        SizeUtils::parseSize(QUrlQuery(info.query).queryItemValue("size"), &size);
+    }
+
+    int code = endpoint.responseCode;
+    QByteArray head;
+    head.reserve(128);
+    head.append("HTTP/1.1 ").append(QByteArray::number(code)).append(' ');
+    head.append(CachedResponse::reasonPhrase(code)).append("\r\n");
+    head.append("Content-Type: ").append(endpoint.payload->contentType()).append("\r\n");
+    head.append("Content-Length: ").append(QByteArray::number(size)).append("\r\n\r\n");
+    if (info.fault.action == FaultPlan::Action::Truncate) {
+        metrics.recordFault(info.fault.action);
+        socket->write(head);
+        BodyWriter::writeTruncated(socket, endpoint.payload, size, size / 2);
+    } else if (endpoint.bandwidth > 0) {
+        throttle->send(socket, endpoint.bandwidth, head, endpoint.payload, size);
+    } else {
+        socket->write(head);
+        BodyWriter::write(socket, endpoint.payload, size);
+    }
+
+    metrics.recordResponse(endpoint.path, code, static_cast<quint64>(clock.nsecsElapsed() - info.startNs) / 1000);
+    logAccess(socket, info, code, head.size() + size);
+}
+
+void ServerWorker::sendFaultStatus(QTcpSocket *socket, const EndpointConfig &endpoint, const RequestInfo &info)
+{
+    int code = info.fault.statusCode;
+    QByteArray reason = CachedResponse::reasonPhrase(code);
+    QByteArray head;
+    head.reserve(96 + reason.size());
+    head.append("HTTP/1.1 ").append(QByteArray::number(code)).append(' ').append(reason).append("\r\n");
+    head.append("Content-Type: text/plain\r\n");
+    head.append("Content-Length: ").append(QByteArray::number(reason.size())).append("\r\n\r\n");
+    socket->write(head);
+    socket->write(reason);
+
+    metrics.recordFault(info.fault.action);
+    metrics.recordResponse(endpoint.path, code, static_cast<quint64>(clock.nsecsElapsed() - info.startNs) / 1000);
+    logAccess(socket, info, code, head.size() + reason.size());
+}
+
+void ServerWorker::hang(QHttpServerResponder &&responder)
+{
+    // Nothing is ever sent, the client waits until it gives up. The
+    // responder goes once the connection is closed, while the socket is
+    // still alive.
+    metrics.recordFault(FaultPlan::Action::Hang);
+    QTcpSocket* socket = responder.socket();
+    hung.insert(socket, std::make_shared<QHttpServerResponder>(std::move(responder)));
+    connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+        hung.remove(socket);
+    });
+}
+
+void ServerWorker::sendNotFound(QTcpSocket *socket, const RequestInfo &info)
+{
+    if (ConnectionQueue::isBusy(socket)) {
+        ConnectionQueue::enqueue(socket, [this, socket, info]() {
+            sendNotFound(socket, info);
+        });
+        return;
+    }
+    static const CachedResponse notFound("Not Found", 404);
+    notFound.write(socket);
+    metrics.recordResponse(unmatchedEndpoint, 404, static_cast<quint64>(clock.nsecsElapsed() - info.startNs) / 1000);
+    logAccess(socket, info, 404, notFound.head().size() + notFound.body().size());
+}
+
+bool ServerWorker::sendRange(const ServerSnapshot &snapshot, QTcpSocket *socket,
+                             const EndpointConfig &endpoint, const RequestInfo &info,
+                             int statusCode, const std::shared_ptr<const PageData> &body,
+                             const QByteArray &contentType, const QByteArray &etag, const QDateTime &lastModified)
+{
+    if (info.range.isEmpty() || statusCode != 200 || !HttpRange::ifRangeMatches(info.ifRange, etag, lastModified)) {
+        return false;
+    }
+
+    ByteRange range;
+    QByteArray head;
+    switch (HttpRange::parse(info.range, body->size(), &range)) {
+    case HttpRange::Result::Ignored:
+        return false;
+    case HttpRange::Result::Unsatisfiable:
+        head = HttpRange::unsatisfiableHead(body->size());
+        socket->write(head);
+        metrics.recordResponse(endpoint.path, 416, static_cast<quint64>(clock.nsecsElapsed() - info.startNs) / 1000);
+        logAccess(socket, info, 416, head.size());
+        return true;
+    case HttpRange::Result::Satisfiable:
+        break;
+    }
+
+    head = HttpRange::partialHead(range, body->size(), contentType, etag, lastModified);
+    writeBody(socket, info, bandwidthLimit(snapshot, endpoint), head, body, range.first, range.length());
+    metrics.recordResponse(endpoint.path, 206, static_cast<quint64>(clock.nsecsElapsed() - info.startNs) / 1000);
+    logAccess(socket, info, 206, head.size() + range.length());
+    return true;
+}
+
+void ServerWorker::writeBody(QTcpSocket *socket, const RequestInfo &info, qint64 bandwidth, const QByteArray &head,
+                             const std::shared_ptr<const PageData> &body, qint64 start, qint64 length)
+{
+    if (info.fault.action == FaultPlan::Action::Truncate) {
+        // Content-Length promises the whole body, half of it arrives
+        metrics.recordFault(info.fault.action);
+        socket->write(head);
+        BodyWriter::writeTruncated(socket, body, start, (length < 0 ? body->size() - start : length) / 2);
+        return;
+    }
+    if (bandwidth > 0) {
+        throttle->send(socket, bandwidth, head, body, start, length);
+        return;
+    }
+    socket->write(head);
+    BodyWriter::write(socket, body, start, length);
+}
+
+void ServerWorker::sendNotModified(QTcpSocket *socket, const EndpointConfig &endpoint, const RequestInfo &info,
+                                   const QByteArray &head)
+{
+    socket->write(head);
+    metrics.recordResponse(endpoint.path, 304, static_cast<quint64>(clock.nsecsElapsed() - info.startNs) / 1000);
+    logAccess(socket, info, 304, head.size());
+}
+
+void ServerWorker::logAccess(QTcpSocket *socket, const RequestInfo &info, int statusCode, qint64 bytes)
+{
+    if (!accessLog) {
+        return;
+    }
+    AccessRecord record;
+    record.timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::system_clock::now().time_since_epoch()).count();
+    record.bytes = static_cast<quint64>(bytes);
+    record.delayMs = static_cast<quint32>(info.delayMs);
+    record.statusCode = static_cast<quint16>(statusCode);
+    if (socket) {
+        record.setClient(socket->peerAddress());
+    }
+    record.setPath(info.path);
+    accessLog->push(record);
+}
+
+qint64 ServerWorker::bandwidthLimit(const ServerSnapshot &snapshot, const EndpointConfig &endpoint)
+{
+    return endpoint.mainEndpoint ? snapshot.data.getBandwidthLimit() : endpoint.bandwidth;
+}
+
+bool ServerWorker::isHeld(const ServerSnapshot &snapshot, const EndpointConfig &endpoint)
+{
+    return !snapshot.data.isResponding() || !endpoint.responding;
+}
+
+bool ServerWorker::isNotModified(const ServerSnapshot &snapshot, const RequestInfo &info, int statusCode,
+                                 const QByteArray &etag, const QDateTime &lastModified)
+{
+    // Conditions only apply to successful responses that have validators
+    if (!info.isConditional() || etag.isEmpty() || statusCode < 200 || statusCode > 299) {
+        return false;
+    }
+    switch (snapshot.data.getCacheValidation()) {
+    case CacheValidation::AlwaysChanged:
+        return false;
+    case CacheValidation::NeverChanges:
+        return true;
+    case CacheValidation::Normal:
+        break;
+    }
+    return HttpValidators::isNotModified(info, etag, lastModified);
+}
@@ -0,0 +1,120 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVERWORKER_H
+#define SERVERWORKER_H
+
+#include <QtHttpServer/QHttpServer>
+
+#include "serverconfig.h"
+#include "parkedqueue.h"
+#include "fastrandom.h"
+#include "workermetrics.h"
+#include "accesslog.h"
+#include "requestinfo.h"
+
+#include <QElapsedTimer>
+#include <QMultiHash>
+
+class TimerWheel;
+class BandwidthThrottle;
+class QTcpServer;
+
+// Serves HTTP requests in the thread it lives in. WebServerDiag runs one
+// worker per thread, all of them reading snapshots of the same ServerConfig.
+class ServerWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    ServerWorker(const ServerConfig* cfg, quint64 seed, QObject* parent = nullptr);
+
+    bool listen(const QHostAddress& address, quint16 port, bool reusePort);
+    void closeListeners();
+
+    // Listener replacement in two steps, so that there is no moment without
+    // a listening socket. Connections accepted by the old listeners stay open.
+    bool stageListener(const QHostAddress& address, quint16 port, bool reusePort);
+    void commitStagedListeners();
+    void dropStagedListeners();
+    void stop();
+    void releaseParked();
+    // Puts the TCP fault of the current snapshot on all listeners
+    void applyTcpFault();
+
+    void setAccessLogBuffer(const std::shared_ptr<AccessLogBuffer>& buffer);
+
+    // Read from the control thread
+    const WorkerMetrics& workerMetrics() const;
+    void resetLatency();
+
+private:
+    QTcpServer* createListener(const QHostAddress& address, quint16 port, bool reusePort);
+    void retire(QList<QTcpServer*>& servers);
+    void purgeRetired();
+    void releaseBatch(int remaining);
+    void handleRequest(const QHttpServerRequest& request, QHttpServerResponder&& responder);
+    void dispatch(RequestInfo&& info, QHttpServerResponder&& responder);
+    void respond(const ServerSnapshot& snapshot, const EndpointConfig& endpoint,
+                 RequestInfo&& info, QHttpServerResponder&& responder);
+    // Follows the settings of the moment, for responses that waited
+    void sendCurrentResponse(const RequestInfo& info, QHttpServerResponder&& responder);
+    void sendResponse(const ServerSnapshot& snapshot, const EndpointConfig& endpoint,
+                      const RequestInfo& info, QHttpServerResponder&& responder);
+    void sendStaticFile(const ServerSnapshot& snapshot, const EndpointConfig& endpoint,
+                        const RequestInfo& info, QTcpSocket* socket);
+    void sendPayload(const EndpointConfig& endpoint, const RequestInfo& info, QTcpSocket* socket);
+    void sendFaultStatus(QTcpSocket* socket, const EndpointConfig& endpoint, const RequestInfo& info);
+    void hang(QHttpServerResponder&& responder);
+    void sendNotFound(QTcpSocket* socket, const RequestInfo& info);
+    // False when the request gets the whole body
+    bool sendRange(const ServerSnapshot& snapshot, QTcpSocket* socket, const EndpointConfig& endpoint,
+                   const RequestInfo& info, int statusCode,
+                   const std::shared_ptr<const PageData>& body, const QByteArray& contentType,
+                   const QByteArray& etag, const QDateTime& lastModified);
+    // Head and body, trickled out when the bandwidth is limited and cut off
+    // halfway for a truncate fault
+    void writeBody(QTcpSocket* socket, const RequestInfo& info, qint64 bandwidth, const QByteArray& head,
+                   const std::shared_ptr<const PageData>& body, qint64 start = 0, qint64 length = -1);
+    void sendNotModified(QTcpSocket* socket, const EndpointConfig& endpoint, const RequestInfo& info,
+                         const QByteArray& head);
+    void logAccess(QTcpSocket* socket, const RequestInfo& info, int statusCode, qint64 bytes);
+    static qint64 bandwidthLimit(const ServerSnapshot& snapshot, const EndpointConfig& endpoint);
+    static bool isHeld(const ServerSnapshot& snapshot, const EndpointConfig& endpoint);
+    static bool isNotModified(const ServerSnapshot& snapshot, const RequestInfo& info, int statusCode,
+                              const QByteArray& etag, const QDateTime& lastModified);
+
+    ServerConfigReader config;
+    QHttpServer* httpServer;
+    TimerWheel* delayWheel;
+    BandwidthThrottle* throttle;
+    ParkedQueue parked;
+    QMultiHash<QTcpSocket*, std::shared_ptr<QHttpServerResponder>> hung;
+    FastRandom rng;
+    WorkerMetrics metrics;
+    std::shared_ptr<AccessLogBuffer> accessLog;
+    QElapsedTimer clock;
+    QList<QTcpServer*> listeners;
+    QList<QTcpServer*> stagedListeners;
+    QList<QTcpServer*> retiredListeners;
+};
+
+#endif // SERVERWORKER_H
@@ -0,0 +1,47 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sizeutils.h"
+
+bool SizeUtils::parseSize(const QString &str, qint64 *size)
+{
+    QString value = str.trimmed();
+    qint64 unit = 1;
+    if (value.endsWith('k', Qt::CaseInsensitive)) {
+        unit = 1024;
+    } else if (value.endsWith('M', Qt::CaseInsensitive)) {
+        unit = 1024 * 1024;
+    } else if (value.endsWith('G', Qt::CaseInsensitive)) {
+        unit = 1024 * 1024 * 1024;
+    }
+    if (unit > 1) {
+        value.chop(1);
+    }
+
+    bool ok = false;
+    qint64 number = value.toLongLong(&ok);
+    // Up to 1 PB, far beyond anything a test would wait for
+    if (!ok || number < 0 || number > (qint64(1) << 50) / unit) {
+        return false;
+    }
+    *size = number * unit;
+    return true;
+}
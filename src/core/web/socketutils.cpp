@@ -0,0 +1,137 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "socketutils.h"
+
+#include <QTcpSocket>
+
+#include <limits>
+
+#ifdef Q_OS_WIN
+#include <winsock2.h>
+#else
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <csignal>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <sys/sendfile.h>
+#include <cerrno>
+#endif
+
+static void setLingerZero(qintptr fd)
+{
+    linger lin;
+    lin.l_onoff = 1;
+    lin.l_linger = 0;
+#ifdef Q_OS_WIN
+    ::setsockopt(static_cast<SOCKET>(fd), SOL_SOCKET, SO_LINGER,
+                 reinterpret_cast<const char*>(&lin), sizeof(lin));
+#else
+    ::setsockopt(static_cast<int>(fd), SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+#endif
+}
+
+void SocketUtils::resetConnection(QTcpSocket *socket)
+{
+    qintptr fd = socket->socketDescriptor();
+    if (fd != -1) {
+        setLingerZero(fd);
+    }
+    socket->abort();
+}
+
+void SocketUtils::resetDescriptor(qintptr fd)
+{
+    setLingerZero(fd);
+    closeDescriptor(fd);
+}
+
+void SocketUtils::closeDescriptor(qintptr fd)
+{
+#ifdef Q_OS_WIN
+    ::closesocket(static_cast<SOCKET>(fd));
+#else
+    ::close(static_cast<int>(fd));
+#endif
+}
+
+bool SocketUtils::canSendFile()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SocketUtils::ignoreSigPipe()
+{
+#ifdef Q_OS_UNIX
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+}
+
+int SocketUtils::descriptorLimit()
+{
+#ifdef Q_OS_UNIX
+    rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        if (limit.rlim_cur == RLIM_INFINITY) {
+            return std::numeric_limits<int>::max();
+        }
+        return static_cast<int>(qMin<rlim_t>(limit.rlim_cur, static_cast<rlim_t>(std::numeric_limits<int>::max())));
+    }
+    return 1024;
+#else
+    // Windows has no per-process limit on sockets
+    return 16384;
+#endif
+}
+
+qint64 SocketUtils::sendFile(QTcpSocket *socket, int fileHandle, qint64 offset, qint64 count)
+{
+#ifdef Q_OS_LINUX
+    off_t pos = static_cast<off_t>(offset);
+    while (true) {
+        ssize_t sent = ::sendfile(static_cast<int>(socket->socketDescriptor()), fileHandle, &pos,
+                                  static_cast<size_t>(count));
+        if (sent > 0) {
+            return sent;
+        }
+        if (sent == 0) {
+            return count > 0 ? fileEnded : 0;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        return errno == EAGAIN ? 0 : -1;
+    }
+#else
+    Q_UNUSED(socket)
+    Q_UNUSED(fileHandle)
+    Q_UNUSED(offset)
+    Q_UNUSED(count)
+    return -1;
+#endif
+}
@@ -0,0 +1,56 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SOCKETUTILS_H
+#define SOCKETUTILS_H
+
+#include <QtGlobal>
+
+class QTcpSocket;
+
+class SocketUtils
+{
+public:
+    // Closes the connection with a TCP RST instead of the normal FIN handshake
+    static void resetConnection(QTcpSocket* socket);
+    // The same for a descriptor no QTcpSocket was made for, the descriptor is closed
+    static void resetDescriptor(qintptr fd);
+    static void closeDescriptor(qintptr fd);
+
+    // Descriptors the process may open (RLIMIT_NOFILE)
+    static int descriptorLimit();
+
+    // Whether sendFile() is available on this platform
+    static bool canSendFile();
+    // sendfile() has no MSG_NOSIGNAL, so a front end serving files calls this
+    // once at startup or a peer that went away kills the process with SIGPIPE
+    static void ignoreSigPipe();
+
+    static const qint64 fileEnded = -2;
+
+    // Sends up to count bytes of the file straight from the page cache,
+    // bypassing the socket's write buffer. Returns the number of bytes sent,
+    // 0 when the socket would block, -1 when the kernel cannot do it and
+    // fileEnded when the file is shorter than offset.
+    static qint64 sendFile(QTcpSocket* socket, int fileHandle, qint64 offset, qint64 count);
+};
+
+#endif // SOCKETUTILS_H
@@ -0,0 +1,94 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded single producer, single consumer queue. push() never blocks and
+// fails when the ring is full.
+template <typename T>
+class SpscRing
+{
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        items.resize(size);
+        mask = size - 1;
+    }
+
+    bool push(const T& item)
+    {
+        size_t head = writeIndex.load(std::memory_order_relaxed);
+        if (head - cachedReadIndex > mask) {
+            cachedReadIndex = readIndex.load(std::memory_order_acquire);
+            if (head - cachedReadIndex > mask) {
+                return false;
+            }
+        }
+        items[head & mask] = item;
+        writeIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t pop(T* out, size_t maxCount)
+    {
+        size_t tail = readIndex.load(std::memory_order_relaxed);
+        size_t head = writeIndex.load(std::memory_order_acquire);
+        size_t count = head - tail < maxCount ? head - tail : maxCount;
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = items[(tail + i) & mask];
+        }
+        readIndex.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    bool isEmpty() const
+    {
+        return readIndex.load(std::memory_order_acquire) == writeIndex.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const
+    {
+        return mask + 1;
+    }
+
+private:
+    std::vector<T> items;
+    size_t mask;
+
+    // Producer side
+    alignas(64) std::atomic<size_t> writeIndex{0};
+    size_t cachedReadIndex = 0;
+
+    // Consumer side
+    alignas(64) std::atomic<size_t> readIndex{0};
+};
+
+#endif // SPSCRING_H
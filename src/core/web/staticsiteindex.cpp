@@ -0,0 +1,143 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "staticsiteindex.h"
+#include "httpvalidators.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QMimeDatabase>
+#include <QThreadPool>
+
+#include <vector>
+
+static const qsizetype scanChunkSize = 512;
+
+std::shared_ptr<const StaticSiteIndex> StaticSiteIndex::build(const QString &rootDir, QString *error)
+{
+    QDir dir(rootDir);
+    if (rootDir.isEmpty() || !dir.exists()) {
+        *error = "Site directory " + rootDir + " not found";
+        return nullptr;
+    }
+
+    QString rootPath = dir.absolutePath();
+    QStringList paths;
+    // Dotfiles and hidden directories such as .git or .env are never served
+    QDirIterator it(rootPath, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        paths.append(it.next());
+    }
+
+    // stat() and MIME lookups dominate, they run on all cores
+    std::vector<StaticFile> described(static_cast<size_t>(paths.size()));
+    StaticFile* out = described.data();
+    const QStringList& in = paths;
+    QThreadPool pool;
+    for (qsizetype begin = 0; begin < in.size(); begin += scanChunkSize) {
+        qsizetype end = qMin(begin + scanChunkSize, in.size());
+        pool.start([out, &in, begin, end]() {
+            QMimeDatabase mimeDb;
+            for (qsizetype i = begin; i < end; ++i) {
+                out[i] = describe(in[i], mimeDb);
+            }
+        });
+    }
+    pool.waitForDone();
+
+    std::shared_ptr<StaticSiteIndex> index(new StaticSiteIndex);
+    index->root = rootPath;
+    index->files.reserve(paths.size());
+    qsizetype prefix = rootPath.endsWith('/') ? rootPath.size() : rootPath.size() + 1;
+    for (qsizetype i = 0; i < paths.size(); ++i) {
+        index->files.insert(paths[i].mid(prefix), std::move(out[i]));
+    }
+    return index;
+}
+
+const StaticFile *StaticSiteIndex::find(const QString &relativePath) const
+{
+    auto it = (relativePath.isEmpty() || relativePath.endsWith('/'))
+            ? files.constFind(relativePath + "index.html")
+            : files.constFind(relativePath);
+    return it != files.constEnd() ? &it.value() : nullptr;
+}
+
+std::shared_ptr<const PageData> StaticSiteIndex::open(const StaticFile &file, QString *error) const
+{
+    std::shared_ptr<const PageData> page = std::atomic_load(&file.page);
+    if (page) {
+        return page;
+    }
+    page = PageData::openLive(file.filePath, file.size, error);
+    if (!page) {
+        return nullptr;
+    }
+
+    if (openFiles.fetch_add(1) >= maxOpenFiles) {
+        --openFiles;
+        return page;
+    }
+    // Another worker may have opened it at the same time, one copy is kept
+    std::shared_ptr<const PageData> expected;
+    if (!std::atomic_compare_exchange_strong(&file.page, &expected, page)) {
+        --openFiles;
+        return expected;
+    }
+    return page;
+}
+
+int StaticSiteIndex::openFileCount() const
+{
+    return openFiles;
+}
+
+int StaticSiteIndex::size() const
+{
+    return static_cast<int>(files.size());
+}
+
+const QString &StaticSiteIndex::rootDir() const
+{
+    return root;
+}
+
+StaticFile StaticSiteIndex::describe(const QString &filePath, QMimeDatabase &mimeDb)
+{
+    QFileInfo info(filePath);
+
+    StaticFile file;
+    file.filePath = filePath;
+    file.size = info.size();
+    file.modified = info.lastModified().toUTC();
+    file.contentType = mimeDb.mimeTypeForFile(filePath, QMimeDatabase::MatchExtension).name().toLatin1();
+    file.etag = '"' + QByteArray::number(file.size, 16) + '-' +
+                QByteArray::number(file.modified.toMSecsSinceEpoch(), 16) + '"';
+
+    file.headers.reserve(160);
+    file.headers.append("Content-Type: ").append(file.contentType).append("\r\n");
+    file.headers.append("Content-Length: ").append(QByteArray::number(file.size)).append("\r\n");
+    file.headers.append("Accept-Ranges: bytes\r\n");
+    file.headers.append("ETag: ").append(file.etag).append("\r\n");
+    file.headers.append("Last-Modified: ").append(HttpValidators::formatDate(file.modified)).append("\r\n");
+    return file;
+}
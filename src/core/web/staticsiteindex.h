@@ -0,0 +1,80 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STATICSITEINDEX_H
+#define STATICSITEINDEX_H
+
+#include <QString>
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+
+#include <atomic>
+#include <memory>
+
+#include "pagedata.h"
+
+class QMimeDatabase;
+
+// Metadata of a file under the site root, computed once when the index is built
+struct StaticFile
+{
+    QString filePath;
+    qint64 size = 0;
+    QDateTime modified;
+    QByteArray contentType;
+    QByteArray etag;
+    // Content-Type, Content-Length, Accept-Ranges, ETag and Last-Modified lines
+    QByteArray headers;
+    // Opened on the first request, see StaticSiteIndex::open()
+    mutable std::shared_ptr<const PageData> page;
+};
+
+// Files of a directory tree by their path relative to the root
+class StaticSiteIndex
+{
+public:
+    // Open descriptors kept by an index, well below the common limit of 1024
+    static const int maxOpenFiles = 256;
+
+    static std::shared_ptr<const StaticSiteIndex> build(const QString& rootDir, QString* error);
+
+    // "dir/" and "" resolve to the index.html inside
+    const StaticFile* find(const QString& relativePath) const;
+    // The file opened live, without a mapping, since it may still change.
+    // Kept open for the life of the index up to maxOpenFiles, the files
+    // beyond are opened per request. Safe to call from all workers.
+    std::shared_ptr<const PageData> open(const StaticFile& file, QString* error) const;
+    int openFileCount() const;
+    int size() const;
+    const QString& rootDir() const;
+
+private:
+    StaticSiteIndex() = default;
+
+    static StaticFile describe(const QString& filePath, QMimeDatabase& mimeDb);
+
+    QString root;
+    QHash<QString, StaticFile> files;
+    mutable std::atomic<int> openFiles{0};
+};
+
+#endif // STATICSITEINDEX_H
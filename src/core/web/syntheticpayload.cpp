@@ -0,0 +1,156 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "syntheticpayload.h"
+#include "fastrandom.h"
+#include "sizeutils.h"
+
+#include <QHash>
+#include <QStringList>
+
+static const qsizetype zerosBufferSize = 64 * 1024;
+static const qsizetype randomBufferSize = 1024 * 1024;
+// Whole lines, so the text repeats without a seam
+static const int textBufferLines = 1024;
+
+static const char textLine[] = "The quick brown fox jumps over the lazy dog. 0123456789\n";
+static const char jsonPrefix[] = "{\"filler\":\"";
+static const char jsonSuffix[] = "\"}";
+static const qint64 jsonPrefixSize = static_cast<qint64>(sizeof(jsonPrefix)) - 1;
+static const qint64 jsonSuffixSize = static_cast<qint64>(sizeof(jsonSuffix)) - 1;
+static const char spaces[] = "                                ";
+
+std::shared_ptr<const SyntheticPayload> SyntheticPayload::parse(const QString &spec, QString *error)
+{
+    QString str = spec.trimmed();
+    QString name = str.section(':', 0, 0).trimmed().toLower();
+    QHash<QString, QString> params;
+    const QStringList items = str.section(':', 1).split(',', Qt::SkipEmptyParts);
+    for (const QString& item : items) {
+        params.insert(item.section('=', 0, 0).trimmed().toLower(), item.section('=', 1).trimmed());
+    }
+
+    std::shared_ptr<SyntheticPayload> payload(new SyntheticPayload);
+    if (!SizeUtils::parseSize(params.value("size"), &payload->defaultSize)) {
+        *error = "Missing or invalid parameter \"size\" in " + str;
+        return nullptr;
+    }
+
+    if (name == "zeros") {
+        payload->kind = Pattern::Zeros;
+        payload->mimeType = "application/octet-stream";
+        payload->buffer = QByteArray(zerosBufferSize, '\0');
+    } else if (name == "text" || name == "json") {
+        payload->kind = name == "text" ? Pattern::Text : Pattern::Json;
+        payload->mimeType = name == "text" ? "text/plain; charset=utf-8" : "application/json";
+        payload->buffer = QByteArray(textLine).repeated(textBufferLines);
+        if (payload->kind == Pattern::Json) {
+            // The filler is the content of a JSON string
+            payload->buffer.replace('\n', ' ');
+        }
+    } else if (name == "random") {
+        payload->kind = Pattern::Random;
+        payload->mimeType = "application/octet-stream";
+        bool ok = true;
+        if (params.contains("seed")) {
+            payload->seed = params.value("seed").toULongLong(&ok);
+        }
+        if (!ok) {
+            *error = "Invalid parameter \"seed\" in " + str;
+            return nullptr;
+        }
+        FastRandom rng(payload->seed);
+        payload->buffer.resize(randomBufferSize);
+        for (qsizetype i = 0; i < randomBufferSize; i += 8) {
+            quint64 value = rng.next();
+            for (qsizetype j = 0; j < 8; ++j) {
+                payload->buffer[i + j] = static_cast<char>((value >> (8 * j)) & 0xff);
+            }
+        }
+    } else {
+        *error = "Unknown payload pattern \"" + name + "\", expected zeros, text, random or json";
+        return nullptr;
+    }
+    return payload;
+}
+
+SyntheticPayload::Pattern SyntheticPayload::pattern() const
+{
+    return kind;
+}
+
+qint64 SyntheticPayload::size() const
+{
+    return defaultSize;
+}
+
+const QByteArray &SyntheticPayload::contentType() const
+{
+    return mimeType;
+}
+
+QString SyntheticPayload::toString() const
+{
+    static const char* const names[] = {"zeros", "text", "random", "json"};
+    QString res = QString(names[static_cast<int>(kind)]) + ":size=" + QString::number(defaultSize);
+    if (kind == Pattern::Random) {
+        res += ",seed=" + QString::number(seed);
+    }
+    return res;
+}
+
+QByteArray SyntheticPayload::slice(qint64 totalSize, qint64 offset, qint64 maxLength) const
+{
+    maxLength = qMin(maxLength, totalSize - offset);
+    if (maxLength <= 0) {
+        return QByteArray();
+    }
+    if (kind != Pattern::Json) {
+        return fromBuffer(offset, maxLength);
+    }
+
+    // Too short for the object: an empty array padded with spaces, or a
+    // single digit
+    if (totalSize < jsonPrefixSize + jsonSuffixSize) {
+        if (totalSize == 1) {
+            return QByteArray::fromRawData("0", 1);
+        }
+        if (offset < 2) {
+            return QByteArray::fromRawData("[]" + offset, static_cast<qsizetype>(qMin(maxLength, 2 - offset)));
+        }
+        return QByteArray::fromRawData(spaces, static_cast<qsizetype>(qMin(maxLength, qint64(sizeof(spaces)) - 1)));
+    }
+    if (offset < jsonPrefixSize) {
+        return QByteArray::fromRawData(jsonPrefix + offset, static_cast<qsizetype>(qMin(maxLength, jsonPrefixSize - offset)));
+    }
+    qint64 suffixStart = totalSize - jsonSuffixSize;
+    if (offset >= suffixStart) {
+        return QByteArray::fromRawData(jsonSuffix + (offset - suffixStart), static_cast<qsizetype>(maxLength));
+    }
+    return fromBuffer(offset - jsonPrefixSize, qMin(maxLength, suffixStart - offset));
+}
+
+QByteArray SyntheticPayload::fromBuffer(qint64 position, qint64 maxLength) const
+{
+    qint64 start = position % buffer.size();
+    qint64 len = qMin(maxLength, buffer.size() - start);
+    return QByteArray::fromRawData(buffer.constData() + start, static_cast<qsizetype>(len));
+}
@@ -0,0 +1,71 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SYNTHETICPAYLOAD_H
+#define SYNTHETICPAYLOAD_H
+
+#include <QByteArray>
+#include <QString>
+
+#include <memory>
+
+// Body of any size made of a pattern, generated from a small buffer that is
+// filled once and shared by all responses. Serving 10 GB costs no more
+// memory than serving 10 KB.
+class SyntheticPayload
+{
+public:
+    enum class Pattern
+    {
+        Zeros,
+        Text,
+        Random,
+        Json
+    };
+
+    // "<pattern>:size=<bytes>[,seed=<n>]" with pattern zeros, text, random
+    // (seeded) or json (a valid document of exactly the size from 2 bytes)
+    static std::shared_ptr<const SyntheticPayload> parse(const QString& spec, QString* error);
+
+    Pattern pattern() const;
+    qint64 size() const;
+    const QByteArray& contentType() const;
+    QString toString() const;
+
+    // Bytes of a body of totalSize bytes, starting at offset. Shorter than
+    // maxLength where the shared buffer wraps around, never empty before
+    // the end. Refers to the buffer without copying.
+    QByteArray slice(qint64 totalSize, qint64 offset, qint64 maxLength) const;
+
+private:
+    SyntheticPayload() = default;
+    Q_DISABLE_COPY(SyntheticPayload)
+
+    QByteArray fromBuffer(qint64 position, qint64 maxLength) const;
+
+    Pattern kind = Pattern::Zeros;
+    qint64 defaultSize = 0;
+    quint64 seed = 0;
+    QByteArray mimeType;
+    QByteArray buffer;
+};
+
+#endif // SYNTHETICPAYLOAD_H
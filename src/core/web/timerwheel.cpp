@@ -0,0 +1,102 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "timerwheel.h"
+
+TimerWheel::TimerWheel(QObject *parent, int tickMs, int slotCount)
+    : QObject(parent),
+      wheelSlots(static_cast<size_t>(qMax(slotCount, 1))),
+      tick(qMax(tickMs, 1))
+{
+    timer.setTimerType(Qt::PreciseTimer);
+    timer.setInterval(tick);
+    connect(&timer, &QTimer::timeout, this, &TimerWheel::advance);
+    clock.start();
+}
+
+void TimerWheel::schedule(int delayMs, Callback callback)
+{
+    if (pending == 0) {
+        processedTick = currentTick();
+    }
+
+    // Round up and add one tick so that a callback never fires early
+    qint64 deadline = (clock.elapsed() + qMax(delayMs, 0) + tick - 1) / tick + 1;
+    qint64 ticksAhead = qMax<qint64>(deadline - processedTick, 1);
+    qint64 slotCount = static_cast<qint64>(wheelSlots.size());
+
+    size_t slot = static_cast<size_t>((static_cast<qint64>(cursor) + ticksAhead) % slotCount);
+    wheelSlots[slot].push_back({(ticksAhead - 1) / slotCount, std::move(callback)});
+    ++pending;
+
+    if (!timer.isActive()) {
+        timer.start();
+    }
+}
+
+void TimerWheel::clear()
+{
+    timer.stop();
+    std::vector<std::vector<Entry>> dropped(wheelSlots.size());
+    dropped.swap(wheelSlots);
+    pending = 0;
+}
+
+int TimerWheel::pendingCount() const
+{
+    return pending;
+}
+
+void TimerWheel::advance()
+{
+    qint64 now = currentTick();
+    std::vector<Callback> expired;
+
+    while (processedTick < now && pending > 0) {
+        ++processedTick;
+        cursor = (cursor + 1) % wheelSlots.size();
+
+        std::vector<Entry> bucket;
+        bucket.swap(wheelSlots[cursor]);
+        for (Entry& entry : bucket) {
+            if (entry.rounds == 0) {
+                expired.push_back(std::move(entry.callback));
+                --pending;
+            } else {
+                --entry.rounds;
+                wheelSlots[cursor].push_back(std::move(entry));
+            }
+        }
+    }
+
+    if (pending == 0) {
+        timer.stop();
+    }
+
+    for (Callback& callback : expired) {
+        callback();
+    }
+}
+
+qint64 TimerWheel::currentTick() const
+{
+    return clock.elapsed() / tick;
+}
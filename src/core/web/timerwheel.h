@@ -0,0 +1,67 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include <functional>
+#include <vector>
+
+// Hashed timing wheel: all scheduled callbacks share one timer, so thousands
+// of pending deadlines cost one slot entry each and fire in deadline order.
+class TimerWheel : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Callback = std::function<void()>;
+
+    TimerWheel(QObject* parent = nullptr, int tickMs = 1, int slotCount = 1024);
+
+    void schedule(int delayMs, Callback callback);
+    void clear();
+    int pendingCount() const;
+
+private slots:
+    void advance();
+
+private:
+    struct Entry {
+        qint64 rounds;
+        Callback callback;
+    };
+
+    qint64 currentTick() const;
+
+    std::vector<std::vector<Entry>> wheelSlots;
+    QTimer timer;
+    QElapsedTimer clock;
+    qint64 processedTick = 0;
+    size_t cursor = 0;
+    int pending = 0;
+    int tick;
+};
+
+#endif // TIMERWHEEL_H
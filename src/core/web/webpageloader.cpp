@@ -22,32 +22,139 @@
 #include "webpageloader.h"
 
 #include <QFile>
-#include <QTextStream>
-#include <QDir>
+#include <QFileInfo>
 
-void WebPageLoader::load(const QString& path)
+WebPageLoader::WebPageLoader(QObject *parent)
+    : QObject(parent)
 {
+    pool.setMaxThreadCount(1);
+
+    debounceTimer.setSingleShot(true);
+    debounceTimer.setInterval(debounceMs);
+    connect(&debounceTimer, &QTimer::timeout, this, &WebPageLoader::reload);
+    connect(&watcher, &QFileSystemWatcher::fileChanged, this, &WebPageLoader::fileChanged);
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &WebPageLoader::fileChanged);
+}
+
+WebPageLoader::~WebPageLoader()
+{
+    pool.waitForDone();
+}
+
+std::shared_ptr<const PageData> WebPageLoader::load(const QString& path)
+{
+    ++generation;
+    debounceTimer.stop();
+    reloadPending = false;
+
+    QStringList watched = watcher.files() + watcher.directories();
+    if (!watched.isEmpty()) {
+        watcher.removePaths(watched);
+    }
     pagePath = path;
+    loadedModified = QDateTime();
+    loadedSize = -1;
+    watch();
+
+    if (!QFile::exists(pagePath)) {
+        return placeholderPage(pagePath);
+    }
+    // Copying a large file takes a while, the caller's thread goes on
+    reload();
+    return nullptr;
 }
 
-QString WebPageLoader::getPage() const
+std::shared_ptr<const PageData> WebPageLoader::placeholderPage(const QString &path)
 {
-    QFile page(pagePath);
+    return PageData::fromBytes(QString("<!DOCTYPE html>\n"
+           "<html>\n"
+           "<body>\n"
+           "<p>%1</p>\n"
+           "<p>Please select a custom page...</p>\n"
+           "</body>\n"
+           "</html>\n").arg(path.isEmpty() ? "No page selected" :
+                 "The page at path \"" + path + "\" not found!").toUtf8());
+}
 
-    if (!page.exists()) {
-        return QString("<!DOCTYPE html>\n"
-               "<html>\n"
-               "<body>\n"
-               "<p>%1</p>\n"
-               "<p>Please select a custom page...</p>\n"
-               "</body>\n"
-               "</html>\n").arg(pagePath.isEmpty() ? "No page selected" :
-                     "The page at path \"" + pagePath + "\" not found!");
+void WebPageLoader::watch()
+{
+    if (pagePath.isEmpty()) {
+        return;
+    }
+    // Editors often save by renaming a new file over the old one, which
+    // drops the watch on the file, so its directory is watched as well
+    QFileInfo info(pagePath);
+    if (!watcher.directories().contains(info.absolutePath())) {
+        watcher.addPath(info.absolutePath());
+    }
+    if (info.exists() && !watcher.files().contains(pagePath)) {
+        watcher.addPath(pagePath);
     }
+}
+
+void WebPageLoader::fileChanged()
+{
+    if (pagePath.isEmpty()) {
+        return;
+    }
+    watch();
+
+    QFileInfo info(pagePath);
+    if (!info.exists() || (info.lastModified() == loadedModified && info.size() == loadedSize)) {
+        return;
+    }
+    debounceTimer.start();
+}
 
-    page.open(QIODevice::ReadOnly);
+void WebPageLoader::reload()
+{
+    if (reloading) {
+        reloadPending = true;
+        return;
+    }
+    reloading = true;
 
-    QString pageStr = page.readAll();
+    int gen = generation;
+    QString path = pagePath;
+    pool.start([this, gen, path]() {
+        QString error;
+        bool changed = false;
+        std::shared_ptr<const PageData> page = PageData::snapshot(path, &error, &changed);
+        if (page) {
+            // Hashed here rather than in the thread that publishes the page
+            page->contentHash();
+        }
+        QMetaObject::invokeMethod(this, [this, gen, page, changed, error]() {
+            reloadFinished(gen, page, changed, error);
+        }, Qt::QueuedConnection);
+    });
+}
 
-    return pageStr;
+void WebPageLoader::reloadFinished(int gen, const std::shared_ptr<const PageData> &page, bool changed,
+                                   const QString &error)
+{
+    reloading = false;
+    bool current = gen == generation;
+    if (current && page) {
+        bool first = loadedSize < 0;
+        // The snapshot carries the time and size the file had before the copy
+        loadedModified = page->modified();
+        loadedSize = page->size();
+        if (first) {
+            emit pageLoaded(page);
+        } else {
+            emit pageReloaded(page);
+        }
+    } else if (current && !changed) {
+        emit loadFailed(error);
+    }
+
+    if (reloadPending) {
+        // Another page was selected, or the file settled again, meanwhile
+        reloadPending = false;
+        reload();
+    } else if (current && changed) {
+        // Still being written
+        debounceTimer.start();
+    }
 }
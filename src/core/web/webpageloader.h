@@ -22,17 +22,57 @@
 #ifndef WEBPAGELOADER_H
 #define WEBPAGELOADER_H
 
+#include <QObject>
 #include <QString>
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QThreadPool>
+#include <QTimer>
 
-class WebPageLoader
+#include <memory>
+
+#include "pagedata.h"
+
+// Loads the selected page and keeps watching it. The private copy of the
+// file is made on a pool thread and announced with pageLoaded(), and again
+// with pageReloaded() once later writes to the file settle. Pages already
+// handed out never change.
+class WebPageLoader : public QObject
 {
+    Q_OBJECT
+
 public:
-    void load(const QString& path);
-    QString getPage() const;
+    static const int debounceMs = 200;
+
+    WebPageLoader(QObject* parent = nullptr);
+    ~WebPageLoader();
+
+    // Without a file to load the placeholder page is returned at once,
+    // nullptr otherwise
+    std::shared_ptr<const PageData> load(const QString& path);
+
+signals:
+    void pageLoaded(const std::shared_ptr<const PageData>& page);
+    void pageReloaded(const std::shared_ptr<const PageData>& page);
+    // The page served so far stays
+    void loadFailed(const QString& error);
 
 private:
+    void watch();
+    void fileChanged();
+    void reload();
+    void reloadFinished(int gen, const std::shared_ptr<const PageData>& page, bool changed, const QString& error);
+    static std::shared_ptr<const PageData> placeholderPage(const QString& path);
+
     QString pagePath;
-    QString pageData;
+    QFileSystemWatcher watcher;
+    QTimer debounceTimer;
+    QThreadPool pool;
+    QDateTime loadedModified;
+    qint64 loadedSize = -1;
+    int generation = 0;
+    bool reloading = false;
+    bool reloadPending = false;
 };
 
 #endif // WEBPAGELOADER_H
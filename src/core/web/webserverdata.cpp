@@ -78,22 +78,60 @@ int WebServerData::getResponseTime() const
     return respTimeMs;
 }
 
-QString WebServerData::getHostname() const
+const LatencyDistribution &WebServerData::getDelayDistribution() const
+{
+    return delayDistribution;
+}
+
+const QString &WebServerData::getHostname() const
 {
     return hostname;
 }
 
-QString WebServerData::getEndpointPath() const
+const QString &WebServerData::getEndpointPath() const
 {
     return endpointPath;
 }
 
-QString WebServerData::getPage() const
+int WebServerData::getParkCapacity() const
 {
-    if (getReturnEmptyPage()) {
-        return " ";
-    }
-    return respPage;
+    return parkCapacity;
+}
+
+ParkOverflowPolicy WebServerData::getParkOverflowPolicy() const
+{
+    return parkOverflowPolicy;
+}
+
+CacheValidation WebServerData::getCacheValidation() const
+{
+    return cacheValidation;
+}
+
+qint64 WebServerData::getBandwidthLimit() const
+{
+    return bandwidthLimit;
+}
+
+const FaultPlan &WebServerData::getFaultPlan() const
+{
+    return faultPlan;
+}
+
+TcpFault WebServerData::getTcpFault() const
+{
+    return tcpFault;
+}
+
+QByteArray WebServerData::getPage() const
+{
+    return getPageData()->bytes();
+}
+
+std::shared_ptr<const PageData> WebServerData::getPageData() const
+{
+    static const std::shared_ptr<const PageData> emptyPage = PageData::fromBytes(" ");
+    return getReturnEmptyPage() ? emptyPage : respPage;
 }
 
 void WebServerData::setHostname(const QString &newHostname)
@@ -106,7 +144,7 @@ void WebServerData::setEndpointPath(const QString &path)
     endpointPath = path;
 }
 
-void WebServerData::setRespPage(const QString &newRespPage)
+void WebServerData::setRespPage(const std::shared_ptr<const PageData> &newRespPage)
 {
     respPage = newRespPage;
 }
@@ -129,6 +167,15 @@ void WebServerData::setErrorHasOccurred(bool val)
 void WebServerData::setResponseTime(int val)
 {
     respTimeMs = val;
+    delayDistribution = LatencyDistribution::constant(val);
+}
+
+void WebServerData::setDelayDistribution(const LatencyDistribution &dist)
+{
+    delayDistribution = dist;
+    if (dist.type() == LatencyDistribution::Type::Constant) {
+        respTimeMs = dist.constantDelay();
+    }
 }
 
 void WebServerData::setResponseCode(int newReturnCode)
@@ -156,6 +203,36 @@ void WebServerData::setReturnEmptyPage(bool emptyPage)
     returnEmptyPage = emptyPage;
 }
 
+void WebServerData::setParkCapacity(int val)
+{
+    parkCapacity = val;
+}
+
+void WebServerData::setParkOverflowPolicy(ParkOverflowPolicy policy)
+{
+    parkOverflowPolicy = policy;
+}
+
+void WebServerData::setCacheValidation(CacheValidation mode)
+{
+    cacheValidation = mode;
+}
+
+void WebServerData::setBandwidthLimit(qint64 bytesPerSecond)
+{
+    bandwidthLimit = bytesPerSecond;
+}
+
+void WebServerData::setFaultPlan(const FaultPlan &plan)
+{
+    faultPlan = plan;
+}
+
+void WebServerData::setTcpFault(TcpFault fault)
+{
+    tcpFault = fault;
+}
+
 bool WebServerData::isHostnameValid(const QString& str)
 {
     static QRegularExpression regExp("^(([a-zA-Z0-9]|[a-zA-Z0-9][a-zA-Z0-9\\-]*[a-zA-Z0-9])\\.)*"
@@ -164,6 +241,86 @@ bool WebServerData::isHostnameValid(const QString& str)
     return match.hasMatch();
 }
 
+bool WebServerData::parseParkOverflowPolicy(const QString &str, ParkOverflowPolicy *policy)
+{
+    if (str == "reset") {
+        *policy = ParkOverflowPolicy::Reset;
+    } else if (str == "503") {
+        *policy = ParkOverflowPolicy::ServiceUnavailable;
+    } else if (str == "drop-oldest") {
+        *policy = ParkOverflowPolicy::DropOldest;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool WebServerData::parseCacheValidation(const QString &str, CacheValidation *mode)
+{
+    if (str == "normal") {
+        *mode = CacheValidation::Normal;
+    } else if (str == "changed") {
+        *mode = CacheValidation::AlwaysChanged;
+    } else if (str == "unchanged") {
+        *mode = CacheValidation::NeverChanges;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+QString WebServerData::cacheValidationName(CacheValidation mode)
+{
+    switch (mode) {
+    case CacheValidation::AlwaysChanged:
+        return "changed";
+    case CacheValidation::NeverChanges:
+        return "unchanged";
+    case CacheValidation::Normal:
+        break;
+    }
+    return "normal";
+}
+
+bool WebServerData::parseTcpFault(const QString &str, TcpFault *fault)
+{
+    if (str == "none") {
+        *fault = TcpFault::None;
+    } else if (str == "reset") {
+        *fault = TcpFault::Reset;
+    } else if (str == "no-read") {
+        *fault = TcpFault::NoRead;
+    } else if (str == "pause-accept") {
+        *fault = TcpFault::PauseAccept;
+    } else if (str == "close-after-headers") {
+        *fault = TcpFault::CloseAfterHeaders;
+    } else if (str == "bounce") {
+        *fault = TcpFault::Bounce;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+QString WebServerData::tcpFaultName(TcpFault fault)
+{
+    switch (fault) {
+    case TcpFault::Reset:
+        return "reset";
+    case TcpFault::NoRead:
+        return "no-read";
+    case TcpFault::PauseAccept:
+        return "pause-accept";
+    case TcpFault::CloseAfterHeaders:
+        return "close-after-headers";
+    case TcpFault::Bounce:
+        return "bounce";
+    case TcpFault::None:
+        break;
+    }
+    return "none";
+}
+
 bool operator==(const WebServerData& a, const WebServerData& b)
 {
     return  a.getReturnCode() == b.getReturnCode() &&
@@ -171,9 +328,11 @@ bool operator==(const WebServerData& a, const WebServerData& b)
             a.getPage() == b.getPage() &&
             a.getPort() == b.getPort() &&
             a.getResponseTime() == b.getResponseTime() &&
+            a.getDelayDistribution() == b.getDelayDistribution() &&
             a.isResponding() == b.isResponding() &&
             a.isStarted() == b.isStarted() &&
             a.getEnableResponseDelay() == b.getEnableResponseDelay() &&
             a.getReturnEmptyPage() == b.getReturnEmptyPage() &&
+            a.getCacheValidation() == b.getCacheValidation() &&
             a.getEndpointPath() == b.getEndpointPath();
 }
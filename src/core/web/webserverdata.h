@@ -24,6 +24,40 @@
 
 #include <QString>
 
+#include <memory>
+
+#include "latencydistribution.h"
+#include "faultplan.h"
+#include "pagedata.h"
+
+// What to do with a new request when the queue of held requests is full
+enum class ParkOverflowPolicy
+{
+    Reset,
+    ServiceUnavailable,
+    DropOldest
+};
+
+// Answers to conditional requests. The forced modes are for testing caches:
+// the page always looks changed (never 304) or never changed (always 304).
+enum class CacheValidation
+{
+    Normal,
+    AlwaysChanged,
+    NeverChanges
+};
+
+// Failures below HTTP, applied by every listener of the server
+enum class TcpFault
+{
+    None,
+    Reset,              // accept and reset at once
+    NoRead,             // accept and never read the request
+    PauseAccept,        // stop accepting, the kernel backlog fills up
+    CloseAfterHeaders,  // read the request head and close without an answer
+    Bounce              // close and reopen the listener every few ms
+};
+
 class WebServerData
 {
 public:
@@ -38,32 +72,61 @@ public:
     int getReturnCode() const;
     ushort getPort() const;
     int getResponseTime() const; // ms
-    QString getHostname() const;
-    QString getEndpointPath() const;
-    QString getPage() const;
+    const LatencyDistribution& getDelayDistribution() const;
+    int getParkCapacity() const;
+    ParkOverflowPolicy getParkOverflowPolicy() const;
+    CacheValidation getCacheValidation() const;
+    qint64 getBandwidthLimit() const; // bytes/s per connection, 0 is unlimited
+    const FaultPlan& getFaultPlan() const;
+    TcpFault getTcpFault() const;
+    const QString& getHostname() const;
+    const QString& getEndpointPath() const;
+    QByteArray getPage() const;
+    std::shared_ptr<const PageData> getPageData() const;
 
     void setHostname(const QString &newHostname);
     void setEndpointPath(const QString& path);
-    void setRespPage(const QString &newRespPage);
+    void setRespPage(const std::shared_ptr<const PageData>& newRespPage);
     void setPort(ushort newPort);
     void enableResponseDelay(bool needDelay);
     void setErrorHasOccurred(bool val);
-    void setResponseTime(int val); // ms
+    void setResponseTime(int val); // ms, also makes the delay constant
+    void setDelayDistribution(const LatencyDistribution& dist);
     void setResponseCode(int newReturnCode);
     void setListen(bool newListen);
     void setStarted(bool newStarted);
     void setResponding(bool newResponding);
     void setReturnEmptyPage(bool emptyPage);
+    void setParkCapacity(int val);
+    void setParkOverflowPolicy(ParkOverflowPolicy policy);
+    void setCacheValidation(CacheValidation mode);
+    void setBandwidthLimit(qint64 bytesPerSecond);
+    void setFaultPlan(const FaultPlan& plan);
+    void setTcpFault(TcpFault fault);
 
     static bool isHostnameValid(const QString &str);
+    static bool parseParkOverflowPolicy(const QString& str, ParkOverflowPolicy* policy);
+    // "normal", "changed" or "unchanged"
+    static bool parseCacheValidation(const QString& str, CacheValidation* mode);
+    static QString cacheValidationName(CacheValidation mode);
+    // "none", "reset", "no-read", "pause-accept", "close-after-headers" or "bounce"
+    static bool parseTcpFault(const QString& str, TcpFault* fault);
+    static QString tcpFaultName(TcpFault fault);
 
 private:
     QString hostname = "127.0.0.1";
     QString endpointPath = "/";
-    QString respPage;
+    std::shared_ptr<const PageData> respPage = PageData::fromBytes(QByteArray());
     ushort port = 8080;
     int responseCode = 200;
     int respTimeMs = 1;
+    LatencyDistribution delayDistribution = LatencyDistribution::constant(1);
+    int parkCapacity = 10000;
+    ParkOverflowPolicy parkOverflowPolicy = ParkOverflowPolicy::ServiceUnavailable;
+    CacheValidation cacheValidation = CacheValidation::Normal;
+    qint64 bandwidthLimit = 0;
+    FaultPlan faultPlan;
+    TcpFault tcpFault = TcpFault::None;
     bool listen = true;
     bool started = false;
     bool needResponseDelay = false;
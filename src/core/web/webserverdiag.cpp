@@ -20,20 +20,43 @@
  */
 
 #include "webserverdiag.h"
+#include "serverworker.h"
+#include "diagtcpserver.h"
+#include "gzipencoder.h"
+#include "httpvalidators.h"
 #include "../ipresenter.h"
 
-#include <QTcpServer>
-#include <QFile>
-#include <QDir>
-#include <QTimer>
-#include <QCoreApplication>
+#include <QThread>
+#include <QRandomGenerator>
+#include <QHostAddress>
+#include <QDebug>
 
-WebServerDiag::WebServerDiag(QObject *parent) : QObject(parent)
+template <typename Func>
+void WebServerDiag::runOnWorkers(Func func)
 {
-    httpServer = std::make_shared<QHttpServer>();
+    for (ServerWorker* worker : std::as_const(workers)) {
+        QMetaObject::invokeMethod(worker, [worker, &func]() {
+            func(worker);
+        }, Qt::BlockingQueuedConnection);
+    }
+}
+
+WebServerDiag::WebServerDiag(QObject *parent)
+    : QObject(parent),
+      seed(QRandomGenerator::global()->generate64())
+{
+    compressPool.setMaxThreadCount(1);
+    rebuildRoutes();
+    rebuildResponse();
 }
 
-WebServerData WebServerDiag::getWebServerData() const
+WebServerDiag::~WebServerDiag()
+{
+    compressPool.waitForDone();
+    destroyWorkers();
+}
+
+const WebServerData &WebServerDiag::getWebServerData() const
 {
     return srvData;
 }
@@ -41,41 +64,21 @@ WebServerData WebServerDiag::getWebServerData() const
 void WebServerDiag::startServer(bool val)
 {
     if (!val) {
-        emit quitWaitLoop();
         srvData.setStarted(val);
-        for (QTcpServer* tcpServer : httpServer->servers()) {
-            tcpServer->close();
-            tcpServer->deleteLater();
-        }
+        publishData();
+        runOnWorkers([](ServerWorker* worker) {
+            worker->stop();
+        });
         return;
     }
 
-    srvData.setStarted(true);
-
-    httpServer->route(srvData.getEndpointPath(), QHttpServerRequest::Method::Get,
-                      [this](QHttpServerResponder&& responder) {
-            if (!srvData.isResponding()) {
-                QEventLoop loop;
-                connect(this, &WebServerDiag::quitWaitLoop, &loop, &QEventLoop::quit, Qt::DirectConnection);
-                loop.exec();
-            }
-            if (srvData.getEnableResponseDelay()) {
-                QEventLoop loop;
-                QTimer::singleShot(srvData.getResponseTime(), &loop, &QEventLoop::quit);
-                connect(this, &WebServerDiag::quitWaitLoop, &loop, &QEventLoop::quit);
-                loop.exec();
-            }
-
-            if (!srvData.isStarted()) {
-                return;
-            }
-
-            QHttpServerResponse httpResp(srvData.getPage(),
-                        static_cast<QHttpServerResponse::StatusCode>(srvData.getReturnCode()));
-            httpResp.write(std::move(responder));
+    if (workers.size() != workerCount) {
+        destroyWorkers();
+        createWorkers();
+    }
 
-        }
-    );
+    srvData.setStarted(true);
+    publishData();
 
     bool needListenSrv = srvData.isListen();
     enableListenPort(true);
@@ -96,76 +99,404 @@ void WebServerDiag::setPresenter(IPresenter *p)
 void WebServerDiag::enableListenPort(bool val)
 {
     srvData.setListen(val);
+    publishData();
     if (!srvData.isStarted()) {
         return;
     }
     if (val) {
-        quint16 res = httpServer->listen(QHostAddress(srvData.getHostname()), srvData.getPort());
+        QHostAddress address(srvData.getHostname());
+        quint16 port = srvData.getPort();
+        bool reusePort = workers.size() > 1;
+        bool res = true;
+        runOnWorkers([&](ServerWorker* worker) {
+            res = res && worker->listen(address, port, reusePort);
+        });
         if (!res) {
-            qWarning() << "Error binding server to address and port";
-            presenter->serverErrorHasOccurred("Failed to bind to address and port");
+            runOnWorkers([](ServerWorker* worker) {
+                worker->closeListeners();
+            });
+            reportError("Failed to bind to address and port");
             srvData.setErrorHasOccurred(true);
             srvData.setStarted(false);
+            publishData();
             return;
         }
         srvData.setErrorHasOccurred(false);
         srvData.setStarted(true);
+        publishData();
+        releaseParked();
     } else {
-        for (QTcpServer* tcpServer : httpServer->servers()) {
-            tcpServer->close();
-        }
+        runOnWorkers([](ServerWorker* worker) {
+            worker->closeListeners();
+        });
     }
 }
 
 void WebServerDiag::enableHttpResponse(bool val)
 {
     srvData.setResponding(val);
+    publishData();
     if (val) {
-        emit quitWaitLoop();
+        releaseParked();
     }
 }
 
 void WebServerDiag::enableResponseDelay(bool val)
 {
     srvData.enableResponseDelay(val);
+    publishData();
 }
 
 void WebServerDiag::httpResponseTimeChanged(int val)
 {
     srvData.setResponseTime(val);
+    publishData();
+}
+
+void WebServerDiag::setDelayDistribution(const LatencyDistribution &dist)
+{
+    srvData.setDelayDistribution(dist);
+    publishData();
+    runOnWorkers([](ServerWorker* worker) {
+        worker->resetLatency();
+    });
+}
+
+LatencySummary WebServerDiag::getLatencySummary() const
+{
+    LatencyHistogram merged;
+    for (const ServerWorker* worker : std::as_const(workers)) {
+        merged.merge(worker->workerMetrics().latency());
+    }
+    return merged.summary();
+}
+
+QByteArray WebServerDiag::metricsText() const
+{
+    QList<const WorkerMetrics*> shards;
+    for (const ServerWorker* worker : std::as_const(workers)) {
+        shards.append(&worker->workerMetrics());
+    }
+    QByteArray text = WorkerMetrics::render(shards);
+    if (accessLog) {
+        text += "# HELP wmd_access_log_dropped_total Access log records dropped on full buffers.\n"
+                "# TYPE wmd_access_log_dropped_total counter\n"
+                "wmd_access_log_dropped_total " + QByteArray::number(accessLog->dropped()) + "\n";
+    }
+    return text;
+}
+
+void WebServerDiag::setAccessLog(AccessLog *log)
+{
+    accessLog = log;
+    runOnWorkers([log](ServerWorker* worker) {
+        worker->setAccessLogBuffer(log ? log->createBuffer() : nullptr);
+    });
 }
 
 void WebServerDiag::setServerData(const WebServerData &data)
 {
     srvData = data;
+    rebuildRoutes();
+    rebuildResponse();
 }
 
 void WebServerDiag::setListenPortNumber(ushort port)
 {
+    ushort oldPort = srvData.getPort();
     srvData.setPort(port);
+    // A stopped server binds the port when it starts
+    if (!srvData.isStarted() || !srvData.isListen() || port == oldPort) {
+        publishData();
+        return;
+    }
+
+    // The new port listens before the old one is closed
+    QHostAddress address(srvData.getHostname());
+    bool reusePort = workers.size() > 1;
+    bool res = true;
+    runOnWorkers([&](ServerWorker* worker) {
+        res = res && worker->stageListener(address, port, reusePort);
+    });
+    if (!res) {
+        runOnWorkers([](ServerWorker* worker) {
+            worker->dropStagedListeners();
+        });
+        srvData.setPort(oldPort);
+        reportError(QString("Failed to bind to port %1, still listening on %2").arg(port).arg(oldPort));
+        return;
+    }
+
+    runOnWorkers([](ServerWorker* worker) {
+        worker->commitStagedListeners();
+    });
+    publishData();
 }
 
 void WebServerDiag::setHostname(const QString &hostname)
 {
     srvData.setHostname(hostname);
+    publishData();
 }
 
 void WebServerDiag::setEndpointPath(const QString &path)
 {
     srvData.setEndpointPath(path);
+    rebuildRoutes();
+    publishData();
 }
 
 void WebServerDiag::setResponseCode(int val)
 {
     srvData.setResponseCode(val);
+    rebuildResponse();
 }
 
-void WebServerDiag::setRespPage(const QString &newRespPage)
+void WebServerDiag::setRespPage(const std::shared_ptr<const PageData> &newRespPage)
 {
     srvData.setRespPage(newRespPage);
+    rebuildResponse();
+}
+
+void WebServerDiag::setStaticSite(const std::shared_ptr<const StaticSiteIndex> &newSite)
+{
+    site = newSite;
+    rebuildRoutes();
+    publishData();
 }
 
 void WebServerDiag::setReturnEmptyPage(bool emptyPage)
 {
     srvData.setReturnEmptyPage(emptyPage);
+    rebuildResponse();
+}
+
+void WebServerDiag::setCacheValidation(CacheValidation mode)
+{
+    srvData.setCacheValidation(mode);
+    publishData();
+}
+
+void WebServerDiag::setWorkerCount(int count)
+{
+    if (count > 1 && !DiagTcpServer::isReusePortSupported()) {
+        qWarning() << "Several workers need SO_REUSEPORT, which is not supported, using one worker";
+        count = 1;
+    }
+    workerCount = qMax(count, 1);
+}
+
+int WebServerDiag::getWorkerCount() const
+{
+    return workerCount;
+}
+
+void WebServerDiag::setSeed(quint64 val)
+{
+    seed = val;
+}
+
+void WebServerDiag::setParkLimit(int capacity, ParkOverflowPolicy policy)
+{
+    srvData.setParkCapacity(qMax(capacity, 0));
+    srvData.setParkOverflowPolicy(policy);
+    publishData();
+}
+
+void WebServerDiag::setBandwidthLimit(qint64 bytesPerSecond)
+{
+    srvData.setBandwidthLimit(qMax<qint64>(bytesPerSecond, 0));
+    publishData();
+}
+
+void WebServerDiag::setFaultPlan(const FaultPlan &plan)
+{
+    srvData.setFaultPlan(plan);
+    publishData();
+}
+
+void WebServerDiag::setTcpFault(TcpFault fault)
+{
+    srvData.setTcpFault(fault);
+    publishData();
+    runOnWorkers([](ServerWorker* worker) {
+        worker->applyTcpFault();
+    });
+}
+
+bool WebServerDiag::loadEndpoints(const QString &fileName, QString *error)
+{
+    error->clear();
+    QList<EndpointConfig> endpoints = EndpointConfig::loadList(fileName, error);
+    if (!error->isEmpty()) {
+        return false;
+    }
+    extraEndpoints = endpoints;
+    rebuildRoutes();
+    publishData();
+    return true;
+}
+
+void WebServerDiag::publishData()
+{
+    ServerSnapshot next;
+    next.data = srvData;
+    next.response = response;
+    next.gzipResponse = gzipResponse;
+    next.routes = routes;
+    next.site = site;
+    config.publish(std::move(next));
+}
+
+void WebServerDiag::reportError(const QString &str)
+{
+    // Used without a presenter by wmdbench
+    if (presenter) {
+        presenter->serverErrorHasOccurred(str);
+    } else {
+        qWarning() << str;
+    }
+}
+
+void WebServerDiag::rebuildResponse()
+{
+    static const QByteArray rangesHeader = "Accept-Ranges: bytes\r\n";
+    static const QByteArray varyHeader = "Vary: Accept-Encoding\r\n";
+
+    std::shared_ptr<const PageData> page = srvData.getPageData();
+    bool compressible = GzipEncoder::isCompressible(page->size());
+    QByteArray headers = rangesHeader;
+    if (compressible) {
+        headers += varyHeader;
+    }
+    QByteArray tag;
+    if (page->hasContentHash()) {
+        tag = HttpValidators::entityTag(page->contentHash());
+    } else if (page != hashPending) {
+        hashPage(page);
+    }
+    response = std::make_shared<const CachedResponse>(page, srvData.getReturnCode(), headers, QByteArray(),
+                                                      tag, page->modified());
+    gzipResponse.reset();
+    if (page != gzipSource) {
+        // Keeps no mapping of a page that is no longer served
+        gzipSource.reset();
+        gzipBody.clear();
+        if (compressible && page != gzipPending) {
+            compressPage(page);
+        }
+    } else if (!gzipBody.isEmpty()) {
+        gzipResponse = makeGzipResponse();
+    }
+    publishData();
+}
+
+void WebServerDiag::hashPage(const std::shared_ptr<const PageData> &page)
+{
+    // Served without validators until the hash is published
+    hashPending = page;
+    compressPool.start([this, page]() {
+        page->contentHash();
+        QMetaObject::invokeMethod(this, [this, page]() {
+            if (hashPending == page) {
+                hashPending.reset();
+            }
+            if (page == srvData.getPageData()) {
+                rebuildResponse();
+            }
+        });
+    });
+}
+
+void WebServerDiag::compressPage(const std::shared_ptr<const PageData> &page)
+{
+    // Identity responses are served until the variant is published
+    gzipPending = page;
+    compressPool.start([this, page]() {
+        QByteArray body = GzipEncoder::compress(page->bytes());
+        QMetaObject::invokeMethod(this, [this, page, body]() {
+            if (gzipPending == page) {
+                gzipPending.reset();
+            }
+            // Dropped when another page was selected in the meantime
+            if (page != srvData.getPageData()) {
+                return;
+            }
+            gzipSource = page;
+            // A page that does not get smaller is only served as is
+            gzipBody = body.size() < page->size() ? body : QByteArray();
+            if (!gzipBody.isEmpty()) {
+                gzipResponse = makeGzipResponse();
+                publishData();
+            }
+        });
+    });
+}
+
+std::shared_ptr<const CachedResponse> WebServerDiag::makeGzipResponse() const
+{
+    static const QByteArray gzipHeaders = "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n";
+    return std::make_shared<const CachedResponse>(PageData::fromBytes(gzipBody), response->statusCode(),
+                                                  gzipHeaders, response->contentType(),
+                                                  gzipSource->hasContentHash()
+                                                  ? HttpValidators::entityTag(gzipSource->contentHash(), "gzip")
+                                                  : QByteArray(),
+                                                  gzipSource->modified());
+}
+
+void WebServerDiag::rebuildRoutes()
+{
+    auto table = std::make_shared<RouteTable>();
+    for (const EndpointConfig& endpoint : std::as_const(extraEndpoints)) {
+        table->insert(endpoint);
+    }
+
+    EndpointConfig mainEndpoint;
+    mainEndpoint.path = srvData.getEndpointPath();
+    mainEndpoint.mainEndpoint = true;
+    table->insert(mainEndpoint);
+    if (site) {
+        // Every file below the endpoint path
+        EndpointConfig siteEndpoint = mainEndpoint;
+        siteEndpoint.path = (mainEndpoint.path.endsWith('/') ? mainEndpoint.path : mainEndpoint.path + '/') + '*';
+        table->insert(siteEndpoint);
+    }
+
+    routes = std::move(table);
+}
+
+void WebServerDiag::releaseParked()
+{
+    for (ServerWorker* worker : std::as_const(workers)) {
+        QMetaObject::invokeMethod(worker, &ServerWorker::releaseParked, Qt::QueuedConnection);
+    }
+}
+
+void WebServerDiag::createWorkers()
+{
+    for (int i = 0; i < workerCount; ++i) {
+        QThread* thread = new QThread(this);
+        thread->setObjectName(QString("wmd-worker-%1").arg(i));
+        ServerWorker* worker = new ServerWorker(&config, seed + static_cast<quint64>(i));
+        if (accessLog) {
+            worker->setAccessLogBuffer(accessLog->createBuffer());
+        }
+        worker->moveToThread(thread);
+        connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+        thread->start();
+
+        workerThreads.append(thread);
+        workers.append(worker);
+    }
+}
+
+void WebServerDiag::destroyWorkers()
+{
+    for (QThread* thread : std::as_const(workerThreads)) {
+        thread->quit();
+        thread->wait();
+        delete thread;
+    }
+    workerThreads.clear();
+    workers.clear();
 }
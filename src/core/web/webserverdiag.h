@@ -22,9 +22,15 @@
 #ifndef WEBSERVERDIAG_H
 #define WEBSERVERDIAG_H
 
-#include <QtHttpServer/QHttpServer>
+#include <QObject>
+#include <QThreadPool>
 
 #include "../iwebserverdiag.h"
+#include "serverconfig.h"
+
+class ServerWorker;
+class QThread;
+class AccessLog;
 
 class WebServerDiag: public QObject, public IWebServerDiag
 {
@@ -32,8 +38,9 @@ class WebServerDiag: public QObject, public IWebServerDiag
 
 public:
     WebServerDiag(QObject* parent = nullptr);
+    ~WebServerDiag();
 
-    WebServerData getWebServerData() const override;
+    const WebServerData& getWebServerData() const override;
 
     void startServer(bool val) override;
     void setPresenter(IPresenter* p) override;
@@ -41,22 +48,82 @@ public:
     void enableHttpResponse(bool val) override;
     void enableResponseDelay(bool val) override;
     void httpResponseTimeChanged(int val) override;
+    void setDelayDistribution(const LatencyDistribution& dist) override;
+    LatencySummary getLatencySummary() const override;
 
     void setServerData(const WebServerData& data) override;
     void setListenPortNumber(ushort port) override;
     void setHostname(const QString& hostname) override;
     void setEndpointPath(const QString& path) override;
     void setResponseCode(int val) override;
-    void setRespPage(const QString &newRespPage) override;
+    void setRespPage(const std::shared_ptr<const PageData>& newRespPage) override;
     void setReturnEmptyPage(bool emptyPage) override;
+    void setCacheValidation(CacheValidation mode) override;
+    void setStaticSite(const std::shared_ptr<const StaticSiteIndex>& newSite) override;
+
+    // Takes effect on the next start
+    void setWorkerCount(int count);
+    int getWorkerCount() const;
+
+    // Prometheus metrics of all workers
+    QByteArray metricsText() const;
+
+    // Worker i draws delays from a generator seeded with seed + i.
+    // Takes effect on the next start.
+    void setSeed(quint64 seed);
+
+    // Capacity is per worker thread
+    void setParkLimit(int capacity, ParkOverflowPolicy policy);
 
-signals:
-    void quitWaitLoop();
+    // Bytes per second of every connection to the main endpoint, 0 is unlimited
+    void setBandwidthLimit(qint64 bytesPerSecond);
+
+    // Faults injected into requests to the main endpoint
+    void setFaultPlan(const FaultPlan& plan);
+
+    // Failure of every listener below HTTP, see TcpFault
+    void setTcpFault(TcpFault fault);
+
+    // Every worker gets its own buffer of the log. The log must outlive the server.
+    void setAccessLog(AccessLog* log);
+
+    // Endpoints served next to the main one, see EndpointConfig::loadList
+    bool loadEndpoints(const QString& fileName, QString* error);
 
 private:
+    void publishData();
+    void reportError(const QString& str);
+    void rebuildResponse();
+    void hashPage(const std::shared_ptr<const PageData>& page);
+    void compressPage(const std::shared_ptr<const PageData>& page);
+    std::shared_ptr<const CachedResponse> makeGzipResponse() const;
+    void rebuildRoutes();
+    void releaseParked();
+    void createWorkers();
+    void destroyWorkers();
+    template <typename Func>
+    void runOnWorkers(Func func);
+
     WebServerData srvData;
-    std::shared_ptr<QHttpServer> httpServer;
-    IPresenter* presenter;
+    ServerConfig config;
+    std::shared_ptr<const CachedResponse> response;
+    std::shared_ptr<const CachedResponse> gzipResponse;
+    // Compressed body of the page that was compressed last, reused when
+    // only the status code changes
+    std::shared_ptr<const PageData> gzipSource;
+    std::shared_ptr<const PageData> gzipPending;
+    QByteArray gzipBody;
+    std::shared_ptr<const PageData> hashPending;
+    QThreadPool compressPool;
+    std::shared_ptr<const RouteTable> routes;
+    std::shared_ptr<const StaticSiteIndex> site;
+    QList<EndpointConfig> extraEndpoints;
+    QList<QThread*> workerThreads;
+    QList<ServerWorker*> workers;
+    int workerCount = 1;
+    quint64 seed;
+    IPresenter* presenter = nullptr;
+    AccessLog* accessLog = nullptr;
 };
 
 #endif // WEBSERVERDIAG_H
@@ -0,0 +1,195 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "workermetrics.h"
+
+#include <QMap>
+
+static void increment(std::atomic<quint64>& counter)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+static QByteArray escapeLabel(const QString& str)
+{
+    QByteArray res = str.toUtf8();
+    res.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+    return res;
+}
+
+WorkerMetrics::Endpoint::Endpoint()
+{
+    for (std::atomic<quint64>& code : codes) {
+        code.store(0, std::memory_order_relaxed);
+    }
+}
+
+WorkerMetrics::WorkerMetrics()
+    : resets(0),
+      parked(0),
+      compressionSaved(0)
+{
+    for (std::atomic<quint64>& fault : faults) {
+        fault.store(0, std::memory_order_relaxed);
+    }
+}
+
+void WorkerMetrics::recordResponse(const QString &endpoint, int statusCode, quint64 latencyUs)
+{
+    Endpoint* metrics = nullptr;
+    auto it = endpoints.constFind(endpoint);
+    if (it != endpoints.constEnd()) {
+        metrics = it.value().get();
+    } else {
+        auto created = std::make_shared<Endpoint>();
+        metrics = created.get();
+        QMutexLocker locker(&endpointsMutex);
+        endpoints.insert(endpoint, std::move(created));
+    }
+
+    increment(metrics->codes[static_cast<size_t>(statusCode >= 0 && statusCode < statusCodeCount ? statusCode : 0)]);
+    metrics->latency.record(latencyUs);
+    overall.record(latencyUs);
+}
+
+void WorkerMetrics::recordReset()
+{
+    increment(resets);
+}
+
+void WorkerMetrics::recordParked()
+{
+    increment(parked);
+}
+
+void WorkerMetrics::recordCompressionSaved(quint64 bytes)
+{
+    compressionSaved.store(compressionSaved.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+}
+
+void WorkerMetrics::recordFault(FaultPlan::Action action)
+{
+    increment(faults[static_cast<size_t>(action)]);
+}
+
+const LatencyHistogram &WorkerMetrics::latency() const
+{
+    return overall;
+}
+
+void WorkerMetrics::resetLatency()
+{
+    overall.reset();
+}
+
+QList<QPair<QString, std::shared_ptr<const WorkerMetrics::Endpoint>>> WorkerMetrics::endpointList() const
+{
+    QList<QPair<QString, std::shared_ptr<const Endpoint>>> res;
+    QMutexLocker locker(&endpointsMutex);
+    for (auto it = endpoints.constBegin(); it != endpoints.constEnd(); ++it) {
+        res.append({it.key(), it.value()});
+    }
+    return res;
+}
+
+QByteArray WorkerMetrics::render(const QList<const WorkerMetrics *> &shards)
+{
+    // Bucket bounds in seconds, the histogram itself is much finer
+    static const double bounds[] = {0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5,
+                                    1, 2.5, 5, 10, 30, 60};
+
+    QMap<QString, std::shared_ptr<Endpoint>> merged;
+    quint64 totalResets = 0;
+    quint64 totalParked = 0;
+    quint64 totalSaved = 0;
+    std::array<quint64, FaultPlan::actionCount> totalFaults = {};
+    for (const WorkerMetrics* shard : shards) {
+        const auto list = shard->endpointList();
+        for (const auto& item : list) {
+            std::shared_ptr<Endpoint>& target = merged[item.first];
+            if (!target) {
+                target = std::make_shared<Endpoint>();
+            }
+            for (size_t i = 0; i < target->codes.size(); ++i) {
+                target->codes[i].fetch_add(item.second->codes[i].load(std::memory_order_relaxed),
+                                           std::memory_order_relaxed);
+            }
+            target->latency.merge(item.second->latency);
+        }
+        totalResets += shard->resets.load(std::memory_order_relaxed);
+        totalParked += shard->parked.load(std::memory_order_relaxed);
+        totalSaved += shard->compressionSaved.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < totalFaults.size(); ++i) {
+            totalFaults[i] += shard->faults[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    QByteArray res;
+    res += "# HELP wmd_requests_total Responses sent, by endpoint and status code.\n"
+           "# TYPE wmd_requests_total counter\n";
+    for (auto it = merged.cbegin(); it != merged.cend(); ++it) {
+        QByteArray endpoint = escapeLabel(it.key());
+        for (int code = 0; code < statusCodeCount; ++code) {
+            quint64 count = it.value()->codes[static_cast<size_t>(code)].load(std::memory_order_relaxed);
+            if (count > 0) {
+                res += "wmd_requests_total{endpoint=\"" + endpoint + "\",code=\"" +
+                       QByteArray::number(code) + "\"} " + QByteArray::number(count) + '\n';
+            }
+        }
+    }
+
+    res += "# HELP wmd_request_duration_seconds Time from dispatch to response, including the simulated delay.\n"
+           "# TYPE wmd_request_duration_seconds histogram\n";
+    for (auto it = merged.cbegin(); it != merged.cend(); ++it) {
+        QByteArray prefix = "wmd_request_duration_seconds_bucket{endpoint=\"" + escapeLabel(it.key()) + "\",le=\"";
+        const LatencyHistogram& latency = it.value()->latency;
+        for (double bound : bounds) {
+            res += prefix + QByteArray::number(bound) + "\"} " +
+                   QByteArray::number(latency.countAtOrBelow(static_cast<quint64>(bound * 1e6))) + '\n';
+        }
+        res += prefix + "+Inf\"} " + QByteArray::number(latency.count()) + '\n';
+        QByteArray labels = "{endpoint=\"" + escapeLabel(it.key()) + "\"} ";
+        res += "wmd_request_duration_seconds_sum" + labels +
+               QByteArray::number(static_cast<double>(latency.sum()) / 1e6, 'g', 12) + '\n';
+        res += "wmd_request_duration_seconds_count" + labels + QByteArray::number(latency.count()) + '\n';
+    }
+
+    res += "# HELP wmd_connections_reset_total Connections reset on purpose.\n"
+           "# TYPE wmd_connections_reset_total counter\n"
+           "wmd_connections_reset_total " + QByteArray::number(totalResets) + '\n';
+    res += "# HELP wmd_requests_parked_total Requests held while HTTP response was disabled.\n"
+           "# TYPE wmd_requests_parked_total counter\n"
+           "wmd_requests_parked_total " + QByteArray::number(totalParked) + '\n';
+    res += "# HELP wmd_compression_saved_bytes_total Body bytes saved by serving the gzip variant.\n"
+           "# TYPE wmd_compression_saved_bytes_total counter\n"
+           "wmd_compression_saved_bytes_total " + QByteArray::number(totalSaved) + '\n';
+    res += "# HELP wmd_faults_injected_total Requests hit by the fault plan, by fault.\n"
+           "# TYPE wmd_faults_injected_total counter\n";
+    for (size_t i = 1; i < totalFaults.size(); ++i) {
+        res += QByteArray("wmd_faults_injected_total{fault=\"") +
+               FaultPlan::actionName(static_cast<FaultPlan::Action>(i)) + "\"} " +
+               QByteArray::number(totalFaults[i]) + '\n';
+    }
+    res += "# HELP wmd_workers Worker threads serving requests.\n"
+           "# TYPE wmd_workers gauge\n"
+           "wmd_workers " + QByteArray::number(shards.size()) + '\n';
+    return res;
+}
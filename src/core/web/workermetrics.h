@@ -0,0 +1,81 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WORKERMETRICS_H
+#define WORKERMETRICS_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+#include "latencyhistogram.h"
+#include "faultplan.h"
+
+// Counters of one worker thread. Only the worker writes, so recording is a
+// relaxed load and store without locking. Any thread may read and merge the
+// shards of all workers.
+class WorkerMetrics
+{
+public:
+    static const int statusCodeCount = 600;
+
+    struct Endpoint {
+        Endpoint();
+
+        std::array<std::atomic<quint64>, statusCodeCount> codes;
+        LatencyHistogram latency;
+    };
+
+    WorkerMetrics();
+
+    void recordResponse(const QString& endpoint, int statusCode, quint64 latencyUs);
+    void recordReset();
+    void recordParked();
+    // Body bytes not sent because the compressed variant was served
+    void recordCompressionSaved(quint64 bytes);
+    void recordFault(FaultPlan::Action action);
+
+    // All endpoints of the worker, this one is not limited to the main one
+    const LatencyHistogram& latency() const;
+    void resetLatency();
+
+    // Prometheus text exposition of the merged shards
+    static QByteArray render(const QList<const WorkerMetrics*>& shards);
+
+private:
+    QList<QPair<QString, std::shared_ptr<const Endpoint>>> endpointList() const;
+
+    QHash<QString, std::shared_ptr<Endpoint>> endpoints;
+    // Held by the writer only to insert, and by readers to list endpoints
+    mutable QMutex endpointsMutex;
+    LatencyHistogram overall;
+    std::atomic<quint64> resets;
+    std::atomic<quint64> parked;
+    std::atomic<quint64> compressionSaved;
+    std::array<std::atomic<quint64>, FaultPlan::actionCount> faults;
+};
+
+#endif // WORKERMETRICS_H
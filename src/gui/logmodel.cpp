@@ -0,0 +1,137 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "logmodel.h"
+
+#include <QColor>
+
+LogModel::LogModel(int capacity, QObject *parent)
+    : QAbstractListModel(parent),
+      ring(qMax(1, capacity))
+{
+    frameTimer.setSingleShot(true);
+    frameTimer.setInterval(frameIntervalMs);
+    connect(&frameTimer, &QTimer::timeout, this, &LogModel::commit);
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : count;
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= count) {
+        return QVariant();
+    }
+
+    const LogLine& line = lineAt(index.row());
+    switch (role)
+    {
+        case Qt::DisplayRole:
+            return line.text;
+        case Qt::ForegroundRole:
+            switch (line.level)
+            {
+                case LogLevel::Debug:
+                    return QColor(Qt::gray);
+                case LogLevel::Notice:
+                    return QColor(Qt::blue);
+                case LogLevel::Warning:
+                    return QColor(0xC0, 0x70, 0x00);
+                case LogLevel::Error:
+                    return QColor(Qt::red);
+                default:
+                    return QVariant();
+            }
+        default:
+            return QVariant();
+    }
+}
+
+void LogModel::append(const QList<LogLine> &lines)
+{
+    incoming.append(lines);
+    // Only the newest lines can survive the commit
+    if (incoming.size() > ring.size()) {
+        incoming.remove(0, incoming.size() - ring.size());
+    }
+    if (!frameTimer.isActive()) {
+        frameTimer.start();
+    }
+}
+
+void LogModel::setCapacity(int val)
+{
+    val = qMax(1, val);
+    if (val == ring.size()) {
+        return;
+    }
+
+    beginResetModel();
+    QVector<LogLine> resized(val);
+    int kept = qMin(count, val);
+    for (int i = 0; i < kept; ++i) {
+        resized[i] = lineAt(count - kept + i);
+    }
+    ring.swap(resized);
+    first = 0;
+    count = kept;
+    endResetModel();
+}
+
+int LogModel::capacity() const
+{
+    return static_cast<int>(ring.size());
+}
+
+void LogModel::commit()
+{
+    if (incoming.isEmpty()) {
+        return;
+    }
+
+    int cap = capacity();
+    if (incoming.size() > cap) {
+        incoming.remove(0, incoming.size() - cap);
+    }
+    int added = static_cast<int>(incoming.size());
+    int removed = qMin(count + added - cap, count);
+    if (removed > 0) {
+        beginRemoveRows(QModelIndex(), 0, removed - 1);
+        first = (first + removed) % cap;
+        count -= removed;
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), count, count + added - 1);
+    for (const LogLine& line : std::as_const(incoming)) {
+        ring[(first + count) % cap] = line;
+        ++count;
+    }
+    endInsertRows();
+    incoming.clear();
+}
+
+const LogLine &LogModel::lineAt(int row) const
+{
+    return ring[(first + row) % capacity()];
+}
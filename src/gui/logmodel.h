@@ -0,0 +1,63 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOGMODEL_H
+#define LOGMODEL_H
+
+#include <QAbstractListModel>
+#include <QTimer>
+#include <QVector>
+
+#include "../core/logline.h"
+
+// Keeps the last capacity() lines in a ring. Appended lines are collected
+// and committed to the attached views once per frame.
+class LogModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    static const int defaultCapacity = 10000;
+    static const int frameIntervalMs = 16;
+
+    LogModel(int capacity = defaultCapacity, QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    void append(const QList<LogLine>& lines);
+    void setCapacity(int val);
+    int capacity() const;
+
+    // Commits the lines collected since the last frame
+    void commit();
+
+private:
+    const LogLine& lineAt(int row) const;
+
+    QVector<LogLine> ring;
+    int first = 0;
+    int count = 0;
+    QList<LogLine> incoming;
+    QTimer frameTimer;
+};
+
+#endif // LOGMODEL_H
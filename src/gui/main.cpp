@@ -20,25 +20,69 @@
  */
 
 #include "mainwindow.h"
+#include "logmodel.h"
 #include "../core/serverpresenter.h"
 #include "../core/web/webserverdiag.h"
+#include "../core/web/socketutils.h"
 #include "../core/logger.h"
+#include "../core/scenarioengine.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
 
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+    SocketUtils::ignoreSigPipe();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Web Monitoring Diagnistics");
+    parser.addHelpOption();
+    Logger::addOptions(parser);
+    QCommandLineOption logCapacityOption("log-capacity", "Number of log lines kept in the window", "lines",
+                                         QString::number(LogModel::defaultCapacity));
+    parser.addOption(logCapacityOption);
+    QCommandLineOption scenarioOption("scenario", "Timeline of state changes replayed from the start", "file");
+    parser.addOption(scenarioOption);
+    parser.process(a);
+
+    bool logCapacityChk = false;
+    int logCapacity = parser.value(logCapacityOption).toInt(&logCapacityChk);
+    if (!logCapacityChk || logCapacity < 1) {
+        qCritical().noquote() << "Invalid log capacity:" << parser.value(logCapacityOption);
+        return 1;
+    }
 
     WebServerDiag webSrv;
     MainWindow mainWindow;
+    mainWindow.setLogCapacity(logCapacity);
 
     Logger logger(&mainWindow);
-    logger.setTextAsHtml(true);
+    QString logError;
+    if (!logger.applyOptions(parser, &logError)) {
+        qCritical().noquote() << logError;
+        return 1;
+    }
 
     ServerPresenter serverPresentor(&mainWindow, &webSrv, &logger);
+    ScenarioEngine scenario(&serverPresentor);
+    if (parser.isSet(scenarioOption)) {
+        QString error;
+        if (!scenario.load(parser.value(scenarioOption), &error)) {
+            qCritical().noquote() << error;
+            return 1;
+        }
+        QObject::connect(&scenario, &ScenarioEngine::stepExecuted, &logger,
+                         [&logger](const QString& description, double lateMs) {
+            logger.addHighlightedMessage(QString("Scenario: %1 (%2 ms late)").arg(description).arg(lateMs, 0, 'f', 3));
+        });
+    }
     serverPresentor.showView();
+    if (parser.isSet(scenarioOption)) {
+        scenario.start();
+    }
 
     return a.exec();
 }
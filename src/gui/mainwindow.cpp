@@ -21,6 +21,7 @@
 
 #include "mainwindow.h"
 #include "../core/ipresenter.h"
+#include "logmodel.h"
 
 #include <QBoxLayout>
 #include <QPushButton>
@@ -30,7 +31,8 @@
 #include <QCheckBox>
 #include <QComboBox>
 #include <QGroupBox>
-#include <QTextEdit>
+#include <QListView>
+#include <QScrollBar>
 #include <QFileDialog>
 
 MainWindow::MainWindow(QWidget *parent)
@@ -53,12 +55,28 @@ MainWindow::MainWindow(QWidget *parent)
     vlt->addWidget(resetBtn);
     vlt->addWidget(startBtn);
 
-    logTedt = new QTextEdit;
-    logTedt->setReadOnly(true);
+    logModel = new LogModel(LogModel::defaultCapacity, this);
+    logView = new QListView;
+    logView->setModel(logModel);
+    logView->setUniformItemSizes(true);
+    logView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    logView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    logView->setMinimumWidth(400);
+
+    // Follow new lines unless the user scrolled up
+    connect(logModel, &LogModel::rowsAboutToBeInserted, this, [this]() {
+        QScrollBar* bar = logView->verticalScrollBar();
+        logAtBottom = bar->value() == bar->maximum();
+    });
+    connect(logModel, &LogModel::rowsInserted, this, [this]() {
+        if (logAtBottom) {
+            logView->scrollToBottom();
+        }
+    });
 
     QHBoxLayout* hltMain = new QHBoxLayout;
     hltMain->addLayout(vlt);
-    hltMain->addWidget(logTedt);
+    hltMain->addWidget(logView);
 
     QWidget* widget = new QWidget;
     widget->setLayout(hltMain);
@@ -78,6 +96,9 @@ void MainWindow::setPresenter(IPresenter *val)
     connect(responseTimeSpb, &QSpinBox::editingFinished, this, [this]() {
         presenter->httpResponseTimeChanged(responseTimeSpb->value());
     });
+    connect(delayDistLedt, &QLineEdit::editingFinished, this, [this]() {
+        presenter->delayDistributionChanged(delayDistLedt->text());
+    });
     connect(returnCodeCmb, &QComboBox::currentTextChanged, this, [this]() {
         presenter->returnCodeChanged(returnCodeCmb->currentText().toInt());
     });
@@ -96,7 +117,14 @@ void MainWindow::setPresenter(IPresenter *val)
                                     tr("Open Web Page"), "", tr("All files (*.*);;HTML Files (*.htm *.html)"));
         presenter->newWebPageSelected(path);
     });
+    connect(openSiteDirBtn, &QPushButton::clicked, this, [this]() {
+        QString path = QFileDialog::getExistingDirectory(this, tr("Open Site Directory"));
+        if (!path.isEmpty()) {
+            presenter->newSiteDirectorySelected(path);
+        }
+    });
     connect(returnEmptyPage, &QCheckBox::clicked, presenter, &IPresenter::setReturnEmptyPage);
+    connect(cacheValidationCmb, &QComboBox::currentTextChanged, presenter, &IPresenter::cacheValidationChanged);
 
 }
 
@@ -135,6 +163,21 @@ void MainWindow::setResponseTime(int val)
     responseTimeSpb->setValue(val);
 }
 
+void MainWindow::setDelayDistribution(const QString &spec)
+{
+    delayDistLedt->setText(spec);
+}
+
+void MainWindow::showLatency(const LatencySummary &summary)
+{
+    latencyLbl->setText(QString("p50 %1 / p95 %2 / p99 %3 ms")
+                            .arg(summary.p50Us / 1000.0, 0, 'f', 1)
+                            .arg(summary.p95Us / 1000.0, 0, 'f', 1)
+                            .arg(summary.p99Us / 1000.0, 0, 'f', 1));
+    latencyLbl->setToolTip(QString("%1 requests, max %2 ms").arg(summary.count)
+                               .arg(summary.maxUs / 1000.0, 0, 'f', 1));
+}
+
 void MainWindow::setHostname(const QString &val)
 {
     srvHostnameLedt->setText(val);
@@ -155,6 +198,11 @@ void MainWindow::setReturnEmptyPage(bool val)
     returnEmptyPage->setChecked(val);
 }
 
+void MainWindow::setCacheValidation(const QString &mode)
+{
+    cacheValidationCmb->setCurrentIndex(cacheValidationCmb->findText(mode));
+}
+
 void MainWindow::showView()
 {
     show();
@@ -194,10 +242,14 @@ void MainWindow::showRunningState(int port)
     mainLabel->setText("Running on\n" + QString::number(port) + " port");
 }
 
-void MainWindow::appendLog(const QString &str)
+void MainWindow::appendLog(const QList<LogLine> &lines)
+{
+    logModel->append(lines);
+}
+
+void MainWindow::setLogCapacity(int lines)
 {
-    logTedt->insertHtml(str);
-    logTedt->moveCursor(QTextCursor::End);
+    logModel->setCapacity(lines);
 }
 
 QGroupBox* MainWindow::createEndpointBox()
@@ -243,6 +295,15 @@ QGroupBox *MainWindow::createApplicationBox()
     responseTimeSpb->setValue(1);
     responseTimeSpb->setToolTip("Amount of time to respond");
 
+    QLabel* delayDistLbl = new QLabel("Delay distribution");
+    delayDistLedt = new QLineEdit;
+    delayDistLedt->setToolTip("50, uniform:min=10,max=200, normal:mean=100,stddev=20,\n"
+                              "lognormal:mu=4,sigma=0.5, pareto:scale=20,shape=1.5,\n"
+                              "empirical:file=latencies.txt");
+
+    QLabel* latencyTitleLbl = new QLabel("Measured latency");
+    latencyLbl = new QLabel("-");
+
     returnCodeCmb = new QComboBox;
     returnCodeCmb->addItems(QStringList{"0", "100", "101", "102", "103", "200", "201",
                                         "202", "203", "204", "205", "206", "207", "208",
@@ -260,8 +321,12 @@ QGroupBox *MainWindow::createApplicationBox()
     glt->addWidget(endpointPathLedt, 1, 1);
     glt->addWidget(responseTimeChkb, 2, 0);
     glt->addWidget(responseTimeSpb, 2, 1);
-    glt->addWidget(retCodeLbl, 3, 0);
-    glt->addWidget(returnCodeCmb, 3, 1);
+    glt->addWidget(delayDistLbl, 3, 0);
+    glt->addWidget(delayDistLedt, 3, 1);
+    glt->addWidget(latencyTitleLbl, 4, 0);
+    glt->addWidget(latencyLbl, 4, 1);
+    glt->addWidget(retCodeLbl, 5, 0);
+    glt->addWidget(returnCodeCmb, 5, 1);
 
     QGroupBox* grpBox = new QGroupBox("Application");
     grpBox->setLayout(glt);
@@ -271,16 +336,30 @@ QGroupBox *MainWindow::createApplicationBox()
 QGroupBox* MainWindow::createWebPageBox()
 {
     openPageFileBtn = new QPushButton("Select web page");
+    openSiteDirBtn = new QPushButton("Select site directory");
+    openSiteDirBtn->setToolTip("Serve every file of the directory under its relative path");
     currentWebPageLabel = new QLabel;
     MainWindow::setWebPageName("None");
 
     returnEmptyPage = new QCheckBox("Return empty web page");
     returnEmptyPage->setToolTip("Empty page will be shown if checked, otherwise the selected page");
 
+    QLabel* cacheValidationLbl = new QLabel("Cache validation");
+    cacheValidationCmb = new QComboBox;
+    cacheValidationCmb->addItems(QStringList{"normal", "changed", "unchanged"});
+    cacheValidationCmb->setToolTip("Answer to conditional requests: 304 when the page matches,\n"
+                                   "never 304 (changed) or always 304 (unchanged)");
+
+    QHBoxLayout* cacheHlt = new QHBoxLayout;
+    cacheHlt->addWidget(cacheValidationLbl);
+    cacheHlt->addWidget(cacheValidationCmb);
+
     QVBoxLayout* vlt = new QVBoxLayout;
     vlt->addWidget(openPageFileBtn);
+    vlt->addWidget(openSiteDirBtn);
     vlt->addWidget(currentWebPageLabel);
     vlt->addWidget(returnEmptyPage);
+    vlt->addLayout(cacheHlt);
 
     QGroupBox* grpBox = new QGroupBox("Web page");
     grpBox->setLayout(vlt);
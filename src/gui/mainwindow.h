@@ -33,7 +33,8 @@ class QCheckBox;
 class QComboBox;
 class QGroupBox;
 class QLineEdit;
-class QTextEdit;
+class QListView;
+class LogModel;
 
 class MainWindow : public QMainWindow, public IView
 {
@@ -48,14 +49,19 @@ public:
     void enableResponding(bool val) override;
     void setResponseCode(int val) override;
     void setResponseTime(int val) override;
+    void setDelayDistribution(const QString& spec) override;
+    void showLatency(const LatencySummary& summary) override;
     void setHostname(const QString &val) override;
     void setEndpointPath(const QString& val) override;
     void setPort(ushort val) override;
     void setReturnEmptyPage(bool val) override;
+    void setCacheValidation(const QString& mode) override;
     void showView() override;
     void enableResponseDelay(bool val) override;
     void setWebPageName(const QString& name) override;
-    void appendLog(const QString& str) override;
+    void appendLog(const QList<LogLine>& lines) override;
+
+    void setLogCapacity(int lines);
 
 private:
     void showRunningState(int port);
@@ -70,9 +76,12 @@ private:
     QLabel* currentWebPageLabel;
     QLineEdit* srvHostnameLedt;
     QLineEdit* endpointPathLedt;
+    QLineEdit* delayDistLedt;
+    QLabel* latencyLbl;
     QPushButton* startBtn;
     QPushButton* resetBtn;
     QPushButton* openPageFileBtn;
+    QPushButton* openSiteDirBtn;
     QCheckBox* respondsChkb;
     QCheckBox* responseTimeChkb;
     QCheckBox* listeningChkb;
@@ -80,8 +89,11 @@ private:
     QSpinBox* portSpb;
     QSpinBox* responseTimeSpb;
     QComboBox* returnCodeCmb;
+    QComboBox* cacheValidationCmb;
     QGroupBox* srvAppBox;
-    QTextEdit* logTedt;
+    QListView* logView;
+    LogModel* logModel;
+    bool logAtBottom = true;
     IPresenter* presenter;
 };
 
@@ -0,0 +1,176 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QHostAddress>
+
+#include "../src/core/web/accesslog.h"
+
+class TestAccessLog: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void ringWrapsAround();
+    void fullBufferDrops();
+    void jsonLines();
+    void commonLogFormat();
+    void longPathKeepsCharacters();
+    void wakesOnRecord();
+
+private:
+    static AccessRecord makeRecord(const QString& path, int code);
+    static QList<QByteArray> writeAndRead(AccessLog::Format fmt, const QList<AccessRecord>& records);
+};
+
+AccessRecord TestAccessLog::makeRecord(const QString &path, int code)
+{
+    AccessRecord record;
+    record.timestampUs = 1700000000123456;
+    record.bytes = 512;
+    record.delayMs = 20;
+    record.statusCode = static_cast<quint16>(code);
+    record.setClient(QHostAddress("127.0.0.1"));
+    record.setPath(path);
+    return record;
+}
+
+QList<QByteArray> TestAccessLog::writeAndRead(AccessLog::Format fmt, const QList<AccessRecord> &records)
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("access.log");
+    {
+        AccessLog log;
+        if (!log.open(fileName, fmt)) {
+            return {};
+        }
+        std::shared_ptr<AccessLogBuffer> buffer = log.createBuffer();
+        for (const AccessRecord& record : records) {
+            buffer->push(record);
+        }
+    }
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    QList<QByteArray> lines = file.readAll().split('\n');
+    lines.removeAll(QByteArray());
+    return lines;
+}
+
+void TestAccessLog::ringWrapsAround()
+{
+    SpscRing<int> ring(5);
+    QCOMPARE(ring.capacity(), size_t(8));
+
+    int out[8];
+    int next = 0;
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < 6; ++i) {
+            QVERIFY(ring.push(round * 6 + i));
+        }
+        size_t count = ring.pop(out, 8);
+        QCOMPARE(count, size_t(6));
+        for (size_t i = 0; i < count; ++i) {
+            QCOMPARE(out[i], next++);
+        }
+    }
+    QVERIFY(ring.isEmpty());
+}
+
+void TestAccessLog::fullBufferDrops()
+{
+    AccessLogBuffer buffer(4);
+    AccessRecord record = makeRecord("/", 200);
+    for (int i = 0; i < 10; ++i) {
+        buffer.push(record);
+    }
+    QCOMPARE(buffer.dropped(), quint64(6));
+
+    AccessRecord out[10];
+    QCOMPARE(buffer.pop(out, 10), size_t(4));
+    QVERIFY(buffer.isEmpty());
+}
+
+void TestAccessLog::jsonLines()
+{
+    QList<QByteArray> lines = writeAndRead(AccessLog::Format::JsonLines,
+                                           {makeRecord("/api/\"x\"", 200), makeRecord("/missing", 404)});
+    QCOMPARE(lines.size(), 2);
+
+    QJsonParseError error;
+    QJsonObject first = QJsonDocument::fromJson(lines[0], &error).object();
+    QCOMPARE(error.error, QJsonParseError::NoError);
+    QCOMPARE(first["ts"].toString(), QString("2023-11-14T22:13:20.123Z"));
+    QCOMPARE(first["client"].toString(), QString("127.0.0.1"));
+    QCOMPARE(first["path"].toString(), QString("/api/\"x\""));
+    QCOMPARE(first["code"].toInt(), 200);
+    QCOMPARE(first["delay_ms"].toInt(), 20);
+    QCOMPARE(first["bytes"].toInt(), 512);
+
+    QJsonObject second = QJsonDocument::fromJson(lines[1]).object();
+    QCOMPARE(second["code"].toInt(), 404);
+}
+
+void TestAccessLog::commonLogFormat()
+{
+    QList<QByteArray> lines = writeAndRead(AccessLog::Format::Clf, {makeRecord("/index.html", 200)});
+    QCOMPARE(lines.size(), 1);
+    QCOMPARE(lines[0], QByteArray("127.0.0.1 - - [14/Nov/2023:22:13:20 +0000] \"GET /index.html HTTP/1.1\" 200 512 20"));
+
+    lines = writeAndRead(AccessLog::Format::Clf, {makeRecord("/a b/\"x\"", 200)});
+    QCOMPARE(lines.size(), 1);
+    QVERIFY2(lines[0].contains("\"GET /a%20b/%22x%22 HTTP/1.1\""), lines[0].constData());
+}
+
+void TestAccessLog::longPathKeepsCharacters()
+{
+    // Two-byte characters, the limit falls into the middle of one
+    QString path = "/" + QString(AccessRecord::maxPathLength, QChar(0x00e9));
+    AccessRecord record = makeRecord(path, 200);
+    QCOMPARE(record.pathLength, quint16(AccessRecord::maxPathLength - 1));
+    QString stored = QString::fromUtf8(record.path, record.pathLength);
+    QVERIFY(!stored.contains(QChar::ReplacementCharacter));
+    QVERIFY(path.startsWith(stored));
+}
+
+void TestAccessLog::wakesOnRecord()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("access.log");
+    AccessLog log;
+    QVERIFY(log.open(fileName, AccessLog::Format::Clf));
+    std::shared_ptr<AccessLogBuffer> buffer = log.createBuffer();
+    // Long enough for the log thread to go to sleep
+    QTest::qWait(50);
+    buffer->push(makeRecord("/late", 200));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Unbuffered));
+    QTRY_VERIFY_WITH_TIMEOUT(file.readAll().contains("GET /late"), 2000);
+}
+
+QTEST_MAIN(TestAccessLog)
+
+#include "accesslog_test.moc"
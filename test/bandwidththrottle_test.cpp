@@ -0,0 +1,158 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include "../src/core/web/bandwidththrottle.h"
+
+class TestBandwidthThrottle: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void holdsRate();
+    void lowRates_data();
+    void lowRates();
+    void payloadBody();
+    void dropsClosedConnections();
+
+private:
+    // Connected pair, the server side is written by the throttle
+    bool connectPair();
+
+    QTcpServer listener;
+    QTcpSocket client;
+    QTcpSocket* serverSide = nullptr;
+};
+
+void TestBandwidthThrottle::init()
+{
+    QVERIFY(listener.listen(QHostAddress::LocalHost));
+    QVERIFY(connectPair());
+}
+
+void TestBandwidthThrottle::cleanup()
+{
+    client.abort();
+    delete serverSide;
+    serverSide = nullptr;
+    listener.close();
+}
+
+void TestBandwidthThrottle::holdsRate()
+{
+    BandwidthThrottle throttle;
+    QByteArray body(3000, 'x');
+    QElapsedTimer clock;
+    clock.start();
+    throttle.send(serverSide, 10000, "head\n", PageData::fromBytes(body));
+
+    // The first tick's share goes out at once, the rest trickles
+    QTRY_VERIFY_WITH_TIMEOUT(client.bytesAvailable() > 0, 1000);
+    QVERIFY(client.bytesAvailable() < 3005);
+    QCOMPARE(throttle.activeCount(), 1);
+
+    QByteArray received;
+    QTRY_VERIFY_WITH_TIMEOUT((received += client.readAll()).size() == 3005, 3000);
+    QCOMPARE(received, "head\n" + body);
+    // 3005 bytes at 10000 B/s
+    QVERIFY(clock.elapsed() >= 250);
+    QTRY_COMPARE_WITH_TIMEOUT(throttle.activeCount(), 0, 1000);
+}
+
+void TestBandwidthThrottle::lowRates_data()
+{
+    QTest::addColumn<qint64>("rate");
+    QTest::addColumn<int>("size");
+
+    // Less than a byte per tick
+    QTest::newRow("10 B/s") << qint64(10) << 5;
+    // A fraction of a byte left over on every tick
+    QTest::newRow("130 B/s") << qint64(130) << 195;
+}
+
+void TestBandwidthThrottle::lowRates()
+{
+    QFETCH(qint64, rate);
+    QFETCH(int, size);
+
+    BandwidthThrottle throttle;
+    QElapsedTimer clock;
+    clock.start();
+    throttle.send(serverSide, rate, "h", PageData::fromBytes(QByteArray(size - 1, 'x')));
+
+    QByteArray received;
+    QTRY_VERIFY_WITH_TIMEOUT((received += client.readAll()).size() == size, 5000);
+    // Neither faster nor, by dropped fractions, noticeably slower
+    qint64 expectedMs = size * 1000 / rate;
+    QVERIFY2(clock.elapsed() >= expectedMs * 8 / 10, qPrintable(QString::number(clock.elapsed())));
+    QVERIFY2(clock.elapsed() <= expectedMs * 12 / 10 + 100, qPrintable(QString::number(clock.elapsed())));
+    QTRY_COMPARE_WITH_TIMEOUT(throttle.activeCount(), 0, 1000);
+}
+
+void TestBandwidthThrottle::payloadBody()
+{
+    QString error;
+    auto payload = SyntheticPayload::parse("text:size=0", &error);
+    QVERIFY(payload);
+
+    BandwidthThrottle throttle;
+    throttle.send(serverSide, 100000, QByteArray(), payload, 5000);
+
+    QByteArray received;
+    QTRY_VERIFY_WITH_TIMEOUT((received += client.readAll()).size() == 5000, 3000);
+    QByteArray expected;
+    while (expected.size() < 5000) {
+        expected.append(payload->slice(5000, expected.size(), 5000));
+    }
+    QCOMPARE(received, expected);
+}
+
+void TestBandwidthThrottle::dropsClosedConnections()
+{
+    BandwidthThrottle throttle;
+    throttle.send(serverSide, 1000, QByteArray(), PageData::fromBytes(QByteArray(100000, 'x')));
+    QCOMPARE(throttle.activeCount(), 1);
+
+    client.abort();
+    QTRY_COMPARE_WITH_TIMEOUT(throttle.activeCount(), 0, 2000);
+}
+
+bool TestBandwidthThrottle::connectPair()
+{
+    client.connectToHost(QHostAddress::LocalHost, listener.serverPort());
+    if (!client.waitForConnected(1000) || !listener.waitForNewConnection(1000)) {
+        return false;
+    }
+    serverSide = listener.nextPendingConnection();
+    if (!serverSide) {
+        return false;
+    }
+    serverSide->setParent(nullptr);
+    return true;
+}
+
+QTEST_MAIN(TestBandwidthThrottle)
+#include "bandwidththrottle_test.moc"
@@ -0,0 +1,125 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include "../src/core/web/faultplan.h"
+
+class TestFaultPlan: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parse_data();
+    void parse();
+    void emptyPlanDrawsNothing();
+    void sharesMatchWeights();
+    void reproducible();
+};
+
+void TestFaultPlan::parse_data()
+{
+    QTest::addColumn<QString>("spec");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<bool>("empty");
+
+    QTest::newRow("all kinds") << "500=2,hang=1,reset=0.5,truncate=0.5" << true << false;
+    QTest::newRow("percent sign") << "503=10%" << true << false;
+    QTest::newRow("spaces") << " 500 = 2 , hang = 1 " << true << false;
+    QTest::newRow("every request") << "reset=100" << true << false;
+    QTest::newRow("nothing") << "" << true << true;
+    QTest::newRow("zero shares") << "500=0" << true << true;
+    QTest::newRow("over 100") << "500=60,reset=50" << false << true;
+    QTest::newRow("negative") << "500=-1" << false << true;
+    QTest::newRow("no share") << "hang" << false << true;
+    QTest::newRow("unknown fault") << "explode=1" << false << true;
+    QTest::newRow("invalid code") << "999=1" << false << true;
+}
+
+void TestFaultPlan::parse()
+{
+    QFETCH(QString, spec);
+    QFETCH(bool, valid);
+    QFETCH(bool, empty);
+
+    FaultPlan plan;
+    QString error;
+    QCOMPARE(FaultPlan::parse(spec, &plan, &error), valid);
+    QCOMPARE(error.isEmpty(), valid);
+    QCOMPARE(plan.isEmpty(), empty);
+}
+
+void TestFaultPlan::emptyPlanDrawsNothing()
+{
+    FastRandom rng(1);
+    FastRandom reference(1);
+    FaultPlan plan;
+    for (int i = 0; i < 100; ++i) {
+        QCOMPARE(plan.sample(rng).action, FaultPlan::Action::None);
+    }
+    QCOMPARE(rng.next(), reference.next());
+}
+
+void TestFaultPlan::sharesMatchWeights()
+{
+    FaultPlan plan;
+    QString error;
+    QVERIFY(FaultPlan::parse("500=20,hang=10,reset=5,truncate=5", &plan, &error));
+
+    const int draws = 200000;
+    QHash<int, int> counts;
+    FastRandom rng(42);
+    for (int i = 0; i < draws; ++i) {
+        FaultPlan::Fault fault = plan.sample(rng);
+        if (fault.action == FaultPlan::Action::Status) {
+            QCOMPARE(fault.statusCode, 500);
+        }
+        ++counts[static_cast<int>(fault.action)];
+    }
+
+    auto share = [&](FaultPlan::Action action) {
+        return 100.0 * counts.value(static_cast<int>(action)) / draws;
+    };
+    QVERIFY(qAbs(share(FaultPlan::Action::Status) - 20) < 0.5);
+    QVERIFY(qAbs(share(FaultPlan::Action::Hang) - 10) < 0.5);
+    QVERIFY(qAbs(share(FaultPlan::Action::Reset) - 5) < 0.5);
+    QVERIFY(qAbs(share(FaultPlan::Action::Truncate) - 5) < 0.5);
+    QVERIFY(qAbs(share(FaultPlan::Action::None) - 60) < 0.5);
+}
+
+void TestFaultPlan::reproducible()
+{
+    FaultPlan plan;
+    QString error;
+    QVERIFY(FaultPlan::parse("500=2,hang=1,reset=0.5,truncate=0.5", &plan, &error));
+
+    FastRandom first(7);
+    FastRandom second(7);
+    for (int i = 0; i < 10000; ++i) {
+        FaultPlan::Fault a = plan.sample(first);
+        FaultPlan::Fault b = plan.sample(second);
+        QCOMPARE(a.action, b.action);
+        QCOMPARE(a.statusCode, b.statusCode);
+    }
+}
+
+QTEST_MAIN(TestFaultPlan)
+#include "faultplan_test.moc"
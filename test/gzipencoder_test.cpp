@@ -0,0 +1,125 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include "../src/core/web/gzipencoder.h"
+
+class TestGzipEncoder: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void crcOfCheckString();
+    void compressRoundTrip();
+    void acceptEncoding_data();
+    void acceptEncoding();
+
+private:
+    static QByteArray inflate(const QByteArray& gzip, const QByteArray& original);
+};
+
+static quint32 adler32(const QByteArray& data)
+{
+    quint32 a = 1;
+    quint32 b = 0;
+    for (char c : data) {
+        a = (a + static_cast<quint8>(c)) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+static quint32 readLittleEndian(const QByteArray& data, qsizetype pos)
+{
+    quint32 res = 0;
+    for (int i = 3; i >= 0; --i) {
+        res = (res << 8) | static_cast<quint8>(data.at(pos + i));
+    }
+    return res;
+}
+
+// Puts the deflate stream back into the framing qUncompress expects. The
+// zlib trailer is the adler32 of the expected data, a wrong stream fails.
+QByteArray TestGzipEncoder::inflate(const QByteArray &gzip, const QByteArray &original)
+{
+    QByteArray zlib;
+    QDataStream stream(&zlib, QIODevice::WriteOnly);
+    stream << static_cast<quint32>(original.size());
+    stream.writeRawData("\x78\x9c", 2);
+    stream.writeRawData(gzip.constData() + 10, static_cast<int>(gzip.size() - 10 - 8));
+    stream << adler32(original);
+    return qUncompress(zlib);
+}
+
+void TestGzipEncoder::crcOfCheckString()
+{
+    QCOMPARE(GzipEncoder::crc32("123456789", 9), 0xcbf43926u);
+    QCOMPARE(GzipEncoder::crc32("", 0), 0u);
+
+    // Computing in parts gives the same result
+    quint32 crc = GzipEncoder::crc32("1234", 4);
+    QCOMPARE(GzipEncoder::crc32("56789", 5, crc), 0xcbf43926u);
+}
+
+void TestGzipEncoder::compressRoundTrip()
+{
+    QByteArray page;
+    for (int i = 0; i < 1000; ++i) {
+        page += "<p>Line " + QByteArray::number(i) + "</p>\n";
+    }
+
+    QByteArray gzip = GzipEncoder::compress(page);
+    QVERIFY(gzip.size() < page.size());
+    QVERIFY(gzip.startsWith("\x1f\x8b\x08"));
+    QCOMPARE(readLittleEndian(gzip, gzip.size() - 8), GzipEncoder::crc32(page.constData(), page.size()));
+    QCOMPARE(readLittleEndian(gzip, gzip.size() - 4), static_cast<quint32>(page.size()));
+    QCOMPARE(inflate(gzip, page), page);
+}
+
+void TestGzipEncoder::acceptEncoding_data()
+{
+    QTest::addColumn<QByteArray>("header");
+    QTest::addColumn<bool>("accepted");
+
+    QTest::newRow("absent") << QByteArray() << false;
+    QTest::newRow("gzip") << QByteArray("gzip") << true;
+    QTest::newRow("list") << QByteArray("deflate, GZIP, br") << true;
+    QTest::newRow("x-gzip") << QByteArray("x-gzip") << true;
+    QTest::newRow("quality") << QByteArray("gzip;q=0.5") << true;
+    QTest::newRow("refused") << QByteArray("gzip;q=0, br") << false;
+    QTest::newRow("refused with spaces") << QByteArray("br, gzip ; q=0.0") << false;
+    QTest::newRow("other only") << QByteArray("br, identity") << false;
+    QTest::newRow("wildcard") << QByteArray("*") << true;
+    QTest::newRow("wildcard refused") << QByteArray("*;q=0") << false;
+    QTest::newRow("gzip over wildcard") << QByteArray("gzip;q=0, *") << false;
+}
+
+void TestGzipEncoder::acceptEncoding()
+{
+    QFETCH(QByteArray, header);
+    QFETCH(bool, accepted);
+
+    QCOMPARE(GzipEncoder::acceptsGzip(header), accepted);
+}
+
+QTEST_MAIN(TestGzipEncoder)
+#include "gzipencoder_test.moc"
@@ -0,0 +1,107 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include "../src/core/web/httprange.h"
+
+class TestHttpRange: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parse_data();
+    void parse();
+    void ifRange();
+    void heads();
+};
+
+void TestHttpRange::parse_data()
+{
+    QTest::addColumn<QByteArray>("header");
+    QTest::addColumn<int>("result");
+    QTest::addColumn<qint64>("first");
+    QTest::addColumn<qint64>("last");
+
+    const int ignored = static_cast<int>(HttpRange::Result::Ignored);
+    const int satisfiable = static_cast<int>(HttpRange::Result::Satisfiable);
+    const int unsatisfiable = static_cast<int>(HttpRange::Result::Unsatisfiable);
+
+    QTest::newRow("closed") << QByteArray("bytes=0-99") << satisfiable << qint64(0) << qint64(99);
+    QTest::newRow("open") << QByteArray("bytes=900-") << satisfiable << qint64(900) << qint64(999);
+    QTest::newRow("suffix") << QByteArray("bytes=-100") << satisfiable << qint64(900) << qint64(999);
+    QTest::newRow("suffix longer than body") << QByteArray("bytes=-5000") << satisfiable << qint64(0) << qint64(999);
+    QTest::newRow("last clamped") << QByteArray("bytes=500-5000") << satisfiable << qint64(500) << qint64(999);
+    QTest::newRow("spaces") << QByteArray(" bytes= 10 - 19 ") << satisfiable << qint64(10) << qint64(19);
+    QTest::newRow("past end") << QByteArray("bytes=1000-") << unsatisfiable << qint64(0) << qint64(-1);
+    QTest::newRow("empty suffix") << QByteArray("bytes=-0") << unsatisfiable << qint64(0) << qint64(-1);
+    QTest::newRow("several") << QByteArray("bytes=0-1,5-6") << ignored << qint64(0) << qint64(-1);
+    QTest::newRow("reversed") << QByteArray("bytes=20-10") << ignored << qint64(0) << qint64(-1);
+    QTest::newRow("other unit") << QByteArray("items=0-1") << ignored << qint64(0) << qint64(-1);
+    QTest::newRow("negative") << QByteArray("bytes=--1") << ignored << qint64(0) << qint64(-1);
+    QTest::newRow("garbage") << QByteArray("bytes=a-b") << ignored << qint64(0) << qint64(-1);
+}
+
+void TestHttpRange::parse()
+{
+    QFETCH(QByteArray, header);
+    QFETCH(int, result);
+    QFETCH(qint64, first);
+    QFETCH(qint64, last);
+
+    ByteRange range;
+    QCOMPARE(static_cast<int>(HttpRange::parse(header, 1000, &range)), result);
+    QCOMPARE(range.first, first);
+    QCOMPARE(range.last, last);
+}
+
+void TestHttpRange::ifRange()
+{
+    QDateTime modified(QDate(2024, 5, 1), QTime(12, 0, 0), Qt::UTC);
+
+    QVERIFY(HttpRange::ifRangeMatches(QByteArray(), "\"abc\"", modified));
+    QVERIFY(HttpRange::ifRangeMatches("\"abc\"", "\"abc\"", modified));
+    QVERIFY(!HttpRange::ifRangeMatches("\"abd\"", "\"abc\"", modified));
+    QVERIFY(!HttpRange::ifRangeMatches("W/\"abc\"", "\"abc\"", modified));
+    QVERIFY(HttpRange::ifRangeMatches("Wed, 01 May 2024 12:00:00 GMT", "\"abc\"", modified));
+    QVERIFY(!HttpRange::ifRangeMatches("Thu, 02 May 2024 12:00:00 GMT", "\"abc\"", modified));
+}
+
+void TestHttpRange::heads()
+{
+    ByteRange range;
+    range.first = 10;
+    range.last = 19;
+    QByteArray head = HttpRange::partialHead(range, 1000, "text/plain", "\"abc\"", QDateTime());
+    QVERIFY(head.startsWith("HTTP/1.1 206 Partial Content\r\n"));
+    QVERIFY(head.contains("Content-Length: 10\r\n"));
+    QVERIFY(head.contains("Content-Range: bytes 10-19/1000\r\n"));
+    QVERIFY(head.contains("ETag: \"abc\"\r\n"));
+    QVERIFY(!head.contains("Last-Modified"));
+    QVERIFY(head.endsWith("\r\n\r\n"));
+
+    head = HttpRange::unsatisfiableHead(1000);
+    QVERIFY(head.startsWith("HTTP/1.1 416 "));
+    QVERIFY(head.contains("Content-Range: bytes */1000\r\n"));
+}
+
+QTEST_MAIN(TestHttpRange)
+#include "httprange_test.moc"
@@ -0,0 +1,114 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include "../src/core/web/httpvalidators.h"
+
+class TestHttpValidators: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void dateRoundTrip();
+    void entityTags();
+    void ifNoneMatch_data();
+    void ifNoneMatch();
+    void ifModifiedSince();
+    void notModifiedHead();
+};
+
+void TestHttpValidators::dateRoundTrip()
+{
+    QDateTime time(QDate(1994, 11, 6), QTime(8, 49, 37), Qt::UTC);
+    QCOMPARE(HttpValidators::formatDate(time), QByteArray("Sun, 06 Nov 1994 08:49:37 GMT"));
+    QCOMPARE(HttpValidators::parseDate("Sun, 06 Nov 1994 08:49:37 GMT"), time);
+    QVERIFY(!HttpValidators::parseDate("yesterday").isValid());
+}
+
+void TestHttpValidators::entityTags()
+{
+    QByteArray tag = HttpValidators::entityTag("\x01\x02\xff");
+    QVERIFY(tag.startsWith('"') && tag.endsWith('"'));
+    QVERIFY(!tag.startsWith("W/"));
+    QVERIFY(tag != HttpValidators::entityTag("\x01\x02\xfe"));
+    QVERIFY(tag != HttpValidators::entityTag("\x01\x02\xff", "gzip"));
+}
+
+void TestHttpValidators::ifNoneMatch_data()
+{
+    QTest::addColumn<QByteArray>("header");
+    QTest::addColumn<bool>("matches");
+
+    QTest::newRow("same") << QByteArray("\"abc\"") << true;
+    QTest::newRow("other") << QByteArray("\"abd\"") << false;
+    QTest::newRow("list") << QByteArray("\"x\", \"abc\"") << true;
+    QTest::newRow("weak") << QByteArray("W/\"abc\"") << true;
+    QTest::newRow("any") << QByteArray("*") << true;
+    QTest::newRow("unquoted") << QByteArray("abc") << false;
+}
+
+void TestHttpValidators::ifNoneMatch()
+{
+    QFETCH(QByteArray, header);
+    QFETCH(bool, matches);
+
+    QCOMPARE(HttpValidators::matchesAny(header, "\"abc\""), matches);
+
+    RequestInfo info;
+    info.ifNoneMatch = header;
+    // If-None-Match wins over a matching date
+    info.ifModifiedSince = "Sun, 06 Nov 1994 08:49:37 GMT";
+    QDateTime modified(QDate(1994, 11, 6), QTime(8, 49, 37), Qt::UTC);
+    QCOMPARE(HttpValidators::isNotModified(info, "\"abc\"", modified), matches);
+}
+
+void TestHttpValidators::ifModifiedSince()
+{
+    QDateTime modified(QDate(2024, 5, 1), QTime(12, 0, 0, 500), Qt::UTC);
+    RequestInfo info;
+
+    QVERIFY(!HttpValidators::isNotModified(info, "\"abc\"", modified));
+
+    // Milliseconds are not part of the header
+    info.ifModifiedSince = "Wed, 01 May 2024 12:00:00 GMT";
+    QVERIFY(HttpValidators::isNotModified(info, "\"abc\"", modified));
+    info.ifModifiedSince = "Thu, 02 May 2024 12:00:00 GMT";
+    QVERIFY(HttpValidators::isNotModified(info, "\"abc\"", modified));
+    info.ifModifiedSince = "Wed, 01 May 2024 11:59:59 GMT";
+    QVERIFY(!HttpValidators::isNotModified(info, "\"abc\"", modified));
+    info.ifModifiedSince = "not a date";
+    QVERIFY(!HttpValidators::isNotModified(info, "\"abc\"", modified));
+}
+
+void TestHttpValidators::notModifiedHead()
+{
+    QDateTime time(QDate(1994, 11, 6), QTime(8, 49, 37), Qt::UTC);
+    QByteArray head = HttpValidators::notModifiedHead("\"abc\"", time, "Vary: Accept-Encoding\r\n");
+    QCOMPARE(head, QByteArray("HTTP/1.1 304 Not Modified\r\n"
+                              "ETag: \"abc\"\r\n"
+                              "Last-Modified: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+                              "Vary: Accept-Encoding\r\n"
+                              "\r\n"));
+}
+
+QTEST_MAIN(TestHttpValidators)
+#include "httpvalidators_test.moc"
@@ -24,9 +24,20 @@
 #include <QtNetwork/QNetworkAccessManager>
 #include <QtNetwork/QNetworkReply>
 #include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryFile>
+#include <QTemporaryDir>
+#include <QJsonDocument>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 #include "../../src/core/serverpresenter.h"
 #include "../../src/core/web/webserverdiag.h"
+#include "../../src/core/web/adminserver.h"
+#include "../../src/core/web/diagtcpserver.h"
+#include "../../src/core/web/socketutils.h"
 #include "../../src/core/iview.h"
 #include "../mock/mockview.h"
 
@@ -40,13 +51,37 @@ public:
           presenter(&view, &server, &logger) {}
 
 private slots:
+    void initTestCase();
     void init();
     void startServerTest();
     void changePageTest();
+    void failedPageKeepsPrevious();
     void changeEndpoint();
     void stopListenPort();
     void httpResponse();
     void httpResponseWithDelay();
+    void delayedResponsesFinishOnOwnDeadline();
+    void severalWorkers();
+    void responseCodeAndHeaders();
+    void parkedQueueOverflow();
+    void extraEndpoints();
+    void syntheticPayload();
+    void bandwidthLimit();
+    void faultPlan();
+    void tcpFaults();
+    void heldConnectionLimit();
+    void hotPortChange();
+    void portChangeWhileStopped();
+    void delayDistribution();
+    void metricsEndpoint();
+    void controlApi();
+    void binaryPage();
+    void largeMappedPage();
+    void pipelinedLargePage();
+    void staticSite();
+    void gzipVariant();
+    void conditionalRequests();
+    void rangeRequests();
 
 private:
     WebServerDiag server;
@@ -59,6 +94,11 @@ private:
     QTcpServer tcpServer;
 };
 
+void TestWebServerDiag::initTestCase()
+{
+    SocketUtils::ignoreSigPipe();
+}
+
 void TestWebServerDiag::init()
 {
     presenter.hostnameChanged("127.0.0.1");
@@ -66,7 +106,11 @@ void TestWebServerDiag::init()
     presenter.endpointPathChanged("/");
     presenter.enableHttpResponse(true);
     presenter.enableResponseDelay(false);
-    server.setRespPage("Test Page");
+    server.setRespPage(PageData::fromBytes("Test Page"));
+    server.setStaticSite(nullptr);
+    server.setBandwidthLimit(0);
+    server.setFaultPlan(FaultPlan());
+    server.setTcpFault(TcpFault::None);
     server.startServer(false);
     WebServerData srvData = server.getWebServerData();
     url = QUrl("http://" + srvData.getHostname() + ":" + QString::number(srvData.getPort()) + "/");
@@ -77,7 +121,7 @@ void TestWebServerDiag::init()
 void TestWebServerDiag::startServerTest()
 {
     QByteArray page("Test Page");
-    server.setRespPage(page);
+    server.setRespPage(PageData::fromBytes(page));
 
     presenter.startServer();
     QVERIFY(!tcpServer.listen(QHostAddress(server.getWebServerData().getHostname()),
@@ -129,7 +173,7 @@ void TestWebServerDiag::startServerTest()
 
 void TestWebServerDiag::changePageTest()
 {
-    server.setRespPage("Page A");
+    server.setRespPage(PageData::fromBytes("Page A"));
 
     server.startServer(true);
 
@@ -143,7 +187,7 @@ void TestWebServerDiag::changePageTest()
     QVERIFY(!server.getWebServerData().errorHasOccurred());
     QVERIFY(server.getWebServerData().isStarted());
 
-    server.setRespPage("Page B");
+    server.setRespPage(PageData::fromBytes("Page B"));
 
     qnam.clearConnectionCache();
     reply = qnam.get(QNetworkRequest(url));
@@ -155,6 +199,39 @@ void TestWebServerDiag::changePageTest()
     QVERIFY(server.getWebServerData().isStarted());
 }
 
+void TestWebServerDiag::failedPageKeepsPrevious()
+{
+    QTemporaryDir dir;
+    QFile file(dir.filePath("page.html"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("Selected Page");
+    file.close();
+
+    auto get = [this]() {
+        QNetworkReply* reply = qnam.get(QNetworkRequest(url));
+        QEventLoop loop;
+        connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+        loop.exec();
+        return reply;
+    };
+
+    presenter.startServer();
+    presenter.newWebPageSelected(file.fileName());
+    QTRY_COMPARE_WITH_TIMEOUT(get()->readAll(), QByteArray("Selected Page"), 2000);
+
+    // A directory exists but cannot be served, its error text must not be
+    // served in place of the page
+    view.logLines.clear();
+    presenter.newWebPageSelected(dir.path());
+    QTRY_VERIFY_WITH_TIMEOUT(std::any_of(view.logLines.cbegin(), view.logLines.cend(), [](const LogLine& line) {
+        return line.level == LogLevel::Error;
+    }), 2000);
+
+    QNetworkReply* reply = get();
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 200);
+    QCOMPARE(reply->readAll(), QByteArray("Selected Page"));
+}
+
 void TestWebServerDiag::changeEndpoint()
 {
     presenter.hostnameChanged("1.2.3.4");
@@ -446,5 +523,953 @@ void TestWebServerDiag::httpResponseWithDelay()
     QVERIFY(!server.getWebServerData().errorHasOccurred());
 }
 
+void TestWebServerDiag::delayedResponsesFinishOnOwnDeadline()
+{
+    presenter.startServer();
+    presenter.enableResponseDelay(true);
+    presenter.httpResponseTimeChanged(2000);
+
+    QNetworkReply* slowReply = qnam.get(QNetworkRequest(url));
+    QTest::qWait(100);
+
+    presenter.httpResponseTimeChanged(100);
+    QNetworkReply* fastReply = qnam.get(QNetworkRequest(url));
+
+    QEventLoop loop;
+    connect(fastReply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    QTimer::singleShot(1500, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    QVERIFY(fastReply->isFinished());
+    QVERIFY(slowReply->isRunning());
+    QCOMPARE(fastReply->readAll(), server.getWebServerData().getPage());
+
+    connect(slowReply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    loop.exec();
+    QCOMPARE(slowReply->readAll(), server.getWebServerData().getPage());
+    QCOMPARE(slowReply->error(), QNetworkReply::NoError);
+
+    presenter.enableResponseDelay(false);
+}
+
+void TestWebServerDiag::severalWorkers()
+{
+    server.setWorkerCount(4);
+    presenter.startServer();
+    QVERIFY(server.getWebServerData().isStarted());
+    QVERIFY(!server.getWebServerData().errorHasOccurred());
+
+    QList<QNetworkReply*> replies;
+    for (int i = 0; i < 32; ++i) {
+        QNetworkRequest request(url);
+        request.setRawHeader("Connection", "close");
+        replies.append(qnam.get(request));
+    }
+
+    for (QNetworkReply* reply : replies) {
+        if (!reply->isFinished()) {
+            QEventLoop loop;
+            connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+            loop.exec();
+        }
+        QCOMPARE(reply->error(), QNetworkReply::NoError);
+        QCOMPARE(reply->readAll(), server.getWebServerData().getPage());
+        reply->deleteLater();
+    }
+
+    presenter.stopServer();
+    server.setWorkerCount(1);
+}
+
+void TestWebServerDiag::responseCodeAndHeaders()
+{
+    presenter.returnCodeChanged(404);
+    presenter.startServer();
+
+    QEventLoop loop;
+    QNetworkReply* reply = qnam.get(QNetworkRequest(url));
+    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 404);
+    QCOMPARE(reply->rawHeader("Content-Length"), QByteArray::number(server.getWebServerData().getPage().size()));
+    QVERIFY(!reply->rawHeader("Content-Type").isEmpty());
+    QCOMPARE(reply->readAll(), server.getWebServerData().getPage());
+
+    presenter.returnCodeChanged(200);
+    qnam.clearConnectionCache();
+    reply = qnam.get(QNetworkRequest(url));
+    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 200);
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+    QCOMPARE(reply->readAll(), server.getWebServerData().getPage());
+}
+
+void TestWebServerDiag::parkedQueueOverflow()
+{
+    server.setParkLimit(1, ParkOverflowPolicy::ServiceUnavailable);
+    presenter.startServer();
+    presenter.enableHttpResponse(false);
+
+    QNetworkReply* parkedReply = qnam.get(QNetworkRequest(url));
+    QTest::qWait(200);
+
+    QNetworkRequest request(url);
+    request.setRawHeader("Connection", "close");
+    QNetworkReply* rejectedReply = qnam.get(request);
+
+    QEventLoop loop;
+    connect(rejectedReply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    QCOMPARE(rejectedReply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 503);
+    QVERIFY(parkedReply->isRunning());
+
+    presenter.enableHttpResponse(true);
+    if (!parkedReply->isFinished()) {
+        connect(parkedReply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+    QCOMPARE(parkedReply->error(), QNetworkReply::NoError);
+    QCOMPARE(parkedReply->readAll(), server.getWebServerData().getPage());
+
+    server.setParkLimit(10000, ParkOverflowPolicy::ServiceUnavailable);
+}
+
+void TestWebServerDiag::extraEndpoints()
+{
+    QTemporaryDir dir;
+    QFile routes(dir.filePath("routes.json"));
+    QVERIFY(routes.open(QIODevice::WriteOnly));
+    routes.write(R"([{"path": "/api/users", "code": 201, "body": "users"},
+                     {"path": "/static/*", "code": 200, "body": "static"},
+                     {"path": "/file", "page": "page.bin"}])");
+    routes.close();
+    // Large enough to be streamed from the page's mapping
+    QByteArray content(512 * 1024, 'p');
+    QFile page(dir.filePath("page.bin"));
+    QVERIFY(page.open(QIODevice::WriteOnly));
+    page.write(content);
+    page.close();
+
+    QString error;
+    QVERIFY2(server.loadEndpoints(routes.fileName(), &error), qPrintable(error));
+    presenter.startServer();
+
+    auto get = [this](const QString& path) {
+        QUrl target = url;
+        target.setPath(path);
+        QNetworkReply* reply = qnam.get(QNetworkRequest(target));
+        QEventLoop loop;
+        connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+        loop.exec();
+        return reply;
+    };
+
+    QNetworkReply* reply = get("/api/users");
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 201);
+    QCOMPARE(reply->readAll(), QByteArray("users"));
+
+    reply = get("/static/css/site.css");
+    QCOMPARE(reply->readAll(), QByteArray("static"));
+
+    // Cut in place, the route keeps the contents it was loaded with
+    QVERIFY(page.resize(0));
+    reply = get("/file");
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+    QVERIFY(reply->readAll() == content);
+
+    reply = get("/");
+    QCOMPARE(reply->readAll(), server.getWebServerData().getPage());
+
+    reply = get("/missing");
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 404);
+
+    QVERIFY(routes.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    routes.write("[]");
+    routes.close();
+    QVERIFY(server.loadEndpoints(routes.fileName(), &error));
+}
+
+void TestWebServerDiag::syntheticPayload()
+{
+    QTemporaryDir dir;
+    QFile routes(dir.filePath("routes.json"));
+    QVERIFY(routes.open(QIODevice::WriteOnly));
+    routes.write(R"([{"path": "/zeros", "payload": "zeros:size=1M"},
+                     {"path": "/data.json", "payload": "json:size=100"}])");
+    routes.close();
+
+    QString error;
+    QVERIFY(server.loadEndpoints(routes.fileName(), &error));
+    presenter.startServer();
+
+    auto get = [this](const QString& path, const QString& query) {
+        QUrl target = url;
+        target.setPath(path);
+        target.setQuery(query);
+        QNetworkReply* reply = qnam.get(QNetworkRequest(target));
+        QEventLoop loop;
+        connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+        loop.exec();
+        return reply;
+    };
+
+    QNetworkReply* reply = get("/zeros", QString());
+    QCOMPARE(reply->header(QNetworkRequest::ContentTypeHeader).toString(), QString("application/octet-stream"));
+    QCOMPARE(reply->readAll(), QByteArray(1024 * 1024, '\0'));
+
+    reply = get("/zeros", "size=3M");
+    QCOMPARE(reply->readAll().size(), 3 * 1024 * 1024);
+
+    reply = get("/zeros", "size=bogus");
+    QCOMPARE(reply->readAll().size(), 1024 * 1024);
+
+    reply = get("/data.json", "size=5000");
+    QByteArray data = reply->readAll();
+    QCOMPARE(data.size(), 5000);
+    QJsonParseError parseError;
+    QJsonDocument::fromJson(data, &parseError);
+    QCOMPARE(parseError.error, QJsonParseError::NoError);
+
+    QVERIFY(routes.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    routes.write("[]");
+    routes.close();
+    QVERIFY(server.loadEndpoints(routes.fileName(), &error));
+}
+
+void TestWebServerDiag::bandwidthLimit()
+{
+    server.setRespPage(PageData::fromBytes(QByteArray(4000, 'x')));
+    server.setBandwidthLimit(20000);
+    presenter.startServer();
+
+    QNetworkRequest request(url);
+    request.setRawHeader("Accept-Encoding", "identity");
+    QElapsedTimer clock;
+    clock.start();
+    QNetworkReply* reply = qnam.get(request);
+    QEventLoop loop;
+    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+    QCOMPARE(reply->readAll(), QByteArray(4000, 'x'));
+    // 4000 bytes and the head at 20000 B/s
+    QVERIFY(clock.elapsed() >= 150);
+}
+
+void TestWebServerDiag::faultPlan()
+{
+    server.setRespPage(PageData::fromBytes(QByteArray(1000, 'x')));
+    presenter.startServer();
+
+    QNetworkRequest request(url);
+    request.setRawHeader("Accept-Encoding", "identity");
+    auto get = [&]() {
+        QNetworkReply* reply = qnam.get(request);
+        QEventLoop loop;
+        connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+        QTimer::singleShot(500, reply, &QNetworkReply::abort);
+        loop.exec();
+        return reply;
+    };
+
+    FaultPlan plan;
+    QString error;
+    QVERIFY(FaultPlan::parse("503=100", &plan, &error));
+    server.setFaultPlan(plan);
+    QNetworkReply* reply = get();
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 503);
+
+    QVERIFY(FaultPlan::parse("reset=100", &plan, &error));
+    server.setFaultPlan(plan);
+    reply = get();
+    QVERIFY(reply->error() != QNetworkReply::NoError);
+    QVERIFY(reply->error() != QNetworkReply::OperationCanceledError);
+
+    QVERIFY(FaultPlan::parse("truncate=100", &plan, &error));
+    server.setFaultPlan(plan);
+    reply = get();
+    QVERIFY(reply->error() != QNetworkReply::NoError);
+    QVERIFY(reply->readAll().size() < 1000);
+
+    QVERIFY(FaultPlan::parse("hang=100", &plan, &error));
+    server.setFaultPlan(plan);
+    reply = get();
+    QCOMPARE(reply->error(), QNetworkReply::OperationCanceledError);
+
+    server.setFaultPlan(FaultPlan());
+    qnam.clearConnectionCache();
+    reply = get();
+    QCOMPARE(reply->readAll(), QByteArray(1000, 'x'));
+}
+
+void TestWebServerDiag::tcpFaults()
+{
+    presenter.startServer();
+    const QByteArray request = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+
+    // Sends a request and collects what comes back within the time
+    auto exchange = [&](QTcpSocket& socket, int waitMs) {
+        socket.connectToHost(QHostAddress::LocalHost, 8008);
+        if (!socket.waitForConnected(1000)) {
+            return QByteArray();
+        }
+        socket.write(request);
+        QByteArray res;
+        QElapsedTimer clock;
+        clock.start();
+        while (clock.elapsed() < waitMs && socket.state() == QAbstractSocket::ConnectedState) {
+            socket.waitForReadyRead(qMax<int>(1, waitMs - static_cast<int>(clock.elapsed())));
+            res += socket.readAll();
+        }
+        return res;
+    };
+
+    server.setTcpFault(TcpFault::Reset);
+    QTcpSocket reset;
+    QCOMPARE(exchange(reset, 1000), QByteArray());
+    QVERIFY(reset.state() != QAbstractSocket::ConnectedState);
+
+    server.setTcpFault(TcpFault::CloseAfterHeaders);
+    QTcpSocket closed;
+    QCOMPARE(exchange(closed, 1000), QByteArray());
+    QVERIFY(closed.state() != QAbstractSocket::ConnectedState);
+
+    server.setTcpFault(TcpFault::NoRead);
+    QTcpSocket unread;
+    QCOMPARE(exchange(unread, 300), QByteArray());
+    QCOMPARE(unread.state(), QAbstractSocket::ConnectedState);
+
+    // The kernel completes the handshake, the request waits in the backlog
+    // and is answered once accepting resumes
+    server.setTcpFault(TcpFault::PauseAccept);
+    QTcpSocket backlog;
+    QCOMPARE(exchange(backlog, 300), QByteArray());
+    server.setTcpFault(TcpFault::None);
+    QTRY_VERIFY_WITH_TIMEOUT(backlog.bytesAvailable() > 0, 2000);
+    QVERIFY(backlog.readAll().startsWith("HTTP/1.1 200"));
+
+    server.setTcpFault(TcpFault::Bounce);
+    bool refused = false;
+    QElapsedTimer clock;
+    clock.start();
+    while (!refused && clock.elapsed() < 2000) {
+        QTcpSocket socket;
+        socket.connectToHost(QHostAddress::LocalHost, 8008);
+        refused = !socket.waitForConnected(1000) && socket.error() == QAbstractSocket::ConnectionRefusedError;
+    }
+    QVERIFY(refused);
+
+    server.setTcpFault(TcpFault::None);
+    QTcpSocket normal;
+    QVERIFY(exchange(normal, 1000).startsWith("HTTP/1.1 200"));
+}
+
+void TestWebServerDiag::heldConnectionLimit()
+{
+    DiagTcpServer listener;
+    QVERIFY(listener.listen(QHostAddress::LocalHost, 0, false));
+    QVERIFY(listener.heldConnectionLimit() >= 16);
+    listener.setHeldConnectionLimit(3);
+
+    auto connectClients = [&](std::vector<std::unique_ptr<QTcpSocket>>& clients, int count) {
+        for (int i = 0; i < count; ++i) {
+            clients.push_back(std::make_unique<QTcpSocket>());
+            clients.back()->connectToHost(QHostAddress::LocalHost, listener.serverPort());
+            QVERIFY(clients.back()->waitForConnected(1000));
+            // One at a time, so that the order of eviction is known
+            QTRY_COMPARE_WITH_TIMEOUT(listener.heldConnectionCount(), qMin(i + 1, 3), 1000);
+        }
+    };
+
+    // The oldest held connections are closed beyond the limit
+    listener.setTcpFault(TcpFault::NoRead);
+    std::vector<std::unique_ptr<QTcpSocket>> unread;
+    connectClients(unread, 5);
+    QCOMPARE(listener.heldConnectionCount(), 3);
+    QTRY_VERIFY_WITH_TIMEOUT(unread[0]->state() != QAbstractSocket::ConnectedState, 1000);
+    QTRY_VERIFY_WITH_TIMEOUT(unread[1]->state() != QAbstractSocket::ConnectedState, 1000);
+    QCOMPARE(unread[4]->state(), QAbstractSocket::ConnectedState);
+
+    // Clients that never finish their head count the same way and are
+    // closed when the fault changes
+    listener.setTcpFault(TcpFault::CloseAfterHeaders);
+    QCOMPARE(listener.heldConnectionCount(), 0);
+    std::vector<std::unique_ptr<QTcpSocket>> silent;
+    connectClients(silent, 5);
+    QCOMPARE(listener.heldConnectionCount(), 3);
+    QTRY_VERIFY_WITH_TIMEOUT(silent[0]->state() != QAbstractSocket::ConnectedState, 1000);
+    listener.setTcpFault(TcpFault::None);
+    QCOMPARE(listener.heldConnectionCount(), 0);
+    QTRY_VERIFY_WITH_TIMEOUT(silent[4]->state() != QAbstractSocket::ConnectedState, 1000);
+
+    // A bouncing listener stays closed after shutdown
+    listener.setTcpFault(TcpFault::Bounce);
+    listener.shutdown();
+    QTest::qWait(3 * DiagTcpServer::bounceIntervalMs);
+    QVERIFY(!listener.isListening());
+}
+
+void TestWebServerDiag::hotPortChange()
+{
+    presenter.startServer();
+
+    auto get = [this](const QUrl& target) {
+        QNetworkReply* reply = qnam.get(QNetworkRequest(target));
+        QEventLoop loop;
+        connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+        loop.exec();
+        return reply;
+    };
+
+    // Keep-alive connection to the old port
+    QNetworkReply* reply = get(url);
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+
+    presenter.listenPortChanged(12346);
+    QCOMPARE(server.getWebServerData().getPort(), 12346);
+    QVERIFY(server.getWebServerData().isStarted());
+
+    reply = get(url);
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+    QCOMPARE(reply->readAll(), server.getWebServerData().getPage());
+
+    QUrl newUrl = url;
+    newUrl.setPort(12346);
+    reply = get(newUrl);
+    QCOMPARE(reply->readAll(), server.getWebServerData().getPage());
+
+    presenter.endpointPathChanged("/hot/path");
+    newUrl.setPath("/hot/path");
+    reply = get(newUrl);
+    QCOMPARE(reply->readAll(), server.getWebServerData().getPage());
+
+    // A busy port is refused and the old one keeps serving
+    QVERIFY(tcpServer.listen(QHostAddress(server.getWebServerData().getHostname()), 12347));
+    presenter.listenPortChanged(12347);
+    QCOMPARE(server.getWebServerData().getPort(), 12346);
+    reply = get(newUrl);
+    QCOMPARE(reply->readAll(), server.getWebServerData().getPage());
+}
+
+void TestWebServerDiag::portChangeWhileStopped()
+{
+    presenter.listenPortChanged(12348);
+    QCOMPARE(server.getWebServerData().getPort(), 12348);
+    QVERIFY(!server.getWebServerData().isStarted());
+    // Nothing is bound before the start
+    QVERIFY(tcpServer.listen(QHostAddress(server.getWebServerData().getHostname()), 12348));
+    tcpServer.close();
+
+    presenter.startServer();
+    QVERIFY(server.getWebServerData().isStarted());
+    QVERIFY(!server.getWebServerData().errorHasOccurred());
+
+    QNetworkReply* reply = qnam.get(QNetworkRequest(QUrl("http://127.0.0.1:12348/")));
+    QEventLoop loop;
+    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    loop.exec();
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+    QCOMPARE(reply->readAll(), server.getWebServerData().getPage());
+}
+
+void TestWebServerDiag::delayDistribution()
+{
+    presenter.startServer();
+    presenter.delayDistributionChanged("uniform:min=50,max=80");
+    presenter.enableResponseDelay(true);
+    QCOMPARE(view.getViewData().delayDistribution, QString("uniform:min=50,max=80"));
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    QList<QNetworkReply*> replies;
+    for (int i = 0; i < 5; ++i) {
+        replies.append(qnam.get(QNetworkRequest(url)));
+    }
+    for (QNetworkReply* reply : std::as_const(replies)) {
+        if (!reply->isFinished()) {
+            QEventLoop loop;
+            connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+            loop.exec();
+        }
+        QCOMPARE(reply->error(), QNetworkReply::NoError);
+    }
+    QVERIFY(elapsed.elapsed() >= 50);
+
+    LatencySummary summary = server.getLatencySummary();
+    QCOMPARE(summary.count, 5ULL);
+    QVERIFY(summary.p50Us >= 50000);
+    QVERIFY(summary.maxUs < 1000000);
+
+    presenter.delayDistributionChanged("weibull");
+    QCOMPARE(server.getWebServerData().getDelayDistribution().toString(), QString("uniform:min=50,max=80"));
+
+    presenter.httpResponseTimeChanged(1);
+    QCOMPARE(server.getWebServerData().getDelayDistribution().toString(), QString("constant:1"));
+}
+
+void TestWebServerDiag::metricsEndpoint()
+{
+    AdminServer admin(&server);
+    QVERIFY(admin.listen(QHostAddress::LocalHost, 18081));
+    presenter.startServer();
+
+    auto get = [this](const QUrl& target) {
+        QNetworkReply* reply = qnam.get(QNetworkRequest(target));
+        QEventLoop loop;
+        connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+        loop.exec();
+        return reply;
+    };
+
+    QUrl missing = url;
+    missing.setPath("/missing");
+    QCOMPARE(get(url)->error(), QNetworkReply::NoError);
+    get(missing);
+
+    // The admin port keeps answering while the diagnostic port is closed
+    presenter.enableListenPort(false);
+    QNetworkReply* reply = get(QUrl("http://127.0.0.1:18081/metrics"));
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+    QVERIFY(reply->header(QNetworkRequest::ContentTypeHeader).toString().startsWith("text/plain"));
+
+    QByteArray text = reply->readAll();
+    QVERIFY(text.contains("wmd_requests_total{endpoint=\"/\",code=\"200\"} "));
+    QVERIFY(text.contains("wmd_requests_total{endpoint=\"unmatched\",code=\"404\"} "));
+    QVERIFY(text.contains("wmd_request_duration_seconds_bucket{endpoint=\"/\",le=\"+Inf\"} "));
+    QVERIFY(text.contains("wmd_request_duration_seconds_count{endpoint=\"/\"} "));
+    QVERIFY(text.contains("wmd_workers 1\n"));
+
+    presenter.enableListenPort(true);
+}
+
+void TestWebServerDiag::controlApi()
+{
+    AdminServer admin(&server);
+    QVERIFY(admin.listen(QHostAddress::LocalHost, 18082));
+    presenter.startServer();
+
+    auto send = [this](QNetworkReply* reply) {
+        QEventLoop loop;
+        connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+        loop.exec();
+        return reply;
+    };
+    QUrl control("http://127.0.0.1:18082/control");
+    QNetworkRequest request(control);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "text/plain");
+
+    // Nothing without a presenter
+    QCOMPARE(send(qnam.post(request, QByteArray("code 503")))
+                 ->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 404);
+    admin.setPresenter(&presenter);
+
+    // A simple request, as a web page could send it, is refused
+    QCOMPARE(send(qnam.post(request, QByteArray("code 503")))
+                 ->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 403);
+    QCOMPARE(server.getWebServerData().getReturnCode(), 200);
+    request.setRawHeader(AdminServer::controlHeader, "1");
+
+    QNetworkReply* reply = send(qnam.post(request, QByteArray("code 503\nempty on  # comment\n")));
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+    QCOMPARE(server.getWebServerData().getReturnCode(), 503);
+    QVERIFY(server.getWebServerData().getReturnEmptyPage());
+    reply = send(qnam.get(QNetworkRequest(url)));
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 503);
+
+    // A bad line rejects the whole batch
+    reply = send(qnam.post(request, QByteArray("code 200\nrespond maybe\n")));
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 400);
+    QVERIFY(reply->readAll().startsWith("Line 2: "));
+    QCOMPARE(server.getWebServerData().getReturnCode(), 503);
+
+    // Serving any readable file takes an explicit permission
+    reply = send(qnam.post(request, QByteArray("code 200\npage /etc/hostname\n")));
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 403);
+    QCOMPARE(server.getWebServerData().getReturnCode(), 503);
+
+    QByteArray state = send(qnam.get(QNetworkRequest(control)))->readAll();
+    QVERIFY(state.contains("listen on\n"));
+    QVERIFY(state.contains("code 503\n"));
+    QVERIFY(state.contains("empty on\n"));
+
+    // Many small operations over one keep-alive connection
+    for (int i = 0; i < 1000; ++i) {
+        reply = send(qnam.post(request, QByteArray("code ") + QByteArray::number(200 + i % 2)));
+        QCOMPARE(reply->error(), QNetworkReply::NoError);
+        reply->deleteLater();
+    }
+    QCOMPARE(server.getWebServerData().getReturnCode(), 201);
+
+    // The saved state posted back restores it
+    reply = send(qnam.post(request, state));
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+    QCOMPARE(server.getWebServerData().getReturnCode(), 503);
+
+    QSignalSpy quit(&admin, &AdminServer::quitRequested);
+    QUrl quitUrl = control;
+    quitUrl.setPath("/control/quit");
+    QNetworkRequest quitRequest(quitUrl);
+    quitRequest.setHeader(QNetworkRequest::ContentTypeHeader, "text/plain");
+    QCOMPARE(send(qnam.post(quitRequest, QByteArray()))
+                 ->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 403);
+    QCOMPARE(quit.size(), 0);
+    quitRequest.setRawHeader(AdminServer::controlHeader, "1");
+    QCOMPARE(send(qnam.post(quitRequest, QByteArray()))->error(), QNetworkReply::NoError);
+    QCOMPARE(quit.size(), 1);
+
+    // No control on an address other hosts reach unless it is allowed
+    AdminServer exposed(&server);
+    QVERIFY(exposed.listen(QHostAddress::AnyIPv4, 18083));
+    exposed.setPresenter(&presenter);
+    QNetworkRequest exposedRequest(QUrl("http://127.0.0.1:18083/control"));
+    exposedRequest.setHeader(QNetworkRequest::ContentTypeHeader, "text/plain");
+    exposedRequest.setRawHeader(AdminServer::controlHeader, "1");
+    QCOMPARE(send(qnam.post(exposedRequest, QByteArray("code 200")))
+                 ->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 404);
+    QCOMPARE(send(qnam.get(QNetworkRequest(QUrl("http://127.0.0.1:18083/metrics"))))->error(), QNetworkReply::NoError);
+    exposed.setRemoteControl(true);
+    QCOMPARE(send(qnam.post(exposedRequest, QByteArray("code 200")))->error(), QNetworkReply::NoError);
+
+    presenter.setReturnEmptyPage(false);
+    presenter.returnCodeChanged(200);
+}
+
+void TestWebServerDiag::binaryPage()
+{
+    QByteArray page;
+    for (int i = 0; i < 1024; ++i) {
+        page.append(static_cast<char>(i % 256));
+    }
+    server.setRespPage(PageData::fromBytes(page));
+    presenter.startServer();
+
+    QEventLoop loop;
+    QNetworkReply* reply = qnam.get(QNetworkRequest(url));
+    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+    QCOMPARE(reply->readAll(), page);
+}
+
+void TestWebServerDiag::largeMappedPage()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QByteArray block(1024 * 1024, '\0');
+    for (int i = 0; i < 8; ++i) {
+        block.fill(static_cast<char>('a' + i));
+        file.write(block);
+    }
+    file.flush();
+
+    QString error;
+    std::shared_ptr<const PageData> page = PageData::map(file.fileName(), &error);
+    QVERIFY2(page, qPrintable(error));
+    QCOMPARE(page->size(), qint64(8 * 1024 * 1024));
+    server.setRespPage(page);
+    presenter.startServer();
+
+    // The second request reuses the connection after the streamed body
+    for (int i = 0; i < 2; ++i) {
+        // The page compresses well, the gzip variant would not be streamed
+        QNetworkRequest request(url);
+        request.setRawHeader("Accept-Encoding", "identity");
+        QEventLoop loop;
+        QNetworkReply* reply = qnam.get(request);
+        connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+        loop.exec();
+
+        QCOMPARE(reply->error(), QNetworkReply::NoError);
+        QCOMPARE(reply->rawHeader("Content-Length"), QByteArray::number(page->size()));
+        QVERIFY(reply->readAll() == page->bytes());
+    }
+}
+
+void TestWebServerDiag::pipelinedLargePage()
+{
+    QByteArray page(1024 * 1024, '\0');
+    for (int i = 0; i < page.size(); ++i) {
+        page[i] = static_cast<char>('a' + i % 26);
+    }
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(page);
+    file.flush();
+    QString error;
+    std::shared_ptr<const PageData> mapped = PageData::map(file.fileName(), &error);
+    QVERIFY2(mapped, qPrintable(error));
+    server.setRespPage(mapped);
+    presenter.startServer();
+
+    // Both requests in one write, the second one is read while the first
+    // body is still streaming
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress::LocalHost, 8008);
+    QVERIFY(socket.waitForConnected(1000));
+    const QByteArray request = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\nAccept-Encoding: identity\r\n\r\n";
+    socket.write(request + request);
+
+    QByteArray received;
+    QElapsedTimer clock;
+    clock.start();
+    while (received.size() < 2 * page.size() && clock.elapsed() < 5000) {
+        socket.waitForReadyRead(100);
+        received += socket.readAll();
+    }
+    // The heads are still to come
+    while (socket.waitForReadyRead(200)) {
+        received += socket.readAll();
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        qsizetype headEnd = received.indexOf("\r\n\r\n");
+        QVERIFY(headEnd > 0);
+        QByteArray head = received.left(headEnd);
+        QVERIFY2(head.startsWith("HTTP/1.1 200"), head.constData());
+        QVERIFY(head.contains("Content-Length: " + QByteArray::number(page.size())));
+        QVERIFY(received.mid(headEnd + 4, page.size()) == page);
+        received.remove(0, headEnd + 4 + page.size());
+    }
+    QVERIFY(received.isEmpty());
+}
+
+void TestWebServerDiag::staticSite()
+{
+    QTemporaryDir dir;
+    QByteArray binary(3000, '\0');
+    for (int i = 0; i < binary.size(); ++i) {
+        binary[i] = static_cast<char>(i * 7);
+    }
+    const QList<QPair<QString, QByteArray>> files = {
+        {"index.html", "<p>home</p>"},
+        {"docs/guide.txt", "guide"},
+        {"data/blob.bin", binary}
+    };
+    for (const auto& file : files) {
+        QDir().mkpath(QFileInfo(dir.filePath(file.first)).absolutePath());
+        QFile out(dir.filePath(file.first));
+        QVERIFY(out.open(QIODevice::WriteOnly));
+        out.write(file.second);
+    }
+
+    // Indexed in the background
+    presenter.newSiteDirectorySelected(dir.path());
+    QTRY_VERIFY_WITH_TIMEOUT(std::any_of(view.logLines.cbegin(), view.logLines.cend(), [](const LogLine& line) {
+        return line.text.contains("Serving 3 files");
+    }), 2000);
+    presenter.startServer();
+
+    QEventLoop loop;
+    QUrl base("http://127.0.0.1:8008");
+    QList<QPair<QString, QByteArray>> requests = {{"/", "<p>home</p>"}};
+    requests.append(files);
+    for (const auto& request : std::as_const(requests)) {
+        QString path = request.first.startsWith('/') ? request.first : "/" + request.first;
+        QNetworkReply* reply = qnam.get(QNetworkRequest(base.resolved(QUrl(path))));
+        connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+        loop.exec();
+
+        QCOMPARE(reply->error(), QNetworkReply::NoError);
+        QCOMPARE(reply->readAll(), request.second);
+        QVERIFY(!reply->rawHeader("ETag").isEmpty());
+        QVERIFY(!reply->rawHeader("Last-Modified").isEmpty());
+
+        QNetworkRequest conditional(base.resolved(QUrl(path)));
+        conditional.setRawHeader("If-None-Match", reply->rawHeader("ETag"));
+        reply = qnam.get(conditional);
+        connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+        loop.exec();
+        QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 304);
+    }
+    QNetworkReply* reply = qnam.get(QNetworkRequest(base.resolved(QUrl("/docs/missing.txt"))));
+    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    loop.exec();
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 404);
+
+    presenter.newSiteDirectorySelected("");
+}
+
+void TestWebServerDiag::gzipVariant()
+{
+    QByteArray page;
+    for (int i = 0; i < 1000; ++i) {
+        page += "<p>Line " + QByteArray::number(i) + "</p>\n";
+    }
+    server.setRespPage(PageData::fromBytes(page));
+    presenter.startServer();
+
+    auto get = [this](const QByteArray& acceptEncoding) {
+        QNetworkRequest request(url);
+        if (!acceptEncoding.isEmpty()) {
+            request.setRawHeader("Accept-Encoding", acceptEncoding);
+        }
+        QNetworkReply* reply = qnam.get(request);
+        QEventLoop loop;
+        connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+        loop.exec();
+        return reply;
+    };
+
+    // The variant is built in the background, the page is sent as is until then
+    QNetworkReply* reply = nullptr;
+    QTRY_VERIFY_WITH_TIMEOUT((reply = get("gzip"))->rawHeader("Content-Encoding") == "gzip", 2000);
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+    QCOMPARE(reply->rawHeader("Vary"), QByteArray("Accept-Encoding"));
+    QByteArray body = reply->readAll();
+    QVERIFY(body.startsWith("\x1f\x8b"));
+    QVERIFY(body.size() < page.size());
+    QCOMPARE(reply->rawHeader("Content-Length"), QByteArray::number(body.size()));
+
+    reply = get("gzip;q=0");
+    QVERIFY(reply->rawHeader("Content-Encoding").isEmpty());
+    QCOMPARE(reply->rawHeader("Vary"), QByteArray("Accept-Encoding"));
+    QCOMPARE(reply->readAll(), page);
+
+    // Decoded by the access manager when it negotiates itself
+    reply = get(QByteArray());
+    QCOMPARE(reply->readAll(), page);
+
+    // Only the status code changed, the compressed body is reused at once
+    presenter.returnCodeChanged(404);
+    reply = get("gzip");
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 404);
+    QCOMPARE(reply->rawHeader("Content-Encoding"), QByteArray("gzip"));
+    presenter.returnCodeChanged(200);
+
+    QVERIFY(!server.metricsText().contains("wmd_compression_saved_bytes_total 0\n"));
+}
+
+void TestWebServerDiag::conditionalRequests()
+{
+    presenter.startServer();
+
+    auto get = [this](const QByteArray& header, const QByteArray& value) {
+        QNetworkRequest request(url);
+        if (!header.isEmpty()) {
+            request.setRawHeader(header, value);
+        }
+        QNetworkReply* reply = qnam.get(request);
+        QEventLoop loop;
+        connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+        loop.exec();
+        return reply;
+    };
+    auto status = [](QNetworkReply* reply) {
+        return reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    };
+
+    // Validators are published once the page is hashed in the background
+    QNetworkReply* reply = nullptr;
+    QTRY_VERIFY_WITH_TIMEOUT(!(reply = get(QByteArray(), QByteArray()))->rawHeader("ETag").isEmpty(), 2000);
+    QByteArray etag = reply->rawHeader("ETag");
+    QByteArray lastModified = reply->rawHeader("Last-Modified");
+    QVERIFY(etag.startsWith('"'));
+    QVERIFY(!lastModified.isEmpty());
+
+    reply = get("If-None-Match", etag);
+    QCOMPARE(status(reply), 304);
+    QCOMPARE(reply->rawHeader("ETag"), etag);
+    QVERIFY(reply->readAll().isEmpty());
+
+    reply = get("If-Modified-Since", lastModified);
+    QCOMPARE(status(reply), 304);
+
+    reply = get("If-None-Match", "\"other\"");
+    QCOMPARE(status(reply), 200);
+    QCOMPARE(reply->readAll(), QByteArray("Test Page"));
+
+    // A new version of the page gets a new tag
+    server.setRespPage(PageData::fromBytes("Other Page"));
+    QTRY_VERIFY_WITH_TIMEOUT(!(reply = get("If-None-Match", etag))->rawHeader("ETag").isEmpty(), 2000);
+    QCOMPARE(status(reply), 200);
+    QVERIFY(reply->rawHeader("ETag") != etag);
+    etag = reply->rawHeader("ETag");
+
+    presenter.cacheValidationChanged("changed");
+    QCOMPARE(status(get("If-None-Match", etag)), 200);
+
+    presenter.cacheValidationChanged("unchanged");
+    QCOMPARE(status(get("If-None-Match", "\"other\"")), 304);
+    // Unconditional requests still get the page
+    QCOMPARE(status(get(QByteArray(), QByteArray())), 200);
+
+    presenter.cacheValidationChanged("normal");
+    QCOMPARE(status(get("If-None-Match", etag)), 304);
+
+    // Only successful responses are validated
+    presenter.returnCodeChanged(404);
+    QCOMPARE(status(get("If-None-Match", etag)), 404);
+    presenter.returnCodeChanged(200);
+}
+
+void TestWebServerDiag::rangeRequests()
+{
+    // Large enough to be streamed from the middle of the mapping
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QByteArray block(1024 * 1024, '\0');
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < block.size(); ++j) {
+            block[j] = static_cast<char>((i * 31 + j) % 251);
+        }
+        file.write(block);
+    }
+    file.flush();
+    QString error;
+    std::shared_ptr<const PageData> page = PageData::map(file.fileName(), &error);
+    QVERIFY2(page, qPrintable(error));
+    server.setRespPage(page);
+    presenter.startServer();
+
+    auto get = [this](const QByteArray& range, const QByteArray& ifRange = QByteArray()) {
+        QNetworkRequest request(url);
+        request.setRawHeader("Accept-Encoding", "identity");
+        request.setRawHeader("Range", range);
+        if (!ifRange.isEmpty()) {
+            request.setRawHeader("If-Range", ifRange);
+        }
+        QNetworkReply* reply = qnam.get(request);
+        QEventLoop loop;
+        connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+        loop.exec();
+        return reply;
+    };
+    auto status = [](QNetworkReply* reply) {
+        return reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    };
+    const QByteArray bytes = page->bytes();
+    const QByteArray size = QByteArray::number(bytes.size());
+    QTRY_VERIFY_WITH_TIMEOUT(!get("bytes=0-0")->rawHeader("ETag").isEmpty(), 2000);
+
+    QNetworkReply* reply = get("bytes=100-1500099");
+    QCOMPARE(status(reply), 206);
+    QCOMPARE(reply->rawHeader("Content-Range"), "bytes 100-1500099/" + size);
+    QCOMPARE(reply->rawHeader("Accept-Ranges"), QByteArray("bytes"));
+    QVERIFY(reply->readAll() == bytes.mid(100, 1500000));
+    QByteArray etag = reply->rawHeader("ETag");
+
+    reply = get("bytes=-10");
+    QCOMPARE(status(reply), 206);
+    QVERIFY(reply->readAll() == bytes.right(10));
+
+    reply = get("bytes=" + size + "-");
+    QCOMPARE(status(reply), 416);
+    QCOMPARE(reply->rawHeader("Content-Range"), "bytes */" + size);
+
+    // A stale If-Range gets the whole current body
+    reply = get("bytes=0-9", etag);
+    QCOMPARE(status(reply), 206);
+    reply = get("bytes=0-9", "\"stale\"");
+    QCOMPARE(status(reply), 200);
+    QCOMPARE(reply->rawHeader("Content-Length"), size);
+    QVERIFY(reply->readAll() == bytes);
+}
+
 QTEST_MAIN(TestWebServerDiag)
 #include "webserverdiag_test.moc"
@@ -0,0 +1,211 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include <algorithm>
+
+#include "../src/core/web/latencydistribution.h"
+#include "../src/core/web/latencyhistogram.h"
+
+class TestLatency: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parseSpecs_data();
+    void parseSpecs();
+    void sameSeedSameDelays();
+    void distributionPercentiles_data();
+    void distributionPercentiles();
+    void empiricalFromFile();
+    void constantSpec();
+    void histogramBuckets();
+    void histogramPercentiles();
+
+private:
+    static QVector<int> draw(const LatencyDistribution& dist, int count);
+};
+
+QVector<int> TestLatency::draw(const LatencyDistribution &dist, int count)
+{
+    FastRandom rng(42);
+    QVector<int> res(count);
+    for (int& val : res) {
+        val = dist.sample(rng);
+    }
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+void TestLatency::parseSpecs_data()
+{
+    QTest::addColumn<QString>("spec");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<QString>("normalized");
+
+    QTest::newRow("number") << "50" << true << "constant:50";
+    QTest::newRow("constant") << "constant:20" << true << "constant:20";
+    QTest::newRow("uniform") << "uniform:min=10,max=200" << true << "uniform:min=10,max=200";
+    QTest::newRow("normal") << "Normal: mean=100, stddev=20" << true << "normal:mean=100,stddev=20";
+    QTest::newRow("lognormal") << "lognormal:mu=4,sigma=0.5" << true << "lognormal:mu=4,sigma=0.5";
+    QTest::newRow("pareto") << "pareto:scale=20,shape=1.5" << true << "pareto:scale=20,shape=1.5";
+    QTest::newRow("negative") << "-5" << false << "";
+    QTest::newRow("negative constant") << "constant:ms=-5" << false << "";
+    QTest::newRow("constant without ms") << "constant:" << false << "";
+    QTest::newRow("unknown") << "weibull:k=1" << false << "";
+    QTest::newRow("missing parameter") << "uniform:min=10" << false << "";
+    QTest::newRow("reversed range") << "uniform:min=10,max=5" << false << "";
+    QTest::newRow("missing file") << "empirical:file=/nonexistent/latencies.txt" << false << "";
+}
+
+void TestLatency::parseSpecs()
+{
+    QFETCH(QString, spec);
+    QFETCH(bool, valid);
+    QFETCH(QString, normalized);
+
+    LatencyDistribution dist;
+    QString error;
+    QCOMPARE(LatencyDistribution::parse(spec, &dist, &error), valid);
+    if (valid) {
+        QCOMPARE(dist.toString(), normalized);
+    } else {
+        QVERIFY(!error.isEmpty());
+    }
+}
+
+void TestLatency::sameSeedSameDelays()
+{
+    LatencyDistribution dist;
+    QString error;
+    QVERIFY(LatencyDistribution::parse("lognormal:mu=4,sigma=1", &dist, &error));
+
+    FastRandom a(7);
+    FastRandom b(7);
+    FastRandom c(8);
+    bool differs = false;
+    for (int i = 0; i < 100; ++i) {
+        int val = dist.sample(a);
+        QCOMPARE(dist.sample(b), val);
+        differs = differs || dist.sample(c) != val;
+    }
+    QVERIFY(differs);
+}
+
+void TestLatency::distributionPercentiles_data()
+{
+    QTest::addColumn<QString>("spec");
+    QTest::addColumn<int>("p50");
+    QTest::addColumn<int>("p99");
+
+    // Quantiles of the closed forms, e.g. lognormal p50 = exp(mu)
+    QTest::newRow("constant") << "constant:30" << 30 << 30;
+    QTest::newRow("uniform") << "uniform:min=100,max=200" << 150 << 199;
+    QTest::newRow("normal") << "normal:mean=100,stddev=10" << 100 << 123;
+    QTest::newRow("lognormal") << "lognormal:mu=4,sigma=0.5" << 55 << 176;
+    QTest::newRow("pareto") << "pareto:scale=20,shape=2" << 28 << 200;
+}
+
+void TestLatency::distributionPercentiles()
+{
+    QFETCH(QString, spec);
+    QFETCH(int, p50);
+    QFETCH(int, p99);
+
+    LatencyDistribution dist;
+    QString error;
+    QVERIFY(LatencyDistribution::parse(spec, &dist, &error));
+
+    const int count = 100000;
+    QVector<int> values = draw(dist, count);
+    QVERIFY(qAbs(values.at(count / 2) - p50) <= qMax(2, p50 / 20));
+    QVERIFY(qAbs(values.at(count * 99 / 100) - p99) <= qMax(2, p99 / 10));
+}
+
+void TestLatency::empiricalFromFile()
+{
+    QTemporaryDir dir;
+    QFile file(dir.filePath("latencies.txt"));
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+    file.write("# ms count\n10 90\n500 10\n");
+    file.close();
+
+    LatencyDistribution dist;
+    QString error;
+    QVERIFY(LatencyDistribution::parse("empirical:file=" + file.fileName(), &dist, &error));
+
+    QVector<int> values = draw(dist, 10000);
+    int slow = static_cast<int>(std::count(values.begin(), values.end(), 500));
+    QCOMPARE(static_cast<int>(std::count(values.begin(), values.end(), 10)) + slow, values.size());
+    QVERIFY(slow > 800 && slow < 1200);
+
+    // Same file name, new contents
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+    file.write("20\n");
+    file.close();
+    LatencyDistribution edited;
+    QVERIFY(LatencyDistribution::parse("empirical:file=" + file.fileName(), &edited, &error));
+    QCOMPARE(edited.toString(), dist.toString());
+    QVERIFY(!(edited == dist));
+}
+
+void TestLatency::constantSpec()
+{
+    QCOMPARE(LatencyDistribution::constant(5000000).toString(), QString("constant:3600000"));
+    QVERIFY(LatencyDistribution::constant(5000000) == LatencyDistribution::constant(3600000));
+    QCOMPARE(LatencyDistribution::constant(-5).toString(), QString("constant:0"));
+}
+
+void TestLatency::histogramBuckets()
+{
+    for (quint64 val : {0ULL, 1ULL, 127ULL, 128ULL, 129ULL, 1000ULL, 123456ULL, 1ULL << 30}) {
+        int index = LatencyHistogram::bucketIndex(val);
+        QVERIFY(LatencyHistogram::bucketLowerBound(index) <= val);
+        QVERIFY(LatencyHistogram::bucketLowerBound(index + 1) > val);
+        QVERIFY(val - LatencyHistogram::bucketLowerBound(index) <= val / 64);
+    }
+    QCOMPARE(LatencyHistogram::bucketIndex(~0ULL), LatencyHistogram::bucketCount - 1);
+}
+
+void TestLatency::histogramPercentiles()
+{
+    LatencyHistogram histogram;
+    for (quint64 i = 1; i <= 10000; ++i) {
+        histogram.record(i * 10);
+    }
+
+    LatencyHistogram merged;
+    merged.merge(histogram);
+    LatencySummary summary = merged.summary();
+
+    QCOMPARE(summary.count, 10000ULL);
+    QCOMPARE(summary.maxUs, 100000ULL);
+    QVERIFY(qAbs(static_cast<qint64>(summary.p50Us) - 50000) <= 50000 / 64);
+    QVERIFY(qAbs(static_cast<qint64>(summary.p99Us) - 99000) <= 99000 / 64);
+
+    histogram.reset();
+    QCOMPARE(histogram.count(), 0ULL);
+    QCOMPARE(histogram.percentile(99), 0ULL);
+}
+
+QTEST_MAIN(TestLatency)
+#include "latency_test.moc"
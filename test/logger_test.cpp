@@ -0,0 +1,98 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "../src/core/logger.h"
+#include "../src/core/iview.h"
+#include "mock/mockview.h"
+
+class TestLogger: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void batchedDelivery();
+    void levelFilter();
+    void fileSink();
+};
+
+void TestLogger::batchedDelivery()
+{
+    MockView view;
+    Logger logger(&view);
+    for (int i = 0; i < 1000; ++i) {
+        logger.addMessage(QString::number(i));
+    }
+    QCOMPARE(view.logLines.size(), 0);
+
+    QTRY_COMPARE(view.logLines.size(), 1000);
+    QVERIFY(view.logBatches < 100);
+    QVERIFY(view.logLines.first().text.endsWith(": 0"));
+    QVERIFY(view.logLines.last().text.endsWith(": 999"));
+}
+
+void TestLogger::levelFilter()
+{
+    MockView view;
+    Logger logger(&view);
+    logger.setLevel(LogLevel::Notice);
+    logger.addMessage("info");
+    logger.addHighlightedMessage("notice");
+    logger.addError("error");
+    logger.flush();
+
+    QCOMPARE(view.logLines.size(), 2);
+    QCOMPARE(view.logLines[0].level, LogLevel::Notice);
+    QCOMPARE(view.logLines[1].level, LogLevel::Error);
+
+    LogLevel level;
+    QVERIFY(Logger::parseLevel("warning", &level));
+    QCOMPARE(level, LogLevel::Warning);
+    QVERIFY(!Logger::parseLevel("verbose", &level));
+}
+
+void TestLogger::fileSink()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("wmd.log");
+    MockView view;
+    {
+        Logger logger(&view);
+        logger.setViewEnabled(false);
+        QVERIFY(logger.setFile(fileName));
+        logger.addMessage("Server is running");
+        logger.addError("Port is busy");
+    }
+    QCOMPARE(view.logLines.size(), 0);
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+    QList<QByteArray> lines = file.readAll().split('\n');
+    QCOMPARE(lines.size(), 3);
+    QVERIFY(lines[0].endsWith(" [info] Server is running"));
+    QVERIFY(lines[1].endsWith(" [error] Port is busy"));
+}
+
+QTEST_MAIN(TestLogger)
+
+#include "logger_test.moc"
@@ -0,0 +1,101 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QColor>
+
+#include "../src/gui/logmodel.h"
+
+class TestLogModel: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void coalescedAppend();
+    void keepsNewestLines();
+    void shrinkCapacity();
+
+private:
+    static QList<LogLine> makeLines(int from, int count);
+};
+
+QList<LogLine> TestLogModel::makeLines(int from, int count)
+{
+    QList<LogLine> res;
+    for (int i = from; i < from + count; ++i) {
+        res.append({QString::number(i), i % 2 ? LogLevel::Error : LogLevel::Info});
+    }
+    return res;
+}
+
+void TestLogModel::coalescedAppend()
+{
+    LogModel model(100);
+    QSignalSpy inserted(&model, &LogModel::rowsInserted);
+    for (int i = 0; i < 10; ++i) {
+        model.append(makeLines(i * 5, 5));
+    }
+    QCOMPARE(model.rowCount(), 0);
+
+    QTRY_COMPARE(model.rowCount(), 50);
+    QCOMPARE(inserted.size(), 1);
+    QCOMPARE(model.data(model.index(49)).toString(), QString("49"));
+    QCOMPARE(model.data(model.index(1), Qt::ForegroundRole).value<QColor>(), QColor(Qt::red));
+    QVERIFY(!model.data(model.index(0), Qt::ForegroundRole).isValid());
+}
+
+void TestLogModel::keepsNewestLines()
+{
+    LogModel model(100);
+    for (int i = 0; i < 25; ++i) {
+        model.append(makeLines(i * 10, 10));
+        model.commit();
+    }
+    QCOMPARE(model.rowCount(), 100);
+    QCOMPARE(model.data(model.index(0)).toString(), QString("150"));
+    QCOMPARE(model.data(model.index(99)).toString(), QString("249"));
+
+    model.append(makeLines(1000, 250));
+    model.commit();
+    QCOMPARE(model.rowCount(), 100);
+    QCOMPARE(model.data(model.index(0)).toString(), QString("1150"));
+}
+
+void TestLogModel::shrinkCapacity()
+{
+    LogModel model(100);
+    model.append(makeLines(0, 80));
+    model.commit();
+
+    model.setCapacity(30);
+    QCOMPARE(model.capacity(), 30);
+    QCOMPARE(model.rowCount(), 30);
+    QCOMPARE(model.data(model.index(0)).toString(), QString("50"));
+
+    model.append(makeLines(80, 5));
+    model.commit();
+    QCOMPARE(model.rowCount(), 30);
+    QCOMPARE(model.data(model.index(29)).toString(), QString("84"));
+}
+
+QTEST_MAIN(TestLogModel)
+
+#include "logmodel_test.moc"
@@ -31,6 +31,8 @@ struct ViewData {
     bool shownEndpoint = false;
     int shownReturnCode = -1;
     int shownResponseTime = -1;
+    QString delayDistribution;
+    QString cacheValidation;
     QString hostnameValue;
     QString endpointPath;
     ushort shownPort = 0;
@@ -74,6 +76,16 @@ public:
         viewData.shownResponseTime = val;
     }
 
+    void setDelayDistribution(const QString& spec) override
+    {
+        viewData.delayDistribution = spec;
+    }
+
+    void showLatency(const LatencySummary& summary) override
+    {
+
+    }
+
     void setHostname(const QString &val) override
     {
         viewData.hostnameValue = val;
@@ -104,6 +116,11 @@ public:
 
     }
 
+    void setCacheValidation(const QString& mode) override
+    {
+        viewData.cacheValidation = mode;
+    }
+
     ViewData getViewData() const
     {
         return viewData;
@@ -114,11 +131,15 @@ public:
 
     }
 
-    void appendLog(const QString& str) override
+    void appendLog(const QList<LogLine>& lines) override
     {
-
+        logLines.append(lines);
+        ++logBatches;
     }
 
+    QList<LogLine> logLines;
+    int logBatches = 0;
+
 private:
     IPresenter* presenter;
     ViewData viewData;
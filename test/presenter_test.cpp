@@ -31,7 +31,7 @@ class MockWebServerDiag: public IWebServerDiag
 public:
     virtual ~MockWebServerDiag() = default;
 
-    WebServerData getWebServerData() const override
+    const WebServerData& getWebServerData() const override
     {
         return srvData;
     }
@@ -61,6 +61,16 @@ public:
         srvData.setResponseTime(val);
     }
 
+    void setDelayDistribution(const LatencyDistribution& dist) override
+    {
+        srvData.setDelayDistribution(dist);
+    }
+
+    LatencySummary getLatencySummary() const override
+    {
+        return LatencySummary();
+    }
+
     void setServerData(const WebServerData& data) override
     {
         srvData = data;
@@ -86,7 +96,7 @@ public:
         srvData.setResponseCode(val);
     }
 
-    void setRespPage(const QString &newRespPage) override
+    void setRespPage(const std::shared_ptr<const PageData>& newRespPage) override
     {
         srvData.setRespPage(newRespPage);
     }
@@ -101,6 +111,16 @@ public:
 
     }
 
+    void setCacheValidation(CacheValidation mode) override
+    {
+        srvData.setCacheValidation(mode);
+    }
+
+    void setStaticSite(const std::shared_ptr<const StaticSiteIndex>& site) override
+    {
+
+    }
+
 private:
     WebServerData srvData;
 };
@@ -120,7 +140,9 @@ private slots:
     void listenPortChangedTest();
     void changeHttpRespondingTest();
     void changeResponseTime();
+    void responseTimeReplacesDistribution();
     void returnCodeChanged();
+    void cacheValidationChanged();
 
 private:
     MockView view;
@@ -357,6 +379,17 @@ void TestPresenter::changeResponseTime()
     QVERIFY(!viewData.checkedNeedRespDelay);
 }
 
+void TestPresenter::responseTimeReplacesDistribution()
+{
+    presenter.delayDistributionChanged("uniform:min=10,max=20");
+    QVERIFY(server.getWebServerData().getDelayDistribution().type() == LatencyDistribution::Type::Uniform);
+
+    // The same number as before is still a change away from the distribution
+    presenter.httpResponseTimeChanged(server.getWebServerData().getResponseTime());
+    QVERIFY(server.getWebServerData().getDelayDistribution().type() == LatencyDistribution::Type::Constant);
+    QCOMPARE(view.getViewData().delayDistribution, server.getWebServerData().getDelayDistribution().toString());
+}
+
 void TestPresenter::returnCodeChanged()
 {
     QCOMPARE(server.getWebServerData().getReturnCode(), 200);
@@ -368,5 +401,21 @@ void TestPresenter::returnCodeChanged()
     QCOMPARE(view.getViewData().shownReturnCode, 300);
 }
 
+void TestPresenter::cacheValidationChanged()
+{
+    QVERIFY(server.getWebServerData().getCacheValidation() == CacheValidation::Normal);
+
+    presenter.cacheValidationChanged("unchanged");
+    QVERIFY(server.getWebServerData().getCacheValidation() == CacheValidation::NeverChanges);
+    QCOMPARE(view.getViewData().cacheValidation, QString("unchanged"));
+
+    presenter.cacheValidationChanged("sometimes");
+    QVERIFY(server.getWebServerData().getCacheValidation() == CacheValidation::NeverChanges);
+    QCOMPARE(view.getViewData().cacheValidation, QString("unchanged"));
+
+    presenter.cacheValidationChanged("normal");
+    QVERIFY(server.getWebServerData().getCacheValidation() == CacheValidation::Normal);
+}
+
 QTEST_MAIN(TestPresenter)
 #include "presenter_test.moc"
@@ -0,0 +1,119 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include "../src/core/web/routetable.h"
+
+class TestRouteTable: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void exactMatch();
+    void wildcardMatch();
+    void laterInsertWins();
+    void lookup_data();
+    void lookup();
+
+private:
+    static EndpointConfig endpoint(const QString& path, int code);
+};
+
+EndpointConfig TestRouteTable::endpoint(const QString &path, int code)
+{
+    EndpointConfig res;
+    res.path = path;
+    res.responseCode = code;
+    return res;
+}
+
+void TestRouteTable::exactMatch()
+{
+    RouteTable table;
+    table.insert(endpoint("/", 200));
+    table.insert(endpoint("/api/users", 201));
+    table.insert(endpoint("/api/users/", 202));
+
+    QCOMPARE(table.size(), 3);
+    QCOMPARE(table.find(u"/")->responseCode, 200);
+    QCOMPARE(table.find(u"/api/users")->responseCode, 201);
+    QCOMPARE(table.find(u"/api/users/")->responseCode, 202);
+    QVERIFY(table.find(u"/api") == nullptr);
+    QVERIFY(table.find(u"/api/users/1") == nullptr);
+    QVERIFY(table.find(u"/other") == nullptr);
+}
+
+void TestRouteTable::wildcardMatch()
+{
+    RouteTable table;
+    table.insert(endpoint("/static/*", 200));
+    table.insert(endpoint("/static/img/*", 201));
+    table.insert(endpoint("/static/index.html", 202));
+
+    QCOMPARE(table.find(u"/static/app.js")->responseCode, 200);
+    QCOMPARE(table.find(u"/static/img/a/b.png")->responseCode, 201);
+    QCOMPARE(table.find(u"/static/index.html")->responseCode, 202);
+    QCOMPARE(table.find(u"/static/img")->responseCode, 200);
+    QVERIFY(table.find(u"/stat") == nullptr);
+
+    table.insert(endpoint("/*", 404));
+    QCOMPARE(table.find(u"/anything/else")->responseCode, 404);
+}
+
+void TestRouteTable::laterInsertWins()
+{
+    RouteTable table;
+    table.insert(endpoint("/a/b", 200));
+    table.insert(endpoint("/a/b", 500));
+
+    QCOMPARE(table.find(u"/a/b")->responseCode, 500);
+}
+
+void TestRouteTable::lookup_data()
+{
+    QTest::addColumn<int>("routeCount");
+
+    QTest::newRow("10") << 10;
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("100000") << 100000;
+}
+
+void TestRouteTable::lookup()
+{
+    QFETCH(int, routeCount);
+
+    RouteTable table;
+    for (int i = 0; i < routeCount; ++i) {
+        table.insert(endpoint(QString("/api/v1/service%1/items").arg(i), 200));
+    }
+    QString path = QString("/api/v1/service%1/items").arg(routeCount / 2);
+    QVERIFY(table.find(path) != nullptr);
+
+    const EndpointConfig* found = nullptr;
+    QBENCHMARK {
+        found = table.find(path);
+    }
+    QVERIFY(found != nullptr);
+}
+
+QTEST_MAIN(TestRouteTable)
+#include "routetable_test.moc"
@@ -0,0 +1,203 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include "../src/core/scenarioengine.h"
+#include "../src/core/ipresenter.h"
+
+class MockPresenter: public IPresenter
+{
+public:
+    MockPresenter() : IPresenter(nullptr) {}
+
+    void showView() override {}
+    void startServer() override { record("start"); }
+    void stopServer() override { record("stop"); }
+    void hostnameChanged(const QString&) override {}
+    void endpointPathChanged(const QString& str) override { record("endpoint " + str); }
+    void listenPortChanged(ushort val) override { record("port " + QString::number(val)); }
+    void enableListenPort(bool val) override { record(QString("listen ") + (val ? "on" : "off")); }
+    void enableHttpResponse(bool val) override { record(QString("respond ") + (val ? "on" : "off")); }
+    void enableResponseDelay(bool val) override { record(QString("delay ") + (val ? "on" : "off")); }
+    void setReturnEmptyPage(bool val) override { record(QString("empty ") + (val ? "on" : "off")); }
+    void httpResponseTimeChanged(int) override {}
+    void delayDistributionChanged(const QString& spec) override { record("distribution " + spec); }
+    void returnCodeChanged(int val) override { record("code " + QString::number(val)); }
+    void cacheValidationChanged(const QString& mode) override { record("cache " + mode); }
+    void newWebPageSelected(const QString& path) override { record("page " + path); }
+    void newSiteDirectorySelected(const QString&) override {}
+    void serverErrorHasOccurred(const QString&) override {}
+    void reset() override { record("reset"); }
+
+    QStringList calls;
+
+private:
+    void record(const QString& call) { calls.append(call); }
+};
+
+class TestScenarioEngine: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parseTimes();
+    void parseErrors_data();
+    void parseErrors();
+    void runsInOrder();
+    void keepsSchedule();
+    void stopCancels();
+    void executeCommand();
+};
+
+void TestScenarioEngine::parseTimes()
+{
+    MockPresenter presenter;
+    ScenarioEngine engine(&presenter);
+    QString error;
+    QVERIFY(engine.parse("# incident\n"
+                         "30s respond off   # outage\n"
+                         "+45s code 503\n"
+                         "+2m  code 200\n"
+                         "+0   respond on\n"
+                         "\n"
+                         "1500ms\tlisten off\n"
+                         "1h stop\n", &error));
+
+    const QList<ScenarioEngine::Step>& steps = engine.steps();
+    QCOMPARE(steps.size(), 6);
+    // Sorted by time, the absolute 1500ms step comes first
+    QCOMPARE(steps.at(0).atMs, qint64(1500));
+    QCOMPARE(steps.at(0).action, QString("listen"));
+    QCOMPARE(steps.at(1).atMs, qint64(30000));
+    QCOMPARE(steps.at(2).atMs, qint64(75000));
+    QCOMPARE(steps.at(2).argument, QString("503"));
+    QCOMPARE(steps.at(3).atMs, qint64(195000));
+    QCOMPARE(steps.at(4).atMs, qint64(195000));
+    QCOMPARE(steps.at(4).action, QString("respond"));
+    QCOMPARE(steps.at(5).atMs, qint64(3600000));
+    QCOMPARE(steps.at(5).line, 8);
+}
+
+void TestScenarioEngine::parseErrors_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("message");
+
+    QTest::newRow("bad time") << "soon respond off" << "Line 1: invalid time";
+    QTest::newRow("negative") << "-5s respond off" << "Line 1: invalid time";
+    QTest::newRow("missing time") << "1s code 200\nexplode" << "Line 2: invalid time";
+    QTest::newRow("missing action") << "1s" << "Line 1: unknown action";
+    QTest::newRow("unknown action with time") << "1s explode" << "Line 1: unknown action";
+    QTest::newRow("on off") << "1s respond maybe" << "Line 1: \"respond\" expects on or off";
+    QTest::newRow("code range") << "1s code 42" << "Line 1: \"code\" expects a number";
+    QTest::newRow("extra argument") << "1s start now" << "Line 1: \"start\" takes no argument";
+    QTest::newRow("endpoint") << "1s endpoint api" << "Line 1: \"endpoint\" expects a path";
+    QTest::newRow("distribution") << "1s delay uniform:min=20,max=10" << "Line 1: Uniform delay needs";
+    QTest::newRow("unknown distribution") << "1s delay sometimes" << "Line 1: Unknown delay distribution";
+    QTest::newRow("missing page") << "1s page /nonexistent/page.html" << "Line 1: \"page\" file not found";
+}
+
+void TestScenarioEngine::parseErrors()
+{
+    QFETCH(QString, text);
+    QFETCH(QString, message);
+
+    MockPresenter presenter;
+    ScenarioEngine engine(&presenter);
+    QString error;
+    QVERIFY(!engine.parse(text, &error));
+    QVERIFY2(error.startsWith(message), qPrintable(error));
+}
+
+void TestScenarioEngine::runsInOrder()
+{
+    MockPresenter presenter;
+    ScenarioEngine engine(&presenter);
+    QString error;
+    QVERIFY(engine.parse("0 respond off\n"
+                         "+20ms code 503\n"
+                         "+20ms delay lognormal:mu=4,sigma=0.5\n"
+                         "+0 delay off\n"
+                         "+20ms cache unchanged\n"
+                         "+0 reset\n", &error));
+
+    QSignalSpy finished(&engine, &ScenarioEngine::finished);
+    engine.start();
+    QVERIFY(engine.isRunning());
+    QTRY_COMPARE_WITH_TIMEOUT(finished.size(), 1, 2000);
+    QVERIFY(!engine.isRunning());
+    QCOMPARE(presenter.calls, QStringList({"respond off", "code 503", "distribution lognormal:mu=4,sigma=0.5",
+                                           "delay on", "delay off", "cache unchanged", "reset"}));
+}
+
+void TestScenarioEngine::keepsSchedule()
+{
+    MockPresenter presenter;
+    ScenarioEngine engine(&presenter);
+    QString error;
+    QVERIFY(engine.parse("50ms code 500\n100ms code 501\n150ms code 502\n", &error));
+
+    QSignalSpy executed(&engine, &ScenarioEngine::stepExecuted);
+    engine.start();
+    QTRY_COMPARE_WITH_TIMEOUT(executed.size(), 3, 2000);
+    for (const QList<QVariant>& step : std::as_const(executed)) {
+        double lateMs = step.at(1).toDouble();
+        QVERIFY(lateMs >= 0);
+        // The spin keeps an idle loop well within a millisecond, a loaded
+        // test machine gets some slack
+        QVERIFY2(lateMs < 5, qPrintable(QString::number(lateMs)));
+    }
+}
+
+void TestScenarioEngine::stopCancels()
+{
+    MockPresenter presenter;
+    ScenarioEngine engine(&presenter);
+    QString error;
+    QVERIFY(engine.parse("0 stop\n100ms start\n", &error));
+
+    engine.start();
+    QTRY_COMPARE_WITH_TIMEOUT(presenter.calls.size(), 1, 1000);
+    engine.stop();
+    QTest::qWait(200);
+    QCOMPARE(presenter.calls, QStringList({"stop"}));
+}
+
+void TestScenarioEngine::executeCommand()
+{
+    MockPresenter presenter;
+    QString error;
+    QVERIFY(ScenarioEngine::execute("  CODE   503 ", &presenter, &error));
+    QVERIFY(ScenarioEngine::execute("delay uniform:min=10,max=20", &presenter, &error));
+    QCOMPARE(presenter.calls, QStringList({"code 503", "distribution uniform:min=10,max=20", "delay on"}));
+
+    QVERIFY(!ScenarioEngine::execute("", &presenter, &error));
+    QCOMPARE(error, QString("missing action"));
+    QVERIFY(!ScenarioEngine::execute("listen maybe", &presenter, &error));
+    QCOMPARE(error, QString("\"listen\" expects on or off"));
+    // Checked without a target
+    QVERIFY(ScenarioEngine::execute("port 8080", nullptr, &error));
+    QCOMPARE(presenter.calls.size(), 3);
+}
+
+QTEST_MAIN(TestScenarioEngine)
+#include "scenarioengine_test.moc"
@@ -0,0 +1,66 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include "../src/core/web/sizeutils.h"
+
+class TestSizeUtils: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parseSize_data();
+    void parseSize();
+};
+
+void TestSizeUtils::parseSize_data()
+{
+    QTest::addColumn<QString>("str");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<qint64>("size");
+
+    QTest::newRow("bytes") << "1000" << true << qint64(1000);
+    QTest::newRow("zero") << "0" << true << qint64(0);
+    QTest::newRow("kilo") << "4k" << true << qint64(4096);
+    QTest::newRow("mega") << "2M" << true << qint64(2 * 1024 * 1024);
+    QTest::newRow("giga") << "10G" << true << qint64(10) * 1024 * 1024 * 1024;
+    QTest::newRow("lower case") << "1g" << true << qint64(1024) * 1024 * 1024;
+    QTest::newRow("empty") << "" << false << qint64(0);
+    QTest::newRow("negative") << "-1" << false << qint64(0);
+    QTest::newRow("unit only") << "k" << false << qint64(0);
+    QTest::newRow("too large") << "99999999G" << false << qint64(0);
+    QTest::newRow("garbage") << "ten" << false << qint64(0);
+}
+
+void TestSizeUtils::parseSize()
+{
+    QFETCH(QString, str);
+    QFETCH(bool, valid);
+    QFETCH(qint64, size);
+
+    qint64 res = 0;
+    QCOMPARE(SizeUtils::parseSize(str, &res), valid);
+    QCOMPARE(res, size);
+}
+
+QTEST_MAIN(TestSizeUtils)
+#include "sizeutils_test.moc"
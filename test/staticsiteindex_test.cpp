@@ -0,0 +1,168 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "../src/core/web/staticsiteindex.h"
+
+class TestStaticSiteIndex: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void metadata();
+    void directoryIndex();
+    void missingRoot();
+    void skipsHiddenFiles();
+    void openKeepsDescriptor();
+    void scan_data();
+    void scan();
+
+private:
+    static void writeFile(const QString& fileName, const QByteArray& data);
+
+    QTemporaryDir root;
+};
+
+void TestStaticSiteIndex::writeFile(const QString &fileName, const QByteArray &data)
+{
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QVERIFY(file.write(data) == data.size());
+}
+
+void TestStaticSiteIndex::initTestCase()
+{
+    writeFile(root.filePath("index.html"), "<p>home</p>");
+    writeFile(root.filePath("docs/index.html"), "<p>docs</p>");
+    writeFile(root.filePath("docs/api/users.json"), "[]");
+    writeFile(root.filePath("img/logo.png"), QByteArray(100, '\x89'));
+}
+
+void TestStaticSiteIndex::metadata()
+{
+    QString error;
+    auto index = StaticSiteIndex::build(root.path(), &error);
+    QVERIFY2(index, qPrintable(error));
+    QCOMPARE(index->size(), 4);
+
+    const StaticFile* file = index->find("docs/api/users.json");
+    QVERIFY(file);
+    QCOMPARE(file->size, qint64(2));
+    QCOMPARE(file->contentType, QByteArray("application/json"));
+    QVERIFY(file->etag.startsWith("\"2-"));
+    QVERIFY(file->headers.contains("Content-Length: 2\r\n"));
+    QVERIFY(file->headers.contains("Last-Modified: "));
+
+    QCOMPARE(index->find("img/logo.png")->contentType, QByteArray("image/png"));
+    QVERIFY(!index->find("img/missing.png"));
+    QVERIFY(!index->find("../index.html"));
+}
+
+void TestStaticSiteIndex::directoryIndex()
+{
+    QString error;
+    auto index = StaticSiteIndex::build(root.path(), &error);
+    QVERIFY(index);
+    QCOMPARE(index->find("")->filePath, root.filePath("index.html"));
+    QCOMPARE(index->find("docs/")->filePath, root.filePath("docs/index.html"));
+    QVERIFY(!index->find("img/"));
+}
+
+void TestStaticSiteIndex::missingRoot()
+{
+    QString error;
+    QVERIFY(!StaticSiteIndex::build("/nonexistent/site", &error));
+    QVERIFY(!error.isEmpty());
+}
+
+void TestStaticSiteIndex::skipsHiddenFiles()
+{
+    QTemporaryDir dir;
+    writeFile(dir.filePath("index.html"), "<p>home</p>");
+    writeFile(dir.filePath(".env"), "SECRET=1");
+    writeFile(dir.filePath(".git/config"), "[core]");
+    writeFile(dir.filePath("docs/.htpasswd"), "user:hash");
+
+    QString error;
+    auto index = StaticSiteIndex::build(dir.path(), &error);
+    QVERIFY2(index, qPrintable(error));
+    QCOMPARE(index->size(), 1);
+    QVERIFY(!index->find(".env"));
+    QVERIFY(!index->find(".git/config"));
+    QVERIFY(!index->find("docs/.htpasswd"));
+}
+
+void TestStaticSiteIndex::openKeepsDescriptor()
+{
+    QTemporaryDir dir;
+    writeFile(dir.filePath("data.bin"), QByteArray(1000, 'd'));
+    QString error;
+    auto index = StaticSiteIndex::build(dir.path(), &error);
+    QVERIFY(index);
+    const StaticFile* file = index->find("data.bin");
+
+    std::shared_ptr<const PageData> page = index->open(*file, &error);
+    QVERIFY2(page, qPrintable(error));
+    QVERIFY(page->isLive());
+    QVERIFY(page->fileHandle() != -1);
+    QCOMPARE(page->read(990, 100), QByteArray(10, 'd'));
+    // Later requests get the same open file
+    QCOMPARE(index->open(*file, &error), page);
+    QCOMPARE(index->openFileCount(), 1);
+
+    // A file cut short reads short, it is never mapped
+    QFile::resize(file->filePath, 500);
+    QCOMPARE(page->size(), qint64(1000));
+    QCOMPARE(page->read(0, 1000).size(), 500);
+    QVERIFY(page->read(600, 100).isEmpty());
+}
+
+void TestStaticSiteIndex::scan_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("1000 files") << 1000;
+    QTest::newRow("10000 files") << 10000;
+}
+
+void TestStaticSiteIndex::scan()
+{
+    QFETCH(int, count);
+    QTemporaryDir dir;
+    for (int i = 0; i < count; ++i) {
+        writeFile(dir.filePath(QString("d%1/f%2.html").arg(i % 100).arg(i)), "x");
+    }
+
+    std::shared_ptr<const StaticSiteIndex> index;
+    QString error;
+    QBENCHMARK {
+        index = StaticSiteIndex::build(dir.path(), &error);
+    }
+    QCOMPARE(index->size(), count);
+    QVERIFY(index->find(QString("d%1/f%2.html").arg((count - 1) % 100).arg(count - 1)));
+}
+
+QTEST_MAIN(TestStaticSiteIndex)
+
+#include "staticsiteindex_test.moc"
@@ -0,0 +1,144 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QJsonDocument>
+
+#include "../src/core/web/syntheticpayload.h"
+
+class TestSyntheticPayload: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parse();
+    void slices_data();
+    void slices();
+    void json();
+    void randomSeed();
+
+private:
+    static QByteArray body(const SyntheticPayload& payload, qint64 size);
+};
+
+void TestSyntheticPayload::parse()
+{
+    QString error;
+    auto payload = SyntheticPayload::parse("random:size=10G,seed=7", &error);
+    QVERIFY(payload);
+    QCOMPARE(payload->pattern(), SyntheticPayload::Pattern::Random);
+    QCOMPARE(payload->size(), qint64(10) * 1024 * 1024 * 1024);
+    QCOMPARE(payload->contentType(), QByteArray("application/octet-stream"));
+    QCOMPARE(payload->toString(), QString("random:size=10737418240,seed=7"));
+
+    payload = SyntheticPayload::parse(" JSON : size = 1k ", &error);
+    QVERIFY(payload);
+    QCOMPARE(payload->pattern(), SyntheticPayload::Pattern::Json);
+    QCOMPARE(payload->size(), qint64(1024));
+    QCOMPARE(payload->contentType(), QByteArray("application/json"));
+
+    QVERIFY(!SyntheticPayload::parse("zeros", &error));
+    QVERIFY(error.contains("size"));
+    QVERIFY(!SyntheticPayload::parse("noise:size=10", &error));
+    QVERIFY(error.contains("noise"));
+    QVERIFY(!SyntheticPayload::parse("random:size=10,seed=x", &error));
+    QVERIFY(error.contains("seed"));
+}
+
+void TestSyntheticPayload::slices_data()
+{
+    QTest::addColumn<QString>("spec");
+    QTest::addColumn<qint64>("size");
+
+    QTest::newRow("zeros") << "zeros:size=0" << qint64(200000);
+    QTest::newRow("text") << "text:size=0" << qint64(200000);
+    QTest::newRow("random") << "random:size=0" << qint64(3 * 1024 * 1024 + 5);
+    QTest::newRow("json") << "json:size=0" << qint64(200000);
+}
+
+void TestSyntheticPayload::slices()
+{
+    QFETCH(QString, spec);
+    QFETCH(qint64, size);
+
+    QString error;
+    auto payload = SyntheticPayload::parse(spec, &error);
+    QVERIFY(payload);
+
+    // Any chunk size tiles the same body
+    QByteArray whole = body(*payload, size);
+    QCOMPARE(whole.size(), size);
+    QByteArray chunked;
+    for (qint64 offset = 0; offset < size; ) {
+        QByteArray data = payload->slice(size, offset, 1000);
+        QVERIFY(!data.isEmpty());
+        QVERIFY(data.size() <= 1000);
+        chunked.append(data);
+        offset += data.size();
+    }
+    QCOMPARE(chunked, whole);
+    QVERIFY(payload->slice(size, size, 1000).isEmpty());
+}
+
+void TestSyntheticPayload::json()
+{
+    QString error;
+    auto payload = SyntheticPayload::parse("json:size=0", &error);
+    QVERIFY(payload);
+
+    const qint64 sizes[] = {2, 5, 12, 13, 14, 100, 70000, 300000};
+    for (qint64 size : sizes) {
+        QByteArray data = body(*payload, size);
+        QCOMPARE(data.size(), size);
+        QJsonParseError parseError;
+        QJsonDocument::fromJson(data, &parseError);
+        QVERIFY2(parseError.error == QJsonParseError::NoError, qPrintable(QString::number(size)));
+    }
+    QCOMPARE(body(*payload, 5), QByteArray("[]   "));
+    QVERIFY(body(*payload, 13).startsWith("{\"filler\":\""));
+    QCOMPARE(body(*payload, 1), QByteArray("0"));
+}
+
+void TestSyntheticPayload::randomSeed()
+{
+    QString error;
+    auto first = SyntheticPayload::parse("random:size=0,seed=7", &error);
+    auto same = SyntheticPayload::parse("random:size=0,seed=7", &error);
+    auto other = SyntheticPayload::parse("random:size=0,seed=8", &error);
+
+    QCOMPARE(body(*first, 4096), body(*same, 4096));
+    QVERIFY(body(*first, 4096) != body(*other, 4096));
+}
+
+QByteArray TestSyntheticPayload::body(const SyntheticPayload &payload, qint64 size)
+{
+    QByteArray res;
+    res.reserve(size);
+    for (qint64 offset = 0; offset < size; ) {
+        QByteArray data = payload.slice(size, offset, size);
+        res.append(data);
+        offset += data.size();
+    }
+    return res;
+}
+
+QTEST_MAIN(TestSyntheticPayload)
+#include "syntheticpayload_test.moc"
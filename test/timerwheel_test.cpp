@@ -0,0 +1,95 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include "../src/core/web/timerwheel.h"
+
+class TestTimerWheel: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void firesInDeadlineOrder();
+    void neverFiresEarly();
+    void longDelayWrapsWheel();
+    void clearDropsPending();
+};
+
+void TestTimerWheel::firesInDeadlineOrder()
+{
+    TimerWheel wheel;
+    QList<int> fired;
+
+    wheel.schedule(300, [&]() { fired.append(300); });
+    wheel.schedule(10, [&]() { fired.append(10); });
+    wheel.schedule(150, [&]() { fired.append(150); });
+    QCOMPARE(wheel.pendingCount(), 3);
+
+    QTRY_COMPARE_WITH_TIMEOUT(fired.size(), 3, 2000);
+    QCOMPARE(fired, QList<int>({10, 150, 300}));
+    QCOMPARE(wheel.pendingCount(), 0);
+}
+
+void TestTimerWheel::neverFiresEarly()
+{
+    TimerWheel wheel;
+    QElapsedTimer clock;
+    qint64 firedAt = -1;
+
+    clock.start();
+    wheel.schedule(50, [&]() { firedAt = clock.elapsed(); });
+
+    QTRY_VERIFY_WITH_TIMEOUT(firedAt >= 0, 1000);
+    QVERIFY(firedAt >= 50);
+}
+
+void TestTimerWheel::longDelayWrapsWheel()
+{
+    TimerWheel wheel(nullptr, 1, 16);
+    QList<int> fired;
+
+    wheel.schedule(70, [&]() { fired.append(70); });
+    wheel.schedule(5, [&]() { fired.append(5); });
+    wheel.schedule(21, [&]() { fired.append(21); });
+
+    QTRY_COMPARE_WITH_TIMEOUT(fired.size(), 3, 1000);
+    QCOMPARE(fired, QList<int>({5, 21, 70}));
+}
+
+void TestTimerWheel::clearDropsPending()
+{
+    TimerWheel wheel;
+    int fired = 0;
+
+    for (int i = 0; i < 1000; ++i) {
+        wheel.schedule(20, [&]() { ++fired; });
+    }
+    QCOMPARE(wheel.pendingCount(), 1000);
+
+    wheel.clear();
+    QCOMPARE(wheel.pendingCount(), 0);
+    QTest::qWait(100);
+    QCOMPARE(fired, 0);
+}
+
+QTEST_MAIN(TestTimerWheel)
+#include "timerwheel_test.moc"
@@ -0,0 +1,151 @@
+/*
+ * SPDX-License-Identifier: GPL-3.0-only
+ *
+ * This file is part of WebMonDiag.
+ *
+ * Copyright (C) 2024, Ewgeny Repin <erpndev@gmail.com>
+ *
+ * WebMonDiag is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WebMonDiag is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WebMonDiag.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "../src/core/web/webpageloader.h"
+
+class TestWebPageLoader: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void missingPage();
+    void loadsOffThread();
+    void failedLoad();
+    void reloadOnWrite();
+    void reloadOnReplace();
+
+private:
+    static void writeFile(const QString& fileName, const QByteArray& data);
+};
+
+void TestWebPageLoader::writeFile(const QString &fileName, const QByteArray &data)
+{
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QVERIFY(file.write(data) == data.size());
+}
+
+void TestWebPageLoader::missingPage()
+{
+    WebPageLoader loader;
+    std::shared_ptr<const PageData> page = loader.load("/nonexistent/page.html");
+    QVERIFY(page);
+    QVERIFY(page->bytes().contains("not found"));
+}
+
+void TestWebPageLoader::loadsOffThread()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("page.html");
+    writeFile(fileName, "<p>loaded</p>");
+
+    WebPageLoader loader;
+    QSignalSpy loaded(&loader, &WebPageLoader::pageLoaded);
+    QSignalSpy reloaded(&loader, &WebPageLoader::pageReloaded);
+    // Nothing is copied in the caller's thread
+    QVERIFY(!loader.load(fileName));
+    QCOMPARE(loaded.size(), 0);
+    QTRY_COMPARE_WITH_TIMEOUT(loaded.size(), 1, 5000);
+    auto page = loaded.at(0).at(0).value<std::shared_ptr<const PageData>>();
+    QCOMPARE(page->bytes(), QByteArray("<p>loaded</p>"));
+    QCOMPARE(page->modified(), QFileInfo(fileName).lastModified().toUTC());
+    QCOMPARE(reloaded.size(), 0);
+}
+
+void TestWebPageLoader::failedLoad()
+{
+    QTemporaryDir dir;
+    WebPageLoader loader;
+    QSignalSpy loaded(&loader, &WebPageLoader::pageLoaded);
+    QSignalSpy failed(&loader, &WebPageLoader::loadFailed);
+    // A directory exists but cannot be read as a page
+    QVERIFY(!loader.load(dir.path()));
+    QTRY_COMPARE_WITH_TIMEOUT(failed.size(), 1, 5000);
+    QVERIFY(failed.at(0).at(0).toString().startsWith("Cannot open page"));
+    QCOMPARE(loaded.size(), 0);
+}
+
+void TestWebPageLoader::reloadOnWrite()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("page.bin");
+    writeFile(fileName, QByteArray("\x00\x01\xff", 3));
+
+    WebPageLoader loader;
+    std::shared_ptr<const PageData> first;
+    std::shared_ptr<const PageData> reloaded;
+    connect(&loader, &WebPageLoader::pageLoaded, this, [&](const std::shared_ptr<const PageData>& page) {
+        first = page;
+    });
+    connect(&loader, &WebPageLoader::pageReloaded, this, [&](const std::shared_ptr<const PageData>& page) {
+        reloaded = page;
+    });
+    loader.load(fileName);
+    QTRY_VERIFY_WITH_TIMEOUT(first, 5000);
+    QCOMPARE(first->bytes(), QByteArray("\x00\x01\xff", 3));
+
+    writeFile(fileName, "second version");
+    QTRY_VERIFY_WITH_TIMEOUT(reloaded, 5000);
+    QCOMPARE(reloaded->bytes(), QByteArray("second version"));
+
+    // Pages handed out earlier keep their bytes
+    QCOMPARE(first->bytes(), QByteArray("\x00\x01\xff", 3));
+}
+
+void TestWebPageLoader::reloadOnReplace()
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("page.html");
+    writeFile(fileName, "<p>first</p>");
+
+    WebPageLoader loader;
+    std::shared_ptr<const PageData> first;
+    std::shared_ptr<const PageData> reloaded;
+    connect(&loader, &WebPageLoader::pageLoaded, this, [&](const std::shared_ptr<const PageData>& page) {
+        first = page;
+    });
+    connect(&loader, &WebPageLoader::pageReloaded, this, [&](const std::shared_ptr<const PageData>& page) {
+        reloaded = page;
+    });
+    loader.load(fileName);
+    QTRY_VERIFY_WITH_TIMEOUT(first, 5000);
+    QCOMPARE(first->bytes(), QByteArray("<p>first</p>"));
+
+    // Save the way editors do: write a new file and rename it over the old one
+    QString newFileName = dir.filePath("page.html.new");
+    writeFile(newFileName, "<p>replaced page</p>");
+    QVERIFY(QFile::remove(fileName));
+    QVERIFY(QFile::rename(newFileName, fileName));
+
+    QTRY_VERIFY_WITH_TIMEOUT(reloaded && reloaded->bytes() == "<p>replaced page</p>", 5000);
+
+    // The new file is watched again
+    reloaded.reset();
+    writeFile(fileName, "<p>edited again</p>");
+    QTRY_VERIFY_WITH_TIMEOUT(reloaded && reloaded->bytes() == "<p>edited again</p>", 5000);
+}
+
+QTEST_MAIN(TestWebPageLoader)
+
+#include "webpageloader_test.moc"